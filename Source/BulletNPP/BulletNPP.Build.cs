@@ -1,13 +1,41 @@
 ﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
+using System;
 using UnrealBuildTool;
 
 public class BulletNPP : ModuleRules
 {
+	// Shows bullet's BT_PROFILE zones and per step counters in Unreal Insights. On everywhere but shipping,
+	// set BULLET_INSIGHTS=1 (or 0) in the environment to force it either way
+	private bool UseBulletInsights(ReadOnlyTargetRules Target)
+	{
+		string Override = System.Environment.GetEnvironmentVariable("BULLET_INSIGHTS");
+		if (!String.IsNullOrEmpty(Override))
+		{
+			return Override != "0";
+		}
+		return Target.Configuration != UnrealTargetConfiguration.Shipping;
+	}
+
+	// Sends bullet's allocations through FMemory under their own LLM tag. Set BULLET_UE_ALLOCATOR=0 in the environment
+	// to leave bullet on the system malloc, e.g. for a sanitizer build
+	private bool UseUnrealAllocator()
+	{
+		string Override = System.Environment.GetEnvironmentVariable("BULLET_UE_ALLOCATOR");
+		if (!String.IsNullOrEmpty(Override))
+		{
+			return Override != "0";
+		}
+		return true;
+	}
+
 	public BulletNPP(ReadOnlyTargetRules Target) : base(Target)
 	{
 		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
 		
+		PrivateDefinitions.Add("WITH_BULLET_INSIGHTS=" + (UseBulletInsights(Target) ? "1" : "0"));
+		PrivateDefinitions.Add("WITH_BULLET_UE_ALLOCATOR=" + (UseUnrealAllocator() ? "1" : "0"));
+		
 		PublicIncludePaths.AddRange(
 			new string[] {
 				// ... add public include paths required here ...
@@ -30,6 +58,7 @@ public class BulletNPP : ModuleRules
 				"NetworkPrediction",
 				"GameplayTags",
 				"BulletPhysicsEngineLibrary",
+				"Chaos",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -40,10 +69,12 @@ public class BulletNPP : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"DeveloperSettings",
 				"Slate",
 				"SlateCore",
 				"BulletNativeTags",
-				"GameplayTags"
+				"GameplayTags",
+				"Landscape"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -1,6 +1,9 @@
 ﻿// Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "BulletNPP.h"
+#include "Core/Simulation/BulletMemory.h"
+#include "Core/Simulation/BulletProfiler.h"
+#include "Core/Simulation/BulletTaskScheduler.h"
 
 #define LOCTEXT_NAMESPACE "FBulletNPPModule"
 
@@ -19,12 +22,18 @@ namespace BulletPhysicsEngine
 void FBulletNPPModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	// Before anything of bullet's is allocated, every block has to be freed by the allocator it came from
+	FBulletMemory::Install();
+	FBulletProfiler::Install();
 }
 
 void FBulletNPPModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FBulletTaskScheduler::Shutdown();
+	FBulletProfiler::Uninstall();
+	FBulletMemory::Uninstall();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,286 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/DataTypes/BulletCookedConvexHulls.h"
+#include "BulletMain.h"
+#include "BulletLogChannels.h"
+#include "Core/Libraries/BulletMathLibrary.h"
+#include "Engine/StaticMesh.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "UObject/ObjectSaveContext.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "BulletCollision/CollisionShapes/btConvexPolyhedron.h"
+#if WITH_BULLET_VHACD
+#include "VHACD.h"
+#endif
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BulletCookedConvexHulls)
+
+btConvexHullShape* UBulletCookedConvexHulls::CreateHullShape(int32 HullIndex, const FVector& Scale) const
+{
+	const FBulletCookedHull& Hull = Hulls[HullIndex];
+	const btVector3 HullScale(Scale.X, Scale.Y, Scale.Z);
+
+	btConvexHullShape* Shape = new btConvexHullShape();
+	btConvexPolyhedron Polyhedron;
+	Polyhedron.m_vertices.resize(Hull.Vertices.Num());
+	for (int32 i = 0; i < Hull.Vertices.Num(); ++i)
+	{
+		const btVector3 Vertex = btVector3(Hull.Vertices[i].X, Hull.Vertices[i].Y, Hull.Vertices[i].Z) * HullScale;
+		Polyhedron.m_vertices[i] = Vertex;
+		// One bounds update at the end rather than one per point
+		Shape->addPoint(Vertex, false);
+	}
+	Shape->recalcLocalAabb();
+	// Same as the hand authored hulls, no margin so there's no gap around them
+	Shape->setMargin(0);
+
+	// Normals scale by the inverse of the scale, the plane constant then follows from any vertex on the face
+	const btVector3 NormalScale(Scale.X != 0 ? 1 / Scale.X : 0, Scale.Y != 0 ? 1 / Scale.Y : 0, Scale.Z != 0 ? 1 / Scale.Z : 0);
+	Polyhedron.m_faces.resize(Hull.FaceSizes.Num());
+	int32 FaceStart = 0;
+	for (int32 f = 0; f < Hull.FaceSizes.Num(); ++f)
+	{
+		btFace& Face = Polyhedron.m_faces[f];
+		Face.m_indices.resize(Hull.FaceSizes[f]);
+		for (int32 i = 0; i < Hull.FaceSizes[f]; ++i)
+		{
+			Face.m_indices[i] = Hull.FaceIndices[FaceStart + i];
+		}
+		FaceStart += Hull.FaceSizes[f];
+
+		const FVector4f& Plane = Hull.FacePlanes[f];
+		const btVector3 Normal = (btVector3(Plane.X, Plane.Y, Plane.Z) * NormalScale).safeNormalize();
+		Face.m_plane[0] = Normal.x();
+		Face.m_plane[1] = Normal.y();
+		Face.m_plane[2] = Normal.z();
+		Face.m_plane[3] = -Normal.dot(Polyhedron.m_vertices[Face.m_indices[0]]);
+	}
+
+	// Only edges and bounds are left to work out, the hull and face merging were done when cooking
+	Polyhedron.initialize();
+	Shape->setPolyhedralFeatures(Polyhedron);
+	return Shape;
+}
+
+#if WITH_EDITOR
+#if WITH_BULLET_VHACD
+namespace
+{
+	/**
+	 * Keeps at most MaxVertices of Hull's points (Hull must have at least 4). Starts from the largest tetrahedron it can find, then keeps adding
+	 * whichever point lies furthest outside the hull of those kept so far, so the budget goes where it adds the most volume.
+	 */
+	void ReduceHullVertices(const btConvexHullShape& Hull, int32 MaxVertices, btConvexHullShape& OutShape)
+	{
+		const int32 NumPoints = Hull.getNumPoints();
+		const btVector3* Points = Hull.getUnscaledPoints();
+		TArray<bool> Kept;
+		Kept.Init(false, NumPoints);
+
+		auto Keep = [&Kept, &OutShape, Points](int32 Index)
+		{
+			Kept[Index] = true;
+			OutShape.addPoint(Points[Index], false);
+		};
+		auto FindBest = [&Kept, Points, NumPoints](auto&& Score)
+		{
+			int32 Best = INDEX_NONE;
+			btScalar BestScore = 0;
+			for (int32 i = 0; i < NumPoints; ++i)
+			{
+				if (Kept[i]) continue;
+				const btScalar PointScore = Score(Points[i]);
+				if (Best == INDEX_NONE || PointScore > BestScore)
+				{
+					Best = i;
+					BestScore = PointScore;
+				}
+			}
+			return Best;
+		};
+
+		btVector3 Centroid(0, 0, 0);
+		for (int32 i = 0; i < NumPoints; ++i)
+		{
+			Centroid += Points[i];
+		}
+		Centroid /= btScalar(NumPoints);
+
+		const int32 First = FindBest([&Centroid](const btVector3& Point) { return Point.distance2(Centroid); });
+		Keep(First);
+		const btVector3& Origin = Points[First];
+		const int32 Second = FindBest([&Origin](const btVector3& Point) { return Point.distance2(Origin); });
+		Keep(Second);
+		const btVector3 Axis = Points[Second] - Origin;
+		const int32 Third = FindBest([&Origin, &Axis](const btVector3& Point) { return (Point - Origin).cross(Axis).length2(); });
+		Keep(Third);
+		const btVector3 Normal = Axis.cross(Points[Third] - Origin);
+		Keep(FindBest([&Origin, &Normal](const btVector3& Point) { return btFabs((Point - Origin).dot(Normal)); }));
+
+		for (int32 NumKept = 4; NumKept < MaxVertices; ++NumKept)
+		{
+			const btConvexPolyhedron* Polyhedron = OutShape.initializePolyhedralFeatures() ? OutShape.getConvexPolyhedron() : nullptr;
+			if (!Polyhedron || Polyhedron->m_faces.size() == 0)
+			{
+				break;
+			}
+
+			// How far outside the kept hull a point is, the largest distance in front of any of its faces
+			auto OutsideDistance = [Polyhedron](const btVector3& Point)
+			{
+				btScalar Distance = -BT_LARGE_FLOAT;
+				for (int32 f = 0; f < Polyhedron->m_faces.size(); ++f)
+				{
+					const btScalar* Plane = Polyhedron->m_faces[f].m_plane;
+					Distance = btMax(Distance, btVector3(Plane[0], Plane[1], Plane[2]).dot(Point) + Plane[3]);
+				}
+				return Distance;
+			};
+
+			// Everything left is inside already, to within a hundredth of a millimetre
+			const int32 Best = FindBest(OutsideDistance);
+			if (Best == INDEX_NONE || OutsideDistance(Points[Best]) <= btScalar(1e-5))
+			{
+				break;
+			}
+			Keep(Best);
+		}
+
+		OutShape.recalcLocalAabb();
+		OutShape.setMargin(0);
+	}
+}
+#endif
+
+void UBulletCookedConvexHulls::Cook(UStaticMesh* Mesh)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletCookConvexHulls);
+
+	// The same triangles Chaos cooks its complex collision from
+	FTriMeshCollisionData MeshData;
+	if (!Mesh || !Mesh->ContainsPhysicsTriMeshData(true) || !Mesh->GetPhysicsTriMeshData(&MeshData, true) || MeshData.Indices.Num() == 0)
+	{
+		Hulls.Reset();
+		SourceHash = 0;
+		return;
+	}
+
+	// Decomposing can take seconds, so don't redo it when neither the triangles nor the settings changed
+	uint32 Hash = FCrc::MemCrc32(MeshData.Vertices.GetData(), MeshData.Vertices.Num() * MeshData.Vertices.GetTypeSize());
+	Hash = FCrc::MemCrc32(MeshData.Indices.GetData(), MeshData.Indices.Num() * MeshData.Indices.GetTypeSize(), Hash);
+	Hash = HashCombineFast(Hash, HashCombineFast(GetTypeHash(Resolution), HashCombineFast(GetTypeHash(Concavity), GetTypeHash(MaxHullVertices))));
+	if (Hash == SourceHash && Hulls.Num() > 0)
+	{
+		return;
+	}
+
+#if WITH_BULLET_VHACD
+	Hulls.Reset();
+	SourceHash = Hash;
+
+	TArray<float> Points;
+	Points.Reserve(MeshData.Vertices.Num() * 3);
+	for (const FVector3f& Vertex : MeshData.Vertices)
+	{
+		Points.Add(Vertex.X * WORLD_TO_BULLET_SCALE);
+		Points.Add(Vertex.Y * WORLD_TO_BULLET_SCALE);
+		Points.Add(Vertex.Z * WORLD_TO_BULLET_SCALE);
+	}
+	TArray<int32> Triangles;
+	Triangles.Reserve(MeshData.Indices.Num() * 3);
+	for (const FTriIndices& Triangle : MeshData.Indices)
+	{
+		Triangles.Add(Triangle.v0);
+		Triangles.Add(Triangle.v1);
+		Triangles.Add(Triangle.v2);
+	}
+
+	VHACD::IVHACD::Parameters Params;
+	Params.m_resolution = Resolution;
+	Params.m_concavity = Concavity;
+	Params.m_maxNumVerticesPerCH = MaxHullVertices;
+	Params.m_oclAcceleration = false;
+
+	VHACD::IVHACD* Decomposer = VHACD::CreateVHACD();
+	if (Decomposer->Compute(Points.GetData(), 3, MeshData.Vertices.Num(), Triangles.GetData(), 3, MeshData.Indices.Num(), Params))
+	{
+		for (uint32 h = 0; h < Decomposer->GetNConvexHulls(); ++h)
+		{
+			VHACD::IVHACD::ConvexHull DecomposedHull;
+			Decomposer->GetConvexHull(h, DecomposedHull);
+			if (DecomposedHull.m_nPoints < 4)
+			{
+				continue;
+			}
+
+			btConvexHullShape HullShape;
+			for (uint32 p = 0; p < DecomposedHull.m_nPoints; ++p)
+			{
+				const double* Point = DecomposedHull.m_points + p * 3;
+				HullShape.addPoint(btVector3(Point[0], Point[1], Point[2]), false);
+			}
+			HullShape.recalcLocalAabb();
+			HullShape.setMargin(0);
+
+			// VHACD only roughly sticks to its vertex budget, so whatever it leaves over is cut down to it here
+			btConvexHullShape ReducedShape;
+			btConvexHullShape* FinalShape = &HullShape;
+			if (HullShape.getNumPoints() > MaxHullVertices)
+			{
+				ReduceHullVertices(HullShape, MaxHullVertices, ReducedShape);
+				FinalShape = &ReducedShape;
+			}
+
+			if (!FinalShape->initializePolyhedralFeatures())
+			{
+				continue;
+			}
+			const btConvexPolyhedron* Polyhedron = FinalShape->getConvexPolyhedron();
+			if (Polyhedron->m_vertices.size() > MaxHullVertices)
+			{
+				UE_LOG(LogBullet, Warning, TEXT("UBulletCookedConvexHulls::Cook: %s, hull %u still has %d vertices, over the budget of %d"),
+					*Mesh->GetName(), h, Polyhedron->m_vertices.size(), MaxHullVertices);
+			}
+
+			FBulletCookedHull& Hull = Hulls.AddDefaulted_GetRef();
+			for (int32 v = 0; v < Polyhedron->m_vertices.size(); ++v)
+			{
+				const btVector3& Vertex = Polyhedron->m_vertices[v];
+				Hull.Vertices.Add(FVector3f(Vertex.x(), Vertex.y(), Vertex.z()));
+			}
+			for (int32 f = 0; f < Polyhedron->m_faces.size(); ++f)
+			{
+				const btFace& Face = Polyhedron->m_faces[f];
+				for (int32 i = 0; i < Face.m_indices.size(); ++i)
+				{
+					Hull.FaceIndices.Add(Face.m_indices[i]);
+				}
+				Hull.FaceSizes.Add(Face.m_indices.size());
+				Hull.FacePlanes.Add(FVector4f(Face.m_plane[0], Face.m_plane[1], Face.m_plane[2], Face.m_plane[3]));
+			}
+		}
+	}
+	Decomposer->Clean();
+	Decomposer->Release();
+
+	UE_LOG(LogBullet, Log, TEXT("UBulletCookedConvexHulls::Cook: %s, %d hulls"), *Mesh->GetName(), Hulls.Num());
+#else
+	UE_LOG(LogBullet, Warning, TEXT("UBulletCookedConvexHulls::Cook: %s, this build has no VHACD, keeping the hulls already cooked"), *Mesh->GetName());
+#endif
+}
+
+void UBulletCookedConvexHulls::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		Cook(Cast<UStaticMesh>(GetOuter()));
+	}
+}
+#endif
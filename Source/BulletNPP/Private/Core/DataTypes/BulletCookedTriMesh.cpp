@@ -0,0 +1,166 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/DataTypes/BulletCookedTriMesh.h"
+#include "BulletMain.h"
+#include "BulletLogChannels.h"
+#include "Core/Libraries/BulletMathLibrary.h"
+#include "Engine/StaticMesh.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "UObject/ObjectSaveContext.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h"
+#include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btOptimizedBvh.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BulletCookedTriMesh)
+
+namespace
+{
+	// Bvh buffers hold a btQuantizedBvh followed by its node arrays, which bullet wants 16 byte aligned
+	constexpr int32 BvhBufferAlignment = 16;
+
+	// Points bullet at the vertices and indices where they are, nothing is copied
+	btTriangleIndexVertexArray* CreateMeshInterface(const TArray<FVector3f>& Vertices, const TArray<int32>& Indices, const FVector3f& AabbMin, const FVector3f& AabbMax)
+	{
+		btIndexedMesh Mesh;
+		Mesh.m_numTriangles = Indices.Num() / 3;
+		Mesh.m_triangleIndexBase = reinterpret_cast<const unsigned char*>(Indices.GetData());
+		Mesh.m_triangleIndexStride = 3 * sizeof(int32);
+		Mesh.m_numVertices = Vertices.Num();
+		Mesh.m_vertexBase = reinterpret_cast<const unsigned char*>(Vertices.GetData());
+		Mesh.m_vertexStride = sizeof(FVector3f);
+		// Cooked vertices are always single precision, whatever bullet was built with
+		Mesh.m_vertexType = PHY_FLOAT;
+
+		btTriangleIndexVertexArray* MeshInterface = new btTriangleIndexVertexArray();
+		MeshInterface->addIndexedMesh(Mesh, PHY_INTEGER);
+		// Saves the shape a pass over every vertex to find its bounds
+		MeshInterface->setPremadeAabb(btVector3(AabbMin.X, AabbMin.Y, AabbMin.Z), btVector3(AabbMax.X, AabbMax.Y, AabbMax.Z));
+		return MeshInterface;
+	}
+}
+
+void FBulletCookedTriMeshShape::Release()
+{
+	// The shape doesn't own a bvh it was handed, so it has to go before the buffer the bvh lives in
+	delete Shape;
+	delete MeshInterface;
+	if (BvhBuffer)
+	{
+		btAlignedFree(BvhBuffer);
+	}
+	Shape = nullptr;
+	MeshInterface = nullptr;
+	BvhBuffer = nullptr;
+}
+
+FBulletCookedTriMeshShape UBulletCookedTriMesh::CreateShape() const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletCreateCookedTriMeshShape);
+
+	FBulletCookedTriMeshShape Result;
+	if (!IsCooked())
+	{
+		return Result;
+	}
+
+	Result.MeshInterface = CreateMeshInterface(Vertices, Indices, AabbMin, AabbMax);
+	const btVector3 BvhAabbMin(AabbMin.X, AabbMin.Y, AabbMin.Z);
+	const btVector3 BvhAabbMax(AabbMax.X, AabbMax.Y, AabbMax.Z);
+
+	const bool bLayoutMatches = BvhLayoutSize == (int32)sizeof(btQuantizedBvh) && BvhScalarSize == (int32)sizeof(btScalar);
+	if (bLayoutMatches && BvhData.Num() > 0)
+	{
+		// Deserializing in place fixes up the pointers inside the buffer, so every shape gets an aligned copy of its own rather than sharing the asset's
+		Result.BvhBuffer = btAlignedAlloc(BvhData.Num(), BvhBufferAlignment);
+		FMemory::Memcpy(Result.BvhBuffer, BvhData.GetData(), BvhData.Num());
+		if (btOptimizedBvh* Bvh = btOptimizedBvh::deSerializeInPlace(Result.BvhBuffer, BvhData.Num(), false))
+		{
+			Result.Shape = new btBvhTriangleMeshShape(Result.MeshInterface, true, BvhAabbMin, BvhAabbMax, false);
+			Result.Shape->setOptimizedBvh(Bvh);
+			return Result;
+		}
+		btAlignedFree(Result.BvhBuffer);
+		Result.BvhBuffer = nullptr;
+	}
+
+	UE_LOG(LogBullet, Warning, TEXT("UBulletCookedTriMesh::CreateShape: %s has no cooked bvh this bullet build can load, rebuilding it"), *GetPathName());
+	Result.Shape = new btBvhTriangleMeshShape(Result.MeshInterface, true, BvhAabbMin, BvhAabbMax, true);
+	return Result;
+}
+
+#if WITH_EDITOR
+void UBulletCookedTriMesh::Cook(UStaticMesh* Mesh)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletCookTriMesh);
+
+	Vertices.Reset();
+	Indices.Reset();
+	BvhData.Reset();
+	AabbMin = AabbMax = FVector3f::ZeroVector;
+	BvhLayoutSize = 0;
+	BvhScalarSize = 0;
+
+	// The same triangles Chaos cooks its complex collision from
+	FTriMeshCollisionData MeshData;
+	if (!Mesh || !Mesh->ContainsPhysicsTriMeshData(true) || !Mesh->GetPhysicsTriMeshData(&MeshData, true) || MeshData.Indices.Num() == 0)
+	{
+		return;
+	}
+
+	Vertices.Reserve(MeshData.Vertices.Num());
+	for (const FVector3f& Vertex : MeshData.Vertices)
+	{
+		Vertices.Add(Vertex * WORLD_TO_BULLET_SCALE);
+	}
+	Indices.Reserve(MeshData.Indices.Num() * 3);
+	for (const FTriIndices& Triangle : MeshData.Indices)
+	{
+		Indices.Add(Triangle.v0);
+		Indices.Add(Triangle.v1);
+		Indices.Add(Triangle.v2);
+	}
+
+	AabbMin = FVector3f(TNumericLimits<float>::Max());
+	AabbMax = FVector3f(TNumericLimits<float>::Lowest());
+	for (const FVector3f& Vertex : Vertices)
+	{
+		AabbMin = AabbMin.ComponentMin(Vertex);
+		AabbMax = AabbMax.ComponentMax(Vertex);
+	}
+
+	btTriangleIndexVertexArray* MeshInterface = CreateMeshInterface(Vertices, Indices, AabbMin, AabbMax);
+	btOptimizedBvh Bvh;
+	Bvh.build(MeshInterface, true, btVector3(AabbMin.X, AabbMin.Y, AabbMin.Z), btVector3(AabbMax.X, AabbMax.Y, AabbMax.Z));
+
+	// serializeInPlace wants an aligned buffer as well
+	const unsigned BufferSize = Bvh.calculateSerializeBufferSize();
+	void* Buffer = btAlignedAlloc(BufferSize, BvhBufferAlignment);
+	if (Bvh.serializeInPlace(Buffer, BufferSize, false))
+	{
+		BvhData.SetNumUninitialized(BufferSize);
+		FMemory::Memcpy(BvhData.GetData(), Buffer, BufferSize);
+		BvhLayoutSize = sizeof(btQuantizedBvh);
+		BvhScalarSize = sizeof(btScalar);
+	}
+	btAlignedFree(Buffer);
+	delete MeshInterface;
+
+	UE_LOG(LogBullet, Log, TEXT("UBulletCookedTriMesh::Cook: %s, %d triangles, %d byte bvh"), *Mesh->GetName(), Indices.Num() / 3, BvhData.Num());
+}
+
+void UBulletCookedTriMesh::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		Cook(Cast<UStaticMesh>(GetOuter()));
+	}
+}
+#endif
@@ -5,6 +5,7 @@
 
 #include "BulletLogChannels.h"
 #include "Core/Libraries/BulletBasedMovementLibrary.h"
+#include "Core/Singletons/BulletPhysicsSettings.h"
 
 void FBulletDefaultInputs::SetMoveInput(EBulletMoveInputType InMoveInputType, const FVector& InMoveInput)
 {
@@ -165,11 +166,20 @@ bool FBulletDefaultSyncState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool&
 {
 	Super::NetSerialize(Ar, Map, bOutSuccess);
 
-	SerializePackedVector<100, 30>(Location, Ar);
+	const FBulletSyncStateQuantization& Quantization = UBulletPhysicsSettings::Get()->SyncStateQuantization;
+
+	BulletNetQuantization::SerializeVector(Ar, Location, Quantization.LocationPrecision);
 	SerializeFixedVector<2, 8>(MoveDirectionIntent, Ar);
-	SerializePackedVector<10, 16>(Velocity, Ar);
-	SerializePackedVector<10, 16>(AngularVelocityDegrees, Ar);
-	Orientation.SerializeCompressedShort(Ar);
+	// Both round to zero for anything at rest, which leaves just their headers
+	BulletNetQuantization::SerializeVector(Ar, Velocity, Quantization.VelocityPrecision);
+	BulletNetQuantization::SerializeVector(Ar, AngularVelocityDegrees, Quantization.AngularVelocityPrecision);
+
+	FQuat OrientationQuat = Ar.IsSaving() ? Orientation.Quaternion() : FQuat::Identity;
+	BulletNetQuantization::SerializeQuat(Ar, OrientationQuat, Quantization.OrientationBits);
+	if (Ar.IsLoading())
+	{
+		Orientation = OrientationQuat.Rotator();
+	}
 
 	// Optional movement base
 	bool bIsUsingMovementBase = (Ar.IsSaving() ? MovementBase.IsValid() : false);
@@ -180,8 +190,8 @@ bool FBulletDefaultSyncState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool&
 		Ar << MovementBase;
 		Ar << MovementBaseBoneName;
 
-		SerializePackedVector<100, 30>(MovementBasePos, Ar);
-		MovementBaseQuat.NetSerialize(Ar, Map, bOutSuccess);
+		BulletNetQuantization::SerializeVector(Ar, MovementBasePos, Quantization.LocationPrecision);
+		BulletNetQuantization::SerializeQuat(Ar, MovementBaseQuat, Quantization.OrientationBits);
 	}
 	else if (Ar.IsLoading())
 	{
@@ -218,7 +228,10 @@ void FBulletDefaultSyncState::ToString(FAnsiStringBuilderBase& Out) const
 bool FBulletDefaultSyncState::ShouldReconcile(const FBulletDataStructBase& AuthorityState) const
 {
 	const FBulletDefaultSyncState* AuthoritySyncState = static_cast<const FBulletDefaultSyncState*>(&AuthorityState);
-	const float DistErrorTolerance = 5.f;	// JAH TODO: define these elsewhere as CVars or data asset settings
+	// Never tighter than what replication rounds off, or clients would reconcile on their own rounding
+	const FBulletSyncStateQuantization& Quantization = UBulletPhysicsSettings::Get()->SyncStateQuantization;
+	const double DistErrorTolerance = Quantization.GetLocationTolerance();
+	const double OrientationErrorTolerance = Quantization.GetOrientationTolerance();
 
 	const bool bAreInDifferentSpaces = !((MovementBase.HasSameIndexAndSerialNumber(AuthoritySyncState->MovementBase)) && (MovementBaseBoneName == AuthoritySyncState->MovementBaseBoneName));
 
@@ -234,6 +247,12 @@ bool FBulletDefaultSyncState::ShouldReconcile(const FBulletDataStructBase& Autho
 		{
 			bIsNearEnough = GetLocation_WorldSpace().Equals(AuthoritySyncState->GetLocation_WorldSpace(), DistErrorTolerance);
 		}
+
+		if (bIsNearEnough && OrientationErrorTolerance > 0.0)
+		{
+			const double AngleDegrees = FMath::RadiansToDegrees(Orientation.Quaternion().AngularDistance(AuthoritySyncState->Orientation.Quaternion()));
+			bIsNearEnough = AngleDegrees <= OrientationErrorTolerance;
+		}
 	}
 
 	return bAreInDifferentSpaces || !bIsNearEnough;
@@ -0,0 +1,136 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/DataTypes/BulletNetQuantization.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BulletNetQuantization)
+
+namespace BulletNetQuantization
+{
+	// Widest component SerializeVector sends, anything further out is clamped
+	static constexpr uint32 MaxVectorBits = 62;
+
+	// Components other than the largest of a unit quaternion are within +-1/sqrt(2)
+	static constexpr double QuatComponentRange = UE_INV_SQRT_2;
+
+	// Keeps small negative values small
+	static uint64 ZigZag(int64 Value)
+	{
+		return ((uint64)Value << 1) ^ (uint64)(Value >> 63);
+	}
+
+	static int64 UnZigZag(uint64 Value)
+	{
+		return (int64)(Value >> 1) ^ -(int64)(Value & 1);
+	}
+
+	void SerializeVector(FArchive& Ar, FVector& Value, double Precision)
+	{
+		uint64 Steps[3] = { 0, 0, 0 };
+		uint32 NumBits = 0;
+		if (Ar.IsSaving())
+		{
+			const int64 MaxSteps = (int64(1) << (MaxVectorBits - 1)) - 1;
+			for (int32 i = 0; i < 3; ++i)
+			{
+				Steps[i] = ZigZag(FMath::Clamp(FMath::RoundToInt64(Value[i] / Precision), -MaxSteps, MaxSteps));
+				if (Steps[i] != 0)
+				{
+					NumBits = FMath::Max(NumBits, FMath::FloorLog2_64(Steps[i]) + 1);
+				}
+			}
+		}
+
+		Ar.SerializeInt(NumBits, MaxVectorBits + 1);
+		if (NumBits > MaxVectorBits)
+		{
+			Ar.SetError();
+			return;
+		}
+
+		for (int32 i = 0; i < 3; ++i)
+		{
+			Ar.SerializeBits(&Steps[i], NumBits);
+		}
+
+		if (Ar.IsLoading())
+		{
+			Value = FVector(UnZigZag(Steps[0]) * Precision, UnZigZag(Steps[1]) * Precision, UnZigZag(Steps[2]) * Precision);
+		}
+	}
+
+	void SerializeQuat(FArchive& Ar, FQuat& Value, int32 BitsPerComponent)
+	{
+		const uint32 MaxValue = (1u << BitsPerComponent) - 1;
+
+		uint32 LargestIndex = 0;
+		uint32 Packed[3] = { 0, 0, 0 };
+		if (Ar.IsSaving())
+		{
+			const FQuat Normalized = Value.GetNormalized();
+			const double Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+			for (uint32 i = 1; i < 4; ++i)
+			{
+				if (FMath::Abs(Components[i]) > FMath::Abs(Components[LargestIndex]))
+				{
+					LargestIndex = i;
+				}
+			}
+
+			// q and -q are the same rotation, flipping the sign leaves the dropped component positive
+			const double Sign = Components[LargestIndex] < 0 ? -1.0 : 1.0;
+			for (uint32 i = 0, j = 0; i < 4; ++i)
+			{
+				if (i == LargestIndex) continue;
+				const double Normalised = (Components[i] * Sign / QuatComponentRange) * 0.5 + 0.5;
+				Packed[j++] = (uint32)FMath::Clamp<int64>(FMath::RoundToInt64(Normalised * MaxValue), 0, MaxValue);
+			}
+		}
+
+		Ar.SerializeBits(&LargestIndex, 2);
+		for (int32 j = 0; j < 3; ++j)
+		{
+			Ar.SerializeBits(&Packed[j], BitsPerComponent);
+		}
+
+		if (Ar.IsLoading())
+		{
+			double Components[4];
+			double SumSquares = 0;
+			for (uint32 i = 0, j = 0; i < 4; ++i)
+			{
+				if (i == LargestIndex) continue;
+				Components[i] = ((double)Packed[j++] / MaxValue - 0.5) * 2.0 * QuatComponentRange;
+				SumSquares += Components[i] * Components[i];
+			}
+			Components[LargestIndex] = FMath::Sqrt(FMath::Max(0.0, 1.0 - SumSquares));
+
+			Value = FQuat(Components[0], Components[1], Components[2], Components[3]);
+			Value.Normalize();
+		}
+	}
+
+	double GetMaxVectorError(double Precision)
+	{
+		// Every component is off by at most half a step
+		return UE_SQRT_3 * 0.5 * Precision;
+	}
+
+	double GetMaxQuatError(int32 BitsPerComponent)
+	{
+		// The three sent components are off by half a step each and the rebuilt one by at most three times that, about 3.5 half steps apart in all.
+		// Two close unit quaternions are half their angle apart, so 8 half steps covers it
+		const double HalfStep = QuatComponentRange / ((1u << BitsPerComponent) - 1);
+		return FMath::RadiansToDegrees(8.0 * HalfStep);
+	}
+}
+
+double FBulletSyncStateQuantization::GetLocationTolerance() const
+{
+	return FMath::Max<double>(LocationTolerance, BulletNetQuantization::GetMaxVectorError(LocationPrecision));
+}
+
+double FBulletSyncStateQuantization::GetOrientationTolerance() const
+{
+	return OrientationTolerance > 0.f ? FMath::Max<double>(OrientationTolerance, BulletNetQuantization::GetMaxQuatError(OrientationBits)) : 0.0;
+}
@@ -29,7 +29,7 @@ FBulletDataStructBase::FBulletDataStructBase()
 
 FBulletDataStructBase* FBulletDataStructBase::Clone() const
 {
-	// If child classes don't override this, collections will not work
+	// If child classes don't override this, nothing can clone them through the base type
 	checkf(false, TEXT("%hs is being called erroneously on [%s]. This must be overridden in derived types!"), __FUNCTION__, *GetScriptStruct()->GetName());
 	return nullptr;
 }
@@ -69,9 +69,30 @@ FBulletDataCollection::FBulletDataCollection()
 {
 }
 
+FBulletDataCollection::FBulletDataCollection(const FBulletDataCollection& Other)
+{
+	*this = Other;
+}
+
+FBulletDataCollection::FBulletDataCollection(FBulletDataCollection&& Other)
+	: Entries(MoveTemp(Other.Entries))
+	, Storage(MoveTemp(Other.Storage))
+{
+}
+
+FBulletDataCollection::~FBulletDataCollection()
+{
+	DestroyData(0);
+}
+
+void FBulletDataCollection::Empty()
+{
+	DestroyData(0);
+}
+
 bool FBulletDataCollection::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
-	NetSerializeDataArray(Ar, Map, DataArray);
+	NetSerializeDataArray(Ar, Map);
 
 	if (Ar.IsError())
 	{
@@ -83,18 +104,6 @@ bool FBulletDataCollection::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& b
 	return true;
 }
 
-struct FBulletDataDeleter
-{
-	FORCEINLINE void operator()(FBulletDataStructBase* Object) const
-	{
-		check(Object);
-		UScriptStruct* ScriptStruct = Object->GetScriptStruct();
-		check(ScriptStruct);
-		ScriptStruct->DestroyStruct(Object);
-		FMemory::Free(Object);
-	}
-};
-
 bool FBulletDataCollection::SerializeDebugData(FArchive& Ar)
 {
 	// DISCLAIMER: This serialization is not version independent, so it might not be good enough to be used for the Chaos Visual Debugger in the long run
@@ -104,17 +113,16 @@ bool FBulletDataCollection::SerializeDebugData(FArchive& Ar)
 	if (Ar.IsLoading())
 	{
 		Ar << NumDataStructs;
-		DataArray.SetNumZeroed(NumDataStructs);
 	}
 	else
 	{
-		NumDataStructs = DataArray.Num();
+		NumDataStructs = Entries.Num();
 		Ar << NumDataStructs;
 	}
 
 	if (Ar.IsLoading())
 	{
-		DataArray.Empty();
+		Empty();
 		for (int32 i = 0; i < NumDataStructs && !Ar.IsError(); ++i)
 		{
 			FString StructName;
@@ -128,18 +136,15 @@ bool FBulletDataCollection::SerializeDebugData(FArchive& Ar)
 	}
 	else
 	{
-		for (int32 i = 0; i < DataArray.Num() && !Ar.IsError(); ++i)
+		for (int32 i = 0; i < Entries.Num() && !Ar.IsError(); ++i)
 		{
-			FBulletDataStructBase* MoveDataStruct = DataArray[i].Get();
-			if (MoveDataStruct)
-			{
-				// The FullName of the script struct will be something like "ScriptStruct /Script/Bullet.FCharacterDefaultInputs"
-				FString FullStructName = MoveDataStruct->GetScriptStruct()->GetFullName(nullptr);
-				// We don't need to save the first part since we only ever save UScriptStructs (C++ structs)
-				FString StructName = FullStructName.RightChop(13); // So we chop the "ScriptStruct " part (hence 13 characters)
-				Ar << StructName;
-				MoveDataStruct->GetScriptStruct()->SerializeBin(Ar, MoveDataStruct);
-			}
+			FBulletDataStructBase* MoveDataStruct = GetDataAt(i);
+			// The FullName of the script struct will be something like "ScriptStruct /Script/Bullet.FCharacterDefaultInputs"
+			FString FullStructName = MoveDataStruct->GetScriptStruct()->GetFullName(nullptr);
+			// We don't need to save the first part since we only ever save UScriptStructs (C++ structs)
+			FString StructName = FullStructName.RightChop(13); // So we chop the "ScriptStruct " part (hence 13 characters)
+			Ar << StructName;
+			MoveDataStruct->GetScriptStruct()->SerializeBin(Ar, MoveDataStruct);
 		}
 	}
 
@@ -151,52 +156,31 @@ FBulletDataCollection& FBulletDataCollection::operator=(const FBulletDataCollect
 	// Perform deep copy of this Group
 	if (this != &Other)
 	{
-		bool bCanCopyInPlace = (BulletPhysicsEngine::DisableDataCopyInPlace == 0 && DataArray.Num() == Other.DataArray.Num());
+		bool bCanCopyInPlace = (BulletPhysicsEngine::DisableDataCopyInPlace == 0 && Entries.Num() == Other.Entries.Num());
+		for (int32 i = 0; i < Entries.Num() && bCanCopyInPlace; ++i)
+		{
+			bCanCopyInPlace = Entries[i].Type == Other.Entries[i].Type;
+		}
+
 		if (bCanCopyInPlace)
 		{
-			// If copy in place is enabled and the arrays are the same size, copy by index
-			for (int32 i = 0; i < DataArray.Num(); ++i)
+			// Same types in the same places, which is the usual case for frames of the same simulation, so copy each in place
+			for (int32 i = 0; i < Entries.Num(); ++i)
 			{
-				if (FBulletDataStructBase* SrcData = Other.DataArray[i].Get())
-				{
-					FBulletDataStructBase* DestData = DataArray[i].Get();
-					UScriptStruct* SourceStruct = SrcData->GetScriptStruct();
-
-					if (DestData && SourceStruct == DestData->GetScriptStruct())
-					{
-						// Same type so copy in place
-						SourceStruct->CopyScriptStruct(DestData, SrcData, 1);
-					}
-					else
-					{
-						// Different type so replace the shared ptr with a clone
-						DataArray[i] = TSharedPtr<FBulletDataStructBase>(SrcData->Clone());
-					}
-				}
-				else
-				{
-					// Found invalid source, fall back to full copy
-					bCanCopyInPlace = false;
-					break;
-				}
+				Entries[i].Type->CopyScriptStruct(GetEntryMemory(i), Other.GetEntryMemory(i), 1);
+				Entries[i].DataType = Other.Entries[i].DataType;
 			}
 		}
-		
-		if (!bCanCopyInPlace)
+		else
 		{
-			// Deep copy active data blocks
-			DataArray.Empty(Other.DataArray.Num());
-			for (int i = 0; i < Other.DataArray.Num(); ++i)
+			// Take on Other's layout. The storage keeps its capacity, so this only allocates when Other needs more room than we've had before
+			DestroyData(0);
+			Entries = Other.Entries;
+			Storage.SetNumUninitialized(Other.Storage.Num(), EAllowShrinking::No);
+			for (int32 i = 0; i < Entries.Num(); ++i)
 			{
-				if (Other.DataArray[i].IsValid())
-				{
-					FBulletDataStructBase* CopyOfSourcePtr = Other.DataArray[i]->Clone();
-					DataArray.Add(TSharedPtr<FBulletDataStructBase>(CopyOfSourcePtr));
-				}
-				else
-				{
-					UE_LOG(LogBullet, Warning, TEXT("FBulletDataCollection::operator= trying to copy invalid Other DataArray element"));
-				}
+				Entries[i].Type->InitializeStruct(GetEntryMemory(i));
+				Entries[i].Type->CopyScriptStruct(GetEntryMemory(i), Other.GetEntryMemory(i), 1);
 			}
 		}
 	}
@@ -204,34 +188,23 @@ FBulletDataCollection& FBulletDataCollection::operator=(const FBulletDataCollect
 	return *this;
 }
 
-bool FBulletDataCollection::operator==(const FBulletDataCollection& Other) const
+FBulletDataCollection& FBulletDataCollection::operator=(FBulletDataCollection&& Other)
 {
-	// Deep move-by-move comparison
-	if (DataArray.Num() != Other.DataArray.Num())
+	if (this != &Other)
 	{
-		return false;
+		DestroyData(0);
+		Entries = MoveTemp(Other.Entries);
+		Storage = MoveTemp(Other.Storage);
 	}
 
-	for (int32 i = 0; i < DataArray.Num(); ++i)
-	{
-		if (DataArray[i].IsValid() == Other.DataArray[i].IsValid())
-		{
-			if (DataArray[i].IsValid())
-			{
-				// TODO: Implement deep equality checks
-				// 				if (!DataArray[i]->MatchesAndHasSameState(Other.DataArray[i].Get()))
-				// 				{
-				// 					return false; // They're valid and don't match/have same state
-				// 				}
-			}
-		}
-		else
-		{
-			return false; // Mismatch in validity
-		}
-	}
+	return *this;
+}
 
-	return true;
+bool FBulletDataCollection::operator==(const FBulletDataCollection& Other) const
+{
+	// Deep move-by-move comparison. Every entry holds valid data, so only the counts can differ for now
+	// TODO: Implement deep equality checks
+	return Entries.Num() == Other.Entries.Num();
 }
 
 bool FBulletDataCollection::operator!=(const FBulletDataCollection& Other) const
@@ -243,19 +216,18 @@ bool FBulletDataCollection::operator!=(const FBulletDataCollection& Other) const
 bool FBulletDataCollection::ShouldReconcile(const FBulletDataCollection& Other) const
 {
 	// Collections must have matching elements, and those elements are piece-wise tested for needing reconciliation
-	if (DataArray.Num() != Other.DataArray.Num())
+	if (Entries.Num() != Other.Entries.Num())
 	{
 		return true;
 	}
 
-	for (int32 i = 0; i < DataArray.Num(); ++i)
+	for (int32 i = 0; i < Entries.Num(); ++i)
 	{
-		const FBulletDataStructBase* DataElement = DataArray[i].Get();
-		const FBulletDataStructBase* OtherDataElement = Other.FindDataByType(DataElement->GetDataScriptStruct());
+		const FBulletDataStructBase* OtherDataElement = Other.FindDataByType(Entries[i].DataType);
 
 		// Reconciliation is needed if there's no matching types, or if the element pair needs reconciliation
 		if (OtherDataElement == nullptr ||
-			DataElement->ShouldReconcile(*OtherDataElement))
+			GetDataAt(i)->ShouldReconcile(*OtherDataElement))
 		{
 			return true;
 		}
@@ -266,71 +238,72 @@ bool FBulletDataCollection::ShouldReconcile(const FBulletDataCollection& Other)
 
 void FBulletDataCollection::Interpolate(const FBulletDataCollection& From, const FBulletDataCollection& To, float Pct)
 {
-	// TODO: Consider an inline allocator to avoid dynamic memory allocations
-	TSet<TObjectKey<UScriptStruct>> AddedDataTypes;
-
-	// Piece-wise interpolation of matching data blocks
-	for (const TSharedPtr<FBulletDataStructBase>& FromElement : From.DataArray)
+	// Piece-wise interpolation of matching data blocks. Indexed loops, as adding to this collection moves what's in it
+	for (int32 i = 0; i < From.Entries.Num(); ++i)
 	{
-		AddedDataTypes.Add(FromElement->GetDataScriptStruct());
-
-		if (const FBulletDataStructBase* ToElement = To.FindDataByType(FromElement->GetDataScriptStruct()))
+		if (const FBulletDataStructBase* ToElement = To.FindDataByType(From.Entries[i].DataType))
 		{
-			FBulletDataStructBase* InterpElement = FindOrAddDataByType(FromElement->GetDataScriptStruct());
-			InterpElement->Interpolate(*FromElement, *ToElement, Pct);
+			FBulletDataStructBase* InterpElement = FindOrAddDataByType(From.Entries[i].DataType);
+			InterpElement->Interpolate(*From.GetDataAt(i), *ToElement, Pct);
 		}
 		else
 		{
 			// If only present in From, add the block directly to this collection
-			AddDataByCopy(FromElement.Get());
+			AddDataByCopy(From.GetDataAt(i));
 		}
 	}
 
 	// Add any types present only in To as well
-	for (const TSharedPtr<FBulletDataStructBase>& ToElement : To.DataArray)
+	for (int32 i = 0; i < To.Entries.Num(); ++i)
 	{
-		if (!AddedDataTypes.Contains(ToElement->GetDataScriptStruct()))
+		bool bInFrom = false;
+		for (const BulletPhysicsEngine::FDataCollectionEntry& FromEntry : From.Entries)
+		{
+			bInFrom |= FromEntry.DataType == To.Entries[i].DataType;
+		}
+
+		if (!bInFrom)
 		{
-			AddDataByCopy(ToElement.Get());
+			AddDataByCopy(To.GetDataAt(i));
 		}
 	}
 }
 
 void FBulletDataCollection::Merge(const FBulletDataCollection& From)
 {
-	for (const TSharedPtr<FBulletDataStructBase>& FromElement : From.DataArray)
+	for (int32 i = 0; i < From.Entries.Num(); ++i)
 	{
-		if (FBulletDataStructBase* ExistingElement = FindDataByType(FromElement->GetDataScriptStruct()))
+		if (FBulletDataStructBase* ExistingElement = FindDataByType(From.Entries[i].DataType))
 		{
-			ExistingElement->Merge(*FromElement);
+			ExistingElement->Merge(*From.GetDataAt(i));
 		}
 		else
 		{
 			// If only present in the previous block, copy it into this block
-			AddDataByCopy(FromElement.Get());
+			AddDataByCopy(From.GetDataAt(i));
 		}
 	}
 }
 
 void FBulletDataCollection::Decay(float DecayAmount)
 {
-	for (const TSharedPtr<FBulletDataStructBase>& Element : DataArray)
+	for (int32 i = 0; i < Entries.Num(); ++i)
 	{
-		Element->Decay(DecayAmount);
+		GetDataAt(i)->Decay(DecayAmount);
 	}
 }
 
 
 bool FBulletDataCollection::HasSameContents(const FBulletDataCollection& Other) const
 {
-	if (DataArray.Num() != Other.DataArray.Num())
+	if (Entries.Num() != Other.Entries.Num())
 	{
 		return false;
 	}
 
-	for (int32 i = 0; i < DataArray.Num(); ++i)
+	for (int32 i = 0; i < Entries.Num(); ++i)
 	{
-		if (DataArray[i]->GetDataScriptStruct() != Other.DataArray[i]->GetDataScriptStruct())
+		if (Entries[i].DataType != Other.Entries[i].DataType)
 		{
 			return false;
 		}
@@ -341,42 +314,68 @@ bool FBulletDataCollection::HasSameContents(const FBulletDataCollection& Other)
 
 void FBulletDataCollection::AddStructReferencedObjects(FReferenceCollector& Collector) const
 {
-	for (const TSharedPtr<FBulletDataStructBase>& Data : DataArray)
+	for (int32 i = 0; i < Entries.Num(); ++i)
 	{
-		if (Data.IsValid())
-		{
-			Data->AddReferencedObjects(Collector);
-		}
+		GetDataAt(i)->AddReferencedObjects(Collector);
 	}
 }
 
 void FBulletDataCollection::ToString(FAnsiStringBuilderBase& Out) const
 {
-	for (const TSharedPtr<FBulletDataStructBase>& Data : DataArray)
+	for (int32 i = 0; i < Entries.Num(); ++i)
 	{
-		if (Data.IsValid())
-		{
-			UScriptStruct* Struct = Data->GetScriptStruct();
-			Out.Appendf("\n[%s]\n", TCHAR_TO_ANSI(*Struct->GetName()));
-			Data->ToString(Out);
-		}
+		Out.Appendf("\n[%s]\n", TCHAR_TO_ANSI(*Entries[i].Type->GetName()));
+		GetDataAt(i)->ToString(Out);
 	}
 }
 
-TArray<TSharedPtr<FBulletDataStructBase>>::TConstIterator FBulletDataCollection::GetCollectionDataIterator() const
+FBulletDataCollectionConstIterator FBulletDataCollection::GetCollectionDataIterator() const
 {
-	return DataArray.CreateConstIterator();
+	return FBulletDataCollectionConstIterator(*this);
+}
+
+TArray<FBulletDataStructBase*, TInlineAllocator<4>> FBulletDataCollection::GetDataArray() const
+{
+	TArray<FBulletDataStructBase*, TInlineAllocator<4>> DataArray;
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		DataArray.Add(GetDataAt(i));
+	}
+	return DataArray;
 }
 
-//static 
-TSharedPtr<FBulletDataStructBase> FBulletDataCollection::CreateDataByType(const UScriptStruct* DataStructType)
+
+FBulletDataStructBase* FBulletDataCollection::EmplaceData(const UScriptStruct* ScriptStruct)
 {
-	check(DataStructType->IsChildOf(FBulletDataStructBase::StaticStruct()));
+	check(ScriptStruct->IsChildOf(FBulletDataStructBase::StaticStruct()));
+
+	const UScriptStruct::ICppStructOps* StructOps = ScriptStruct->GetCppStructOps();
+	checkf(StructOps->GetAlignment() <= sizeof(BulletPhysicsEngine::FDataCollectionBlock), TEXT("%s needs more alignment than a data collection provides"), *ScriptStruct->GetName());
+
+	BulletPhysicsEngine::FDataCollectionEntry Entry;
+	Entry.Type = ScriptStruct;
+	Entry.DataType = ScriptStruct;
+	Entry.Offset = Align(GetUsedBytes(), StructOps->GetAlignment());
+	Entry.Size = StructOps->GetSize();
+	Entries.Add(Entry);
+
+	// Growing may move the structs already here. Like anything kept in a TArray, they're fine with that
+	Storage.SetNumUninitialized(FMath::DivideAndRoundUp<int32>(Entry.Offset + Entry.Size, sizeof(BulletPhysicsEngine::FDataCollectionBlock)), EAllowShrinking::No);
+
+	uint8* Memory = GetEntryMemory(Entries.Num() - 1);
+	ScriptStruct->InitializeStruct(Memory);
+	return reinterpret_cast<FBulletDataStructBase*>(Memory);
+}
 
-	FBulletDataStructBase* NewDataBlock = (FBulletDataStructBase*)FMemory::Malloc(DataStructType->GetCppStructOps()->GetSize());
-	DataStructType->InitializeStruct(NewDataBlock);
+void FBulletDataCollection::DestroyData(int32 FirstIndex)
+{
+	for (int32 i = Entries.Num() - 1; i >= FirstIndex; --i)
+	{
+		Entries[i].Type->DestroyStruct(GetEntryMemory(i));
+	}
 
-	return TSharedPtr<FBulletDataStructBase>(NewDataBlock, FBulletDataDeleter());
+	Entries.SetNum(FirstIndex, EAllowShrinking::No);
+	Storage.SetNumUninitialized(FMath::DivideAndRoundUp<int32>(GetUsedBytes(), sizeof(BulletPhysicsEngine::FDataCollectionBlock)), EAllowShrinking::No);
 }
 
 
@@ -384,20 +383,15 @@ FBulletDataStructBase* FBulletDataCollection::AddDataByType(const UScriptStruct*
 {
 	if (ensure(!FindDataByType(DataStructType)))
 	{
-		TSharedPtr<FBulletDataStructBase> NewDataInstance;
-
 		if (DataStructType->IsA<UUserDefinedStruct>())
 		{
-			NewDataInstance = CreateDataByType(FBulletUserDefinedDataStruct::StaticStruct());
-			static_cast<FBulletUserDefinedDataStruct*>(NewDataInstance.Get())->StructInstance.InitializeAs(DataStructType);
-		}
-		else
-		{
-			NewDataInstance = CreateDataByType(DataStructType);
+			FBulletUserDefinedDataStruct* NewDataInstance = static_cast<FBulletUserDefinedDataStruct*>(EmplaceData(FBulletUserDefinedDataStruct::StaticStruct()));
+			NewDataInstance->StructInstance.InitializeAs(DataStructType);
+			Entries.Last().DataType = DataStructType;
+			return NewDataInstance;
 		}
 
-		DataArray.Add(NewDataInstance);
-		return NewDataInstance.Get();
+		return EmplaceData(DataStructType);
 	}
 	
 	return nullptr;
@@ -407,7 +401,7 @@ FBulletDataStructBase* FBulletDataCollection::AddDataByType(const UScriptStruct*
 void FBulletDataCollection::AddOrOverwriteData(const TSharedPtr<FBulletDataStructBase> DataInstance)
 {
 	RemoveDataByType(DataInstance->GetDataScriptStruct());
-	DataArray.Add(DataInstance);
+	AddDataByCopy(DataInstance.Get());
 }
 
 
@@ -416,37 +410,57 @@ void FBulletDataCollection::AddDataByCopy(const FBulletDataStructBase* DataInsta
 	check(DataInstanceToCopy);
 
 	const UScriptStruct* TypeToMatch = DataInstanceToCopy->GetDataScriptStruct();
+	// Note that we've matched based on the "data" type but we're copying the top-level type (a FBulletDataStructBase subtype)
+	const UScriptStruct* BulletDataTypeToCopy = DataInstanceToCopy->GetScriptStruct();
 
-	if (FBulletDataStructBase* ExistingMatchingData = FindDataByType(TypeToMatch))
+	const int32 ExistingIndex = FindDataIndexByType(TypeToMatch);
+	if (ExistingIndex != INDEX_NONE)
 	{
-		// Note that we've matched based on the "data" type but we're copying the top-level type (a FBulletDataStructBase subtype)
-		const UScriptStruct* BulletDataTypeToCopy = DataInstanceToCopy->GetScriptStruct();
-		BulletDataTypeToCopy->CopyScriptStruct(ExistingMatchingData, DataInstanceToCopy, 1);
+		BulletDataTypeToCopy->CopyScriptStruct(GetDataAt(ExistingIndex), DataInstanceToCopy, 1);
+		Entries[ExistingIndex].DataType = TypeToMatch;
 	}
 	else
 	{
-		DataArray.Add(TSharedPtr<FBulletDataStructBase>(DataInstanceToCopy->Clone()));
+		FBulletDataStructBase* NewData = EmplaceData(BulletDataTypeToCopy);
+		BulletDataTypeToCopy->CopyScriptStruct(NewData, DataInstanceToCopy, 1);
+		Entries.Last().DataType = TypeToMatch;
 	}
 }
 
 
-FBulletDataStructBase* FBulletDataCollection::FindDataByType(const UScriptStruct* DataStructType) const
+int32 FBulletDataCollection::FindDataIndexByType(const UScriptStruct* DataStructType) const
 {
-	for (const TSharedPtr<FBulletDataStructBase>& Data : DataArray)
+	// Nearly every lookup is for the exact type, which needs no walk up the hierarchy
+	for (int32 i = 0; i < Entries.Num(); ++i)
 	{
-		const UStruct* CandidateStruct = Data->GetDataScriptStruct();
+		if (Entries[i].DataType == DataStructType)
+		{
+			return i;
+		}
+	}
+
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		const UStruct* CandidateStruct = Entries[i].DataType ? Entries[i].DataType->GetSuperStruct() : nullptr;
 		while (CandidateStruct)
 		{
 			if (DataStructType == CandidateStruct)
 			{
-				return Data.Get();
+				return i;
 			}
 
 			CandidateStruct = CandidateStruct->GetSuperStruct();
 		}
 	}
 
-	return nullptr;
+	return INDEX_NONE;
+}
+
+
+FBulletDataStructBase* FBulletDataCollection::FindDataByType(const UScriptStruct* DataStructType) const
+{
+	const int32 Index = FindDataIndexByType(DataStructType);
+	return Index != INDEX_NONE ? GetDataAt(Index) : nullptr;
 }
 
 
@@ -463,52 +477,47 @@ FBulletDataStructBase* FBulletDataCollection::FindOrAddDataByType(const UScriptS
 
 bool FBulletDataCollection::RemoveDataByType(const UScriptStruct* DataStructType)
 {
-	int32 IndexToRemove = -1;
-
-	for (int32 i=0; i < DataArray.Num() && IndexToRemove < 0; ++i)
+	const int32 IndexToRemove = FindDataIndexByType(DataStructType);
+	if (IndexToRemove == INDEX_NONE)
 	{
-		const UStruct* CandidateStruct = DataArray[i]->GetDataScriptStruct();
-		while (CandidateStruct)
-		{
-			if (DataStructType == CandidateStruct)
-			{
-				IndexToRemove = i;
-				break;
-			}
-
-			CandidateStruct = CandidateStruct->GetSuperStruct();
-		}
+		return false;
 	}
 
-	if (IndexToRemove >= 0)
+	Entries[IndexToRemove].Type->DestroyStruct(GetEntryMemory(IndexToRemove));
+
+	// Slide everything after it down to close the gap
+	uint8* StorageMemory = reinterpret_cast<uint8*>(Storage.GetData());
+	int32 UsedBytes = Entries[IndexToRemove].Offset;
+	for (int32 i = IndexToRemove + 1; i < Entries.Num(); ++i)
 	{
-		DataArray.RemoveAt(IndexToRemove);
-		return true;
+		BulletPhysicsEngine::FDataCollectionEntry& Entry = Entries[i];
+		const int32 NewOffset = Align(UsedBytes, Entry.Type->GetCppStructOps()->GetAlignment());
+		FMemory::Memmove(StorageMemory + NewOffset, StorageMemory + Entry.Offset, Entry.Size);
+		Entry.Offset = NewOffset;
+		UsedBytes = NewOffset + Entry.Size;
 	}
 
-	return false;
+	Entries.RemoveAt(IndexToRemove, EAllowShrinking::No);
+	Storage.SetNumUninitialized(FMath::DivideAndRoundUp<int32>(UsedBytes, sizeof(BulletPhysicsEngine::FDataCollectionBlock)), EAllowShrinking::No);
+	return true;
 }
 
-/*static*/
-void FBulletDataCollection::NetSerializeDataArray(FArchive& Ar, UPackageMap* Map, TArray<TSharedPtr<FBulletDataStructBase>>& DataArray)
+void FBulletDataCollection::NetSerializeDataArray(FArchive& Ar, UPackageMap* Map)
 {
 	uint8 NumDataStructsToSerialize;
 	if (Ar.IsSaving())
 	{
-		NumDataStructsToSerialize = DataArray.Num();
+		NumDataStructsToSerialize = Entries.Num();
 	}
 
 	Ar << NumDataStructsToSerialize;
 
-	if (Ar.IsLoading())
-	{
-		DataArray.SetNumZeroed(NumDataStructsToSerialize);
-	}
-
+	// Which entry the next struct goes in. Only falls behind i if a null struct arrives
+	int32 EntryIndex = 0;
 	for (int32 i = 0; i < NumDataStructsToSerialize && !Ar.IsError(); ++i)
 	{
-		TCheckedObjPtr<UScriptStruct> ScriptStruct = DataArray[i].IsValid() ? DataArray[i]->GetScriptStruct() : nullptr;
-		UScriptStruct* ScriptStructLocal = ScriptStruct.Get();
+		UScriptStruct* ScriptStructLocal = EntryIndex < Entries.Num() ? const_cast<UScriptStruct*>(Entries[EntryIndex].Type) : nullptr;
+		TCheckedObjPtr<UScriptStruct> ScriptStruct = ScriptStructLocal;
 
 		Ar << ScriptStruct;
 
@@ -533,27 +542,17 @@ void FBulletDataCollection::NetSerializeDataArray(FArchive& Ar, UPackageMap* Map
 
 			if (bIsDerivedFromBase)
 			{
-				if (Ar.IsLoading())
+				if (Ar.IsLoading() && ScriptStructLocal != ScriptStruct.Get())
 				{
-					if (DataArray[i].IsValid() && ScriptStructLocal == ScriptStruct.Get())
-					{
-						// What we have locally is the same type as we're being serialized into, so we don't need to
-						// reallocate - just use existing structure
-					}
-					else
-					{
-						// For now, just reset/reallocate the data when loading.
-						// Longer term if we want to generalize this and use it for property replication, we should support
-						// only reallocating when necessary
-						FBulletDataStructBase* NewDataBlock = (FBulletDataStructBase*)FMemory::Malloc(ScriptStruct->GetCppStructOps()->GetSize());
-						ScriptStruct->InitializeStruct(NewDataBlock);
-
-						DataArray[i] = TSharedPtr<FBulletDataStructBase>(NewDataBlock, FBulletDataDeleter());
-					}
+					// What we have from here on was laid out for other types, so it's rebuilt as the rest arrives.
+					// When the types match we just use the existing structure
+					DestroyData(EntryIndex);
+					EmplaceData(ScriptStruct.Get());
 				}
 
 				bool bArrayElementSuccess = false;
-				DataArray[i]->NetSerialize(Ar, Map, bArrayElementSuccess);
+				FBulletDataStructBase* Data = GetDataAt(EntryIndex);
+				Data->NetSerialize(Ar, Map, bArrayElementSuccess);
 
 				if (!bArrayElementSuccess)
 				{
@@ -561,6 +560,10 @@ void FBulletDataCollection::NetSerializeDataArray(FArchive& Ar, UPackageMap* Map
 					Ar.SetError();
 					break;
 				}
+
+				// A user-defined struct wrapper may have just changed what it holds
+				Entries[EntryIndex].DataType = Data->GetDataScriptStruct();
+				++EntryIndex;
 			}
 			else
 			{
@@ -577,6 +580,10 @@ void FBulletDataCollection::NetSerializeDataArray(FArchive& Ar, UPackageMap* Map
 		}
 	}
 
+	if (Ar.IsLoading() && !Ar.IsError() && EntryIndex < Entries.Num())
+	{
+		DestroyData(EntryIndex);
+	}
 }
 
 
@@ -2,4 +2,14 @@
 
 
 #include "Core/DataTypes/BulletSimulationTypes.h"
+#include "Core/Singletons/BulletPhysicsWorldSubsystem.h"
 
+void FBulletSyncState::CheckWorldHash(const FBulletSyncState& AuthorityState) const
+{
+	// We're the predicted state NP matched up with the authority's, so our frame is the one to look our own hash up by
+	UBulletPhysicsWorldSubsystem* Subsystem = WorldHashSource.Get();
+	if (Subsystem && LocalWorldFrame != INDEX_NONE)
+	{
+		Subsystem->CheckAuthorityWorldStateHash(LocalWorldFrame, AuthorityState.WorldHashFrame, AuthorityState.WorldHash);
+	}
+}
@@ -0,0 +1,91 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BulletMain.h"
+#include "BulletLogChannels.h"
+#include "HAL/IConsoleManager.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "BulletDynamics/ConstraintSolver/btSolverBody.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+namespace BulletPhysicsEngine
+{
+	// Drops a grid of boxes onto a ground box in a world of its own and times the steps.
+	// Run it once in a double and once in a float build (BULLET_DOUBLE_PRECISION=0) to compare the two.
+	static void RunStepBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumBodies = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+		const int32 NumSteps = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 600;
+		const int32 NumWarmupSteps = 60;
+		const btScalar TimeStep = btScalar(1. / 60.);
+
+		btDefaultCollisionConfiguration CollisionConfig;
+		btCollisionDispatcher Dispatcher(&CollisionConfig);
+		btDbvtBroadphase Broadphase;
+		btSequentialImpulseConstraintSolver Solver;
+		btDiscreteDynamicsWorld World(&Dispatcher, &Broadphase, &Solver, &CollisionConfig);
+		World.setGravity(btVector3(0, 0, -9.81));
+
+		btBoxShape GroundShape(btVector3(500, 500, 1));
+		btRigidBody Ground(btRigidBody::btRigidBodyConstructionInfo(0, nullptr, &GroundShape));
+		Ground.setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(0, 0, -1)));
+		World.addRigidBody(&Ground);
+
+		// Half a metre cubes in loose columns, so they land on each other and keep the solver busy
+		btBoxShape BoxShape(btVector3(0.5, 0.5, 0.5));
+		btVector3 BoxInertia(0, 0, 0);
+		BoxShape.calculateLocalInertia(10, BoxInertia);
+
+		const int32 GridSize = FMath::CeilToInt(FMath::Sqrt((float)NumBodies / 10.f));
+		TArray<TUniquePtr<btRigidBody>> Boxes;
+		Boxes.Reserve(NumBodies);
+		for (int32 i = 0; i < NumBodies; ++i)
+		{
+			const int32 Column = i % (GridSize * GridSize);
+			const int32 Level = i / (GridSize * GridSize);
+			btRigidBody* Box = new btRigidBody(btRigidBody::btRigidBodyConstructionInfo(10, nullptr, &BoxShape, BoxInertia));
+			Box->setWorldTransform(btTransform(btQuaternion(0, 0, btScalar(0.1) * Level),
+				btVector3(btScalar(1.5 * (Column % GridSize)), btScalar(1.5 * (Column / GridSize)), btScalar(1.2 * Level + 1))));
+			World.addRigidBody(Box);
+			Boxes.Emplace(Box);
+		}
+
+		for (int32 i = 0; i < NumWarmupSteps; ++i)
+		{
+			World.stepSimulation(TimeStep, 1, TimeStep);
+		}
+
+		double TotalSeconds = 0;
+		double MinSeconds = TNumericLimits<double>::Max();
+		double MaxSeconds = 0;
+		for (int32 i = 0; i < NumSteps; ++i)
+		{
+			const double Start = FPlatformTime::Seconds();
+			World.stepSimulation(TimeStep, 1, TimeStep);
+			const double Elapsed = FPlatformTime::Seconds() - Start;
+			TotalSeconds += Elapsed;
+			MinSeconds = FMath::Min(MinSeconds, Elapsed);
+			MaxSeconds = FMath::Max(MaxSeconds, Elapsed);
+		}
+
+		UE_LOG(LogBullet, Display, TEXT("bullet.Benchmark: %s precision, %d bodies, %d steps. avg %.3f ms, min %.3f ms, max %.3f ms, %d manifolds"),
+			sizeof(btScalar) == sizeof(double) ? TEXT("double") : TEXT("float"), NumBodies, NumSteps,
+			TotalSeconds * 1000.0 / NumSteps, MinSeconds * 1000.0, MaxSeconds * 1000.0, Dispatcher.getNumManifolds());
+		UE_LOG(LogBullet, Display, TEXT("bullet.Benchmark: sizeof btVector3 %d, btSolverBody %d, btManifoldPoint %d, btPersistentManifold %d, btDbvtNode %d"),
+			(int32)sizeof(btVector3), (int32)sizeof(btSolverBody), (int32)sizeof(btManifoldPoint), (int32)sizeof(btPersistentManifold), (int32)sizeof(btDbvtNode));
+
+		for (const TUniquePtr<btRigidBody>& Box : Boxes)
+		{
+			World.removeRigidBody(Box.Get());
+		}
+		World.removeRigidBody(&Ground);
+	}
+
+	static FAutoConsoleCommand CmdBenchmark(
+		TEXT("bullet.Benchmark"),
+		TEXT("Times bullet world steps at the precision bullet was built with. Args: [NumBodies=1000] [NumSteps=600]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunStepBenchmark));
+}
@@ -16,13 +16,13 @@ void UBulletBlackboard::Invalidate(BulletPhysicsEngine::EInvalidationReason Reas
 	{
 	default:
 	case BulletPhysicsEngine::EInvalidationReason::FullReset:
+	// Everything kept here is worked out from simulated frames, which a rollback may replay differently
+	case BulletPhysicsEngine::EInvalidationReason::Rollback:
 		{
 			UE::TWriteScopeLock Lock(ObjectsMapLock);
 			ObjectsByName.Empty();
 		}
 		break;
-
-		// TODO: Support other reasons
 	}
 }
 
@@ -0,0 +1,350 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletCharacterMovement.h"
+
+#include "Core/DataTypes/BulletSimulationTypes.h"
+#include "Core/Libraries/BulletMathLibrary.h"
+
+namespace
+{
+	// Cosine of the angle between a move and a surface below which the move counts as sliding along it
+	constexpr btScalar GrazingSlack = btScalar(0.01);
+
+	// Closest hit of a capsule sweep, leaving out surfaces the capsule is moving away from or along
+	struct FCharacterSweepCallback : public btCollisionWorld::ClosestConvexResultCallback
+	{
+		FCharacterSweepCallback(const btVector3& From, const btVector3& To)
+			: ClosestConvexResultCallback(From, To)
+			, Direction((To - From).normalized())
+		{
+		}
+
+		virtual btScalar addSingleResult(btCollisionWorld::LocalConvexResult& Result, bool bNormalInWorldSpace) override
+		{
+			if (!Result.m_hitCollisionObject->hasContactResponse())
+			{
+				return m_closestHitFraction;
+			}
+
+			// Without this, brushing the floor or a wall the capsule is already touching would stop every move dead.
+			// The slack covers sliding along a surface, where the normal the slide was worked out from and the one found now differ slightly
+			const btVector3 Normal = bNormalInWorldSpace ? Result.m_hitNormalLocal : Result.m_hitCollisionObject->getWorldTransform().getBasis() * Result.m_hitNormalLocal;
+			if (Normal.dot(Direction) > -GrazingSlack)
+			{
+				return m_closestHitFraction;
+			}
+			return ClosestConvexResultCallback::addSingleResult(Result, bNormalInWorldSpace);
+		}
+
+		btVector3 Direction;
+	};
+
+	// Tilts a horizontal move onto a walkable slope, keeping its horizontal part as it is
+	FVector ProjectOntoFloor(const FVector& Delta, const FVector& FloorNormal)
+	{
+		if (FloorNormal.Z <= UE_KINDA_SMALL_NUMBER)
+		{
+			return Delta;
+		}
+		return FVector(Delta.X, Delta.Y, -(FloorNormal.X * Delta.X + FloorNormal.Y * Delta.Y) / FloorNormal.Z);
+	}
+}
+
+FBulletCharacterMovement::FBulletCharacterMovement(const btCollisionWorld* InWorld, const FVector& InWorldOrigin, const FBulletCharacterMovementSettings& InSettings, float InRadius, float InHalfHeight)
+	: World(InWorld)
+	, WorldOrigin(InWorldOrigin)
+	, Settings(InSettings)
+	, Radius(InRadius)
+	, HalfHeight(FMath::Max(InHalfHeight, InRadius))
+	, WalkableFloorZ(InSettings.GetWalkableFloorZ())
+	, Capsule(BulletHelpers::ToBtSize(InRadius), BulletHelpers::ToBtSize(2.f * (FMath::Max(InHalfHeight, InRadius) - InRadius)))
+{
+}
+
+void FBulletCharacterMovement::Tick(FBulletCharacterState& State, const FVector& MoveIntent, bool bJumpPressed, float DeltaSeconds) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletCharacterTick);
+
+	// A mode that changes part way through hands the rest of the tick to the next one, a few times at most so two modes can't pass it back and forth forever
+	float RemainingSeconds = DeltaSeconds;
+	for (int32 ModeChanges = 0; ModeChanges < 3 && RemainingSeconds > UE_KINDA_SMALL_NUMBER; ++ModeChanges)
+	{
+		if (State.Mode == BulletDefaultModeNames::Walking)
+		{
+			RemainingSeconds = TickWalking(State, MoveIntent, bJumpPressed, RemainingSeconds);
+		}
+		else if (State.Mode == BulletDefaultModeNames::Falling)
+		{
+			RemainingSeconds = TickFalling(State, MoveIntent, RemainingSeconds);
+		}
+		else
+		{
+			break;
+		}
+		bJumpPressed = false;
+	}
+}
+
+FBulletFloorCheckResult FBulletCharacterMovement::FindFloor(const FVector& Location) const
+{
+	return FindFloor(Location, Settings.MaxStepHeight + Settings.SkinWidth);
+}
+
+FBulletFloorCheckResult FBulletCharacterMovement::FindFloor(const FVector& Location, float Distance) const
+{
+	FBulletFloorCheckResult Floor;
+	Floor.Location = Location;
+
+	float Time;
+	if (!SweepCapsule(Location, Location - FVector(0, 0, Distance), Time, Floor.ImpactPoint, Floor.ImpactNormal))
+	{
+		return Floor;
+	}
+	Floor.bBlockingHit = true;
+	Floor.FloorDist = Time * Distance;
+	Floor.bWalkableFloor = IsWalkable(Floor.ImpactNormal);
+
+	if (!Floor.bWalkableFloor)
+	{
+		// Triangle edges inside a mesh and ledge corners can hand the round bottom of the capsule a normal that isn't the surface's.
+		// Check straight under the middle as well, as deep as the capsule could be resting on a walkable slope
+		const float RestingDepth = HalfHeight + Floor.FloorDist + Radius * (1.f / WalkableFloorZ - 1.f) + Settings.SkinWidth;
+		const btVector3 From = BulletHelpers::ToBtPos(Location, WorldOrigin);
+		const btVector3 To = BulletHelpers::ToBtPos(Location - FVector(0, 0, RestingDepth), WorldOrigin);
+		btCollisionWorld::ClosestRayResultCallback Callback(From, To);
+		World->rayTest(From, To, Callback);
+		const FVector RayNormal = BulletHelpers::ToUEDir(Callback.m_hitNormalWorld, false);
+		if (Callback.hasHit() && IsWalkable(RayNormal))
+		{
+			Floor.bWalkableFloor = true;
+			Floor.ImpactPoint = BulletHelpers::ToUEPos(Callback.m_hitPointWorld, WorldOrigin);
+			Floor.ImpactNormal = RayNormal;
+		}
+	}
+	return Floor;
+}
+
+bool FBulletCharacterMovement::SweepCapsule(const FVector& Start, const FVector& End, float& OutTime, FVector& OutImpactPoint, FVector& OutNormal) const
+{
+	if ((End - Start).IsNearlyZero())
+	{
+		return false;
+	}
+
+	const btVector3 From = BulletHelpers::ToBtPos(Start, WorldOrigin);
+	const btVector3 To = BulletHelpers::ToBtPos(End, WorldOrigin);
+	FCharacterSweepCallback Callback(From, To);
+	// No allowed penetration, the world's default lets the capsule sink several centimetres into whatever it lands on
+	World->convexSweepTest(&Capsule, btTransform(btQuaternion::getIdentity(), From), btTransform(btQuaternion::getIdentity(), To), Callback, 0);
+	if (!Callback.hasHit())
+	{
+		return false;
+	}
+
+	OutTime = Callback.m_closestHitFraction;
+	OutImpactPoint = BulletHelpers::ToUEPos(Callback.m_hitPointWorld, WorldOrigin);
+	OutNormal = BulletHelpers::ToUEDir(Callback.m_hitNormalWorld, false).GetSafeNormal();
+	return true;
+}
+
+float FBulletCharacterMovement::TickWalking(FBulletCharacterState& State, const FVector& MoveIntent, bool bJumpPressed, float DeltaSeconds) const
+{
+	// A floor cached from anywhere else is stale
+	if (State.Floor.Location != State.Location)
+	{
+		State.Floor = FindFloor(State.Location);
+	}
+	if (!State.Floor.bWalkableFloor)
+	{
+		State.Mode = BulletDefaultModeNames::Falling;
+		return DeltaSeconds;
+	}
+
+	if (bJumpPressed)
+	{
+		State.Velocity.Z = Settings.JumpUpwardsSpeed;
+		State.Floor = FBulletFloorCheckResult();
+		State.Mode = BulletDefaultModeNames::Falling;
+		return DeltaSeconds;
+	}
+
+	// Ground velocity stays horizontal, the floor only tilts the move
+	const FVector TargetVelocity = FVector(MoveIntent.X, MoveIntent.Y, 0).GetClampedToMaxSize(1.f) * Settings.MaxSpeed;
+	const float Rate = TargetVelocity.IsNearlyZero() ? Settings.Deceleration : Settings.Acceleration;
+	const FVector Velocity = FMath::VInterpConstantTo(FVector(State.Velocity.X, State.Velocity.Y, 0), TargetVelocity, DeltaSeconds, Rate);
+
+	const FVector Start = State.Location;
+	MoveAlongFloor(State, ProjectOntoFloor(Velocity * DeltaSeconds, State.Floor.ImpactNormal));
+
+	// Step down onto whatever is below, unless we walked off a ledge
+	FBulletFloorCheckResult Floor = FindFloor(State.Location);
+	if (!Floor.bWalkableFloor)
+	{
+		State.Velocity = Velocity;
+		State.Floor = Floor;
+		State.Mode = BulletDefaultModeNames::Falling;
+		return 0.f;
+	}
+	SnapToFloor(State.Location, Floor);
+	State.Floor = Floor;
+
+	// Anything that cut the move short takes the same off the velocity
+	const FVector Moved = (State.Location - Start) / DeltaSeconds;
+	State.Velocity = FVector(Moved.X, Moved.Y, 0);
+	return 0.f;
+}
+
+float FBulletCharacterMovement::TickFalling(FBulletCharacterState& State, const FVector& MoveIntent, float DeltaSeconds) const
+{
+	FVector Velocity = State.Velocity;
+	const FVector TargetVelocity = FVector(MoveIntent.X, MoveIntent.Y, 0).GetClampedToMaxSize(1.f) * Settings.MaxSpeed;
+	if (!TargetVelocity.IsNearlyZero())
+	{
+		const FVector Horizontal = FMath::VInterpConstantTo(FVector(Velocity.X, Velocity.Y, 0), TargetVelocity, DeltaSeconds, Settings.Acceleration * Settings.AirControlPercentage);
+		Velocity.X = Horizontal.X;
+		Velocity.Y = Horizontal.Y;
+	}
+	Velocity.Z = FMath::Max(Velocity.Z + Settings.GravityZ * DeltaSeconds, -Settings.TerminalVelocity);
+
+	// Averaging the old and new velocity is exact under constant gravity
+	FVector Remaining = (State.Velocity + Velocity) * 0.5f * DeltaSeconds;
+	float RemainingFraction = 1.f;
+	for (int32 Iteration = 0; Iteration < Settings.MaxMoveIterations && !Remaining.IsNearlyZero(); ++Iteration)
+	{
+		float Time;
+		FVector ImpactPoint, Normal;
+		if (!SafeMove(State.Location, Remaining, Time, ImpactPoint, Normal))
+		{
+			break;
+		}
+		Remaining *= 1.f - Time;
+		RemainingFraction *= 1.f - Time;
+
+		if (Velocity.Z <= 0 && IsWalkable(Normal))
+		{
+			FBulletFloorCheckResult Floor = FindFloor(State.Location);
+			if (Floor.bWalkableFloor)
+			{
+				SnapToFloor(State.Location, Floor);
+				State.Floor = Floor;
+				State.Velocity = FVector(Velocity.X, Velocity.Y, 0);
+				State.Mode = BulletDefaultModeNames::Walking;
+				return DeltaSeconds * RemainingFraction;
+			}
+		}
+
+		// Slide along whatever was hit, losing the speed that went into it
+		Remaining = FVector::VectorPlaneProject(Remaining, Normal);
+		if ((Velocity | Normal) < 0)
+		{
+			Velocity = FVector::VectorPlaneProject(Velocity, Normal);
+		}
+	}
+
+	State.Velocity = Velocity;
+	State.Floor = FBulletFloorCheckResult();
+	return 0.f;
+}
+
+void FBulletCharacterMovement::MoveAlongFloor(FBulletCharacterState& State, FVector Delta) const
+{
+	for (int32 Iteration = 0; Iteration < Settings.MaxMoveIterations && !Delta.IsNearlyZero(); ++Iteration)
+	{
+		float Time;
+		FVector ImpactPoint, Normal;
+		if (!SafeMove(State.Location, Delta, Time, ImpactPoint, Normal))
+		{
+			return;
+		}
+		Delta *= 1.f - Time;
+
+		// Up a ramp at the same horizontal speed
+		if (IsWalkable(Normal))
+		{
+			Delta = ProjectOntoFloor(Delta, Normal);
+			continue;
+		}
+
+		const bool bLowEnoughToStepOn = ImpactPoint.Z < State.Location.Z - HalfHeight + Settings.MaxStepHeight;
+		if (bLowEnoughToStepOn && StepUp(State, Delta))
+		{
+			return;
+		}
+
+		// Slide along the wall without being pushed up or down it
+		const FVector WallNormal = FVector(Normal.X, Normal.Y, 0).GetSafeNormal();
+		if (WallNormal.IsZero())
+		{
+			return;
+		}
+		Delta = FVector::VectorPlaneProject(Delta, WallNormal);
+	}
+}
+
+bool FBulletCharacterMovement::StepUp(FBulletCharacterState& State, const FVector& Delta) const
+{
+	float Time;
+	FVector ImpactPoint, Normal;
+
+	FVector Location = State.Location;
+	SafeMove(Location, FVector(0, 0, Settings.MaxStepHeight), Time, ImpactPoint, Normal);
+	const float Climbed = Location.Z - State.Location.Z;
+	if (Climbed <= Settings.SkinWidth)
+	{
+		return false;
+	}
+
+	const FVector Across(Delta.X, Delta.Y, 0);
+	SafeMove(Location, Across, Time, ImpactPoint, Normal);
+	if (FVector::DistSquared2D(Location, State.Location) <= UE_KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	// Only a step if there's something to stand on at the top
+	FBulletFloorCheckResult Floor = FindFloor(Location, Climbed + Settings.SkinWidth * 2.f);
+	if (!Floor.bWalkableFloor)
+	{
+		return false;
+	}
+	SnapToFloor(Location, Floor);
+	State.Location = Location;
+	State.Floor = Floor;
+	return true;
+}
+
+bool FBulletCharacterMovement::SafeMove(FVector& Location, const FVector& Delta, float& OutTime, FVector& OutImpactPoint, FVector& OutNormal) const
+{
+	float HitTime;
+	if (!SweepCapsule(Location, Location + Delta, HitTime, OutImpactPoint, OutNormal))
+	{
+		Location += Delta;
+		OutTime = 1.f;
+		return false;
+	}
+
+	// Pull back from the hit so the next sweep doesn't start touching it
+	const float Length = Delta.Size();
+	const float Travelled = HitTime * Length;
+	OutTime = FMath::Max(Travelled - Settings.SkinWidth, 0.f) / Length;
+	Location += Delta * OutTime;
+
+	// Already closer than SkinWidth, which slides and corners end up in. Backing off along the move can't help, so step off the surface instead
+	if (Travelled < Settings.SkinWidth)
+	{
+		Location += OutNormal * (Settings.SkinWidth - Travelled);
+	}
+	return true;
+}
+
+void FBulletCharacterMovement::SnapToFloor(FVector& Location, FBulletFloorCheckResult& Floor) const
+{
+	const float Drop = Floor.FloorDist - Settings.SkinWidth;
+	if (Drop > 0)
+	{
+		Location.Z -= Drop;
+		Floor.FloorDist -= Drop;
+	}
+	Floor.Location = Location;
+}
@@ -0,0 +1,266 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletContactStream.h"
+
+#include "Core/Libraries/BulletMathLibrary.h"
+
+namespace
+{
+	// Bodies resting on each other keep their manifolds, a pair only counts as moving if one of its simulated bodies is awake
+	bool IsObjectAwake(const btCollisionObject* Object)
+	{
+		return !Object->isStaticOrKinematicObject() && Object->isActive();
+	}
+}
+
+struct FBulletContactStream::FSummariseManifolds : public btIParallelForBody
+{
+	btPersistentManifold* const* Manifolds = nullptr;
+	FManifoldSummary* Summaries = nullptr;
+
+	virtual void forLoop(int Begin, int End) const override
+	{
+		for (int i = Begin; i < End; ++i)
+		{
+			const btPersistentManifold* Manifold = Manifolds[i];
+			FManifoldSummary& Summary = Summaries[i];
+			Summary.ObjectA = Manifold->getBody0();
+			Summary.ObjectB = Manifold->getBody1();
+			Summary.Flags = GetReportFlags(Summary.ObjectA) | GetReportFlags(Summary.ObjectB);
+
+			// Same idea of touching as bullet's contact started / ended callbacks, the manifold has points
+			const int NumContacts = Manifold->getNumContacts();
+			if (Summary.Flags == EBulletContactReportFlags::None || NumContacts == 0)
+			{
+				Summary.Flags = EBulletContactReportFlags::None;
+				continue;
+			}
+
+			int Deepest = 0;
+			Summary.Impulse = 0;
+			for (int p = 0; p < NumContacts; ++p)
+			{
+				const btManifoldPoint& Point = Manifold->getContactPoint(p);
+				Summary.Impulse += Point.getAppliedImpulse();
+				if (Point.getDistance() < Manifold->getContactPoint(Deepest).getDistance())
+				{
+					Deepest = p;
+				}
+			}
+
+			const btManifoldPoint& Point = Manifold->getContactPoint(Deepest);
+			Summary.Point = (Point.getPositionWorldOnA() + Point.getPositionWorldOnB()) * btScalar(0.5);
+			Summary.Normal = Point.m_normalWorldOnB;
+			Summary.Distance = Point.getDistance();
+			Summary.Friction = Point.m_combinedFriction;
+			Summary.Restitution = Point.m_combinedRestitution;
+			Summary.bAwake = IsObjectAwake(Summary.ObjectA) || IsObjectAwake(Summary.ObjectB);
+		}
+	}
+};
+
+void FBulletContactStream::Attach(btDynamicsWorld* World)
+{
+	World->setInternalTickCallback(&FBulletContactStream::OnInternalTick, this);
+}
+
+void FBulletContactStream::Detach(btDynamicsWorld* World)
+{
+	if (World->getWorldUserInfo() == this)
+	{
+		World->setInternalTickCallback(nullptr);
+	}
+}
+
+void FBulletContactStream::OnInternalTick(btDynamicsWorld* World, btScalar TimeStep)
+{
+	static_cast<FBulletContactStream*>(World->getWorldUserInfo())->GatherSubStep(World->getDispatcher());
+}
+
+void FBulletContactStream::SetReportFlags(btCollisionObject* Object, EBulletContactReportFlags Flags)
+{
+	const bool bWasReporting = GetReportFlags(Object) != EBulletContactReportFlags::None;
+	const bool bReporting = Flags != EBulletContactReportFlags::None;
+	NumReportingObjects += (int32)bReporting - (int32)bWasReporting;
+	// The bits above the flags are the object's query channel, see FBulletSceneQuery::SetObjectChannel
+	const int Value = Object->getUserIndex3();
+	Object->setUserIndex3((Value > 0 ? Value & ~0xff : 0) | (int)Flags);
+}
+
+EBulletContactReportFlags FBulletContactStream::GetReportFlags(const btCollisionObject* Object)
+{
+	// Bullet starts every user index at -1
+	const int Value = Object->getUserIndex3();
+	return Value > 0 ? (EBulletContactReportFlags)(Value & 0xff) : EBulletContactReportFlags::None;
+}
+
+void FBulletContactStream::GatherSubStep(btDispatcher* Dispatcher)
+{
+	++NumSubSteps;
+
+	const int32 NumManifolds = Dispatcher->getNumManifolds();
+	if (NumReportingObjects == 0 || NumManifolds == 0) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletGatherContacts);
+
+	ManifoldSummaries.SetNumUninitialized(NumManifolds, EAllowShrinking::No);
+	FSummariseManifolds Summarise;
+	Summarise.Manifolds = Dispatcher->getInternalManifoldPointer();
+	Summarise.Summaries = ManifoldSummaries.GetData();
+	btParallelFor(0, NumManifolds, ManifoldsPerTask, Summarise);
+
+	// Merged in manifold order rather than in whatever order the tasks finished
+	for (const FManifoldSummary& Summary : ManifoldSummaries)
+	{
+		if (Summary.Flags == EBulletContactReportFlags::None) continue;
+
+		int32& PairIndex = StepPairIndices.FindOrAdd(MakePairKey(Summary.ObjectA, Summary.ObjectB), INDEX_NONE);
+		if (PairIndex == INDEX_NONE)
+		{
+			PairIndex = StepPairs.Add({ Summary, Summary.Impulse, NumSubSteps });
+			continue;
+		}
+
+		// Compound pairs touch through a manifold per child, and the pair shows up again every sub step
+		FStepPair& Pair = StepPairs[PairIndex];
+		Pair.Impulse += Summary.Impulse;
+		if (Pair.SubStep != NumSubSteps || Summary.Distance < Pair.Summary.Distance)
+		{
+			const bool bAwake = Pair.Summary.bAwake || Summary.bAwake;
+			Pair.Summary = Summary;
+			Pair.Summary.bAwake = bAwake;
+			Pair.SubStep = NumSubSteps;
+		}
+	}
+}
+
+void FBulletContactStream::FinishStep(const FVector& WorldOrigin, FResolveObject ResolveObject)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletFinishContactEvents);
+
+	Events.Reset();
+	Events.Append(RemovedPairEvents);
+	RemovedPairEvents.Reset();
+
+	UpdateTouchingPairs(WorldOrigin, ResolveObject, true);
+}
+
+void FBulletContactStream::UpdateTouchingPairs(const FVector& WorldOrigin, FResolveObject ResolveObject, bool bSendEvents)
+{
+	++NumSteps;
+
+	for (const FStepPair& Pair : StepPairs)
+	{
+		const FManifoldSummary& Summary = Pair.Summary;
+		const FPairKey Key = MakePairKey(Summary.ObjectA, Summary.ObjectB);
+
+		FTouchingPair* Touching = TouchingPairs.Find(Key);
+		const bool bBegin = Touching == nullptr;
+		if (bBegin)
+		{
+			// Resolved once per contact, unregistering a body ends its pairs so the handles can't go stale while touching
+			Touching = &TouchingPairs.Add(Key);
+			ResolveObject(Summary.ObjectA, Touching->Event.ActorA, Touching->Event.BodyA);
+			ResolveObject(Summary.ObjectB, Touching->Event.ActorB, Touching->Event.BodyB);
+		}
+		else if (Touching->ObjectA != Summary.ObjectA)
+		{
+			Swap(Touching->Event.ActorA, Touching->Event.ActorB);
+			Swap(Touching->Event.BodyA, Touching->Event.BodyB);
+		}
+
+		Touching->ObjectA = Summary.ObjectA;
+		Touching->Flags = Summary.Flags;
+		Touching->LastStep = NumSteps;
+
+		FBulletContactEvent& Event = Touching->Event;
+		Event.Type = bBegin ? EBulletContactEventType::Begin : EBulletContactEventType::Persist;
+		Event.Point = BulletHelpers::ToUEPos(Summary.Point, WorldOrigin);
+		Event.Normal = BulletHelpers::ToUEDir(Summary.Normal, false);
+		Event.NormalImpulse = BulletHelpers::ToUESize(Pair.Impulse);
+		Event.Friction = Summary.Friction;
+		Event.Restitution = Summary.Restitution;
+
+		const bool bSend = bBegin ? EnumHasAnyFlags(Summary.Flags, EBulletContactReportFlags::Begin)
+			: Summary.bAwake && EnumHasAnyFlags(Summary.Flags, EBulletContactReportFlags::Persist);
+		if (bSendEvents && bSend)
+		{
+			Events.Add(Event);
+		}
+	}
+
+	for (auto It = TouchingPairs.CreateIterator(); It; ++It)
+	{
+		if (It->Value.LastStep == NumSteps) continue;
+
+		if (bSendEvents && EnumHasAnyFlags(It->Value.Flags, EBulletContactReportFlags::End))
+		{
+			FBulletContactEvent& Event = Events.Add_GetRef(It->Value.Event);
+			Event.Type = EBulletContactEventType::End;
+			Event.NormalImpulse = 0.f;
+		}
+		It.RemoveCurrent();
+	}
+
+	StepPairs.Reset();
+	StepPairIndices.Reset();
+	NumSubSteps = 0;
+}
+
+void FBulletContactStream::RemoveObject(const btCollisionObject* Object)
+{
+	if (GetReportFlags(Object) != EBulletContactReportFlags::None)
+	{
+		--NumReportingObjects;
+	}
+
+	for (auto It = TouchingPairs.CreateIterator(); It; ++It)
+	{
+		if (It->Key.Get<0>() != Object && It->Key.Get<1>() != Object) continue;
+
+		if (EnumHasAnyFlags(It->Value.Flags, EBulletContactReportFlags::End))
+		{
+			FBulletContactEvent& Event = RemovedPairEvents.Add_GetRef(It->Value.Event);
+			Event.Type = EBulletContactEventType::End;
+			Event.NormalImpulse = 0.f;
+		}
+		It.RemoveCurrent();
+	}
+
+	// Only when the world was stepped without finishing the step, pairs are normally turned into events straight away
+	if (StepPairs.Num() > 0)
+	{
+		StepPairs.RemoveAll([Object](const FStepPair& Pair) { return Pair.Summary.ObjectA == Object || Pair.Summary.ObjectB == Object; });
+		StepPairIndices.Reset();
+		for (int32 i = 0; i < StepPairs.Num(); ++i)
+		{
+			StepPairIndices.Add(MakePairKey(StepPairs[i].Summary.ObjectA, StepPairs[i].Summary.ObjectB), i);
+		}
+	}
+}
+
+void FBulletContactStream::ResetToWorld(btDispatcher* Dispatcher, const FVector& WorldOrigin, FResolveObject ResolveObject)
+{
+	TouchingPairs.Reset();
+	RemovedPairEvents.Reset();
+	StepPairs.Reset();
+	StepPairIndices.Reset();
+	NumSubSteps = 0;
+
+	GatherSubStep(Dispatcher);
+	UpdateTouchingPairs(WorldOrigin, ResolveObject, false);
+}
+
+void FBulletContactStream::Reset()
+{
+	ManifoldSummaries.Empty();
+	StepPairs.Empty();
+	StepPairIndices.Empty();
+	TouchingPairs.Empty();
+	RemovedPairEvents.Empty();
+	Events.Empty();
+	NumSubSteps = 0;
+	NumSteps = 0;
+	NumReportingObjects = 0;
+}
@@ -0,0 +1,63 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletLandscapeShape.h"
+#include "BulletLogChannels.h"
+#include "Core/Libraries/BulletMathLibrary.h"
+#include "LandscapeHeightfieldCollisionComponent.h"
+#include "LandscapeDataAccess.h"
+
+FBulletLandscapeHeightfieldShape::FBulletLandscapeHeightfieldShape(const Chaos::FHeightFieldPtr& InHeightfield, btScalar MinHeight, btScalar MaxHeight)
+	// Bullet only keeps the pointer, the data type is never looked at since every read goes through getRawHeightFieldValue
+	: btHeightfieldTerrainShape(InHeightfield->GeomData.NumCols, InHeightfield->GeomData.NumRows, reinterpret_cast<const short*>(InHeightfield->GeomData.Heights.GetData()),
+		btScalar(InHeightfield->GeomData.HeightPerUnit), MinHeight, MaxHeight, 2, false)
+	, Heightfield(InHeightfield)
+	, Heights(InHeightfield->GeomData.Heights.GetData())
+	, HeightOffset(btScalar(InHeightfield->GeomData.MinValue))
+	, HeightPerUnit(btScalar(InHeightfield->GeomData.HeightPerUnit))
+{
+	// Chaos splits every cell along the same diagonal as bullet does by default, but bullet's z up triangles face down unless flipped
+	setFlipTriangleWinding(true);
+}
+
+FBulletLandscapeHeightfieldShape* FBulletLandscapeHeightfieldShape::Create(const ULandscapeHeightfieldCollisionComponent* Component, FTransform& OutTransform)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletCreateLandscapeShape);
+
+	if (!Component->HeightfieldRef.IsValid() || !Component->HeightfieldRef->HeightfieldGeometry.IsValid())
+	{
+		UE_LOG(LogBullet, Warning, TEXT("FBulletLandscapeHeightfieldShape::Create: %s has no collision heightfield"), *Component->GetName());
+		return nullptr;
+	}
+
+	const Chaos::FHeightFieldPtr& Heightfield = Component->HeightfieldRef->HeightfieldGeometry;
+	const Chaos::FHeightField::FDataType& Data = Heightfield->GeomData;
+	if (Data.NumCols < 2 || Data.NumRows < 2 || Data.Heights.Num() != Data.NumCols * Data.NumRows)
+	{
+		return nullptr;
+	}
+
+	// Bullet wants the exact height range for its bounds, one pass over the samples is cheaper than copying them
+	uint16 MinSample = TNumericLimits<uint16>::Max();
+	uint16 MaxSample = 0;
+	for (const uint16 Sample : Data.Heights)
+	{
+		MinSample = FMath::Min(MinSample, Sample);
+		MaxSample = FMath::Max(MaxSample, Sample);
+	}
+	const btScalar MinHeight = btScalar(Data.MinValue + MinSample * Data.HeightPerUnit);
+	const btScalar MaxHeight = btScalar(Data.MinValue + MaxSample * Data.HeightPerUnit);
+
+	FBulletLandscapeHeightfieldShape* Shape = new FBulletLandscapeHeightfieldShape(Heightfield, MinHeight, MaxHeight);
+
+	// Heightfield samples are CollisionScale apart and LANDSCAPE_ZSCALE per height unit in component space, the same scale Chaos puts on them
+	const FVector SampleScale(Component->CollisionScale, Component->CollisionScale, LANDSCAPE_ZSCALE);
+	const FTransform& ComponentTransform = Component->GetComponentTransform();
+	Shape->setLocalScaling(BulletHelpers::ToBtSize(SampleScale * ComponentTransform.GetScale3D()));
+	Shape->buildAccelerator();
+
+	// The shape's origin is the middle of its bounds, find where that is in the component and carry it to world space
+	const FVector LocalCenter = FVector((Data.NumCols - 1) * 0.5, (Data.NumRows - 1) * 0.5, (MinHeight + MaxHeight) * 0.5) * SampleScale;
+	OutTransform = FTransform(ComponentTransform.GetRotation(), ComponentTransform.TransformPosition(LocalCenter));
+	return Shape;
+}
@@ -8,6 +8,7 @@
 #include "NetworkPredictionModelDef.h"
 #include "NetworkPredictionModelDefRegistry.h"
 #include "NetworkPredictionWorldManager.h"
+#include "Core/DataTypes/BulletDataModelTypes.h"
 #include "Core/Simulation/BulletPhysicsEngineSimComp.h"
 #include "Core/Singletons/BulletPhysicsWorldSubsystem.h"
 
@@ -55,14 +56,56 @@ UBulletLiaisonComponent::UBulletLiaisonComponent()
 
 void UBulletLiaisonComponent::ProduceInput(const int32 DeltaTimeMS, FBulletInputCmdContext* Cmd)
 {
+	if (!SimulationComponent) return;
+	
+	SimulationComponent->ProduceInput(DeltaTimeMS, Cmd);
 }
 
 void UBulletLiaisonComponent::RestoreFrame(const FBulletSyncState* SyncState, const FBulletAuxStateContext* AuxState)
 {
+	if (!SimulationComponent) return;
+	
+	FBulletTimeStep NewBaseTimeStep;
+	NewBaseTimeStep.ServerFrame = NetworkPredictionProxy.GetPendingFrame();
+	NewBaseTimeStep.BaseSimTimeMs = NetworkPredictionProxy.GetTotalSimTimeMS();
+	
+	// Outputs of frames we're going back over are rewritten by the resim
+	PendingOutputSync = nullptr;
+	
+	// Rewind the shared world to the start of the frame we're about to resimulate. Only the first sim in the rollback actually restores it
+	if (UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>())
+	{
+		B->RestoreWorldSnapshot(NewBaseTimeStep.ServerFrame);
+		
+		// The snapshot only holds what we predicted, the state we were corrected to goes on top of it
+		const FBulletDefaultSyncState* DefaultSync = SyncState ? SyncState->DataCollection.FindDataByType<FBulletDefaultSyncState>() : nullptr;
+		if (RigidBody.IsSet() && DefaultSync)
+		{
+			const FTransform CorrectedTransform(DefaultSync->GetOrientation_WorldSpace(), DefaultSync->GetLocation_WorldSpace());
+			// SetPhysicsState takes angular velocity with the same x100 scaling as linear velocity
+			const FVector AngularVelocityDegrees = DefaultSync->GetAngularVelocityDegrees_WorldSpace();
+			const FVector AngularVelocity = FVector(
+				FMath::DegreesToRadians(AngularVelocityDegrees.X) * BULLET_TO_WORLD_SCALE,
+				FMath::DegreesToRadians(AngularVelocityDegrees.Y) * BULLET_TO_WORLD_SCALE,
+				FMath::DegreesToRadians(AngularVelocityDegrees.Z) * BULLET_TO_WORLD_SCALE);
+			FVector UnusedForce;
+			B->SetPhysicsState(RigidBody, CorrectedTransform, DefaultSync->GetVelocity_WorldSpace(), AngularVelocity, UnusedForce);
+		}
+		
+		bBodySleeping = B->IsRigidBodySleeping(RigidBody);
+		LastSteppedFrame = INDEX_NONE;
+		// The state at the start of a frame is what the previous frame's step produced
+		OnBulletWorldStepped(NewBaseTimeStep.ServerFrame - 1, 0.f);
+	}
+	
+	SimulationComponent->RestoreFrame(SyncState, AuxState, NewBaseTimeStep);
 }
 
 void UBulletLiaisonComponent::FinalizeFrame(const FBulletSyncState* SyncState, const FBulletAuxStateContext* AuxState)
 {
+	if (!SimulationComponent) return;
+	
+	SimulationComponent->FinalizeFrame(SyncState, AuxState);
 }
 
 void UBulletLiaisonComponent::InitializeSimulationState(FBulletSyncState* OutSync, FBulletAuxStateContext* OutAux)
@@ -70,10 +113,33 @@ void UBulletLiaisonComponent::InitializeSimulationState(FBulletSyncState* OutSyn
 	//TODO:@GreggoryAddison::Init | Register my dynamic rigid body with the Bullet Physics World
 
 	if (!SimulationComponent) return;
-	if (UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>())
+	
+	UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>();
+	if (B && !WorldSteppedHandle.IsValid())
+	{
+		// Every sim ticks the world, so the last one to finish a frame is the one that steps it
+		WorldSteppedHandle = B->OnWorldStepped.AddUObject(this, &UBulletLiaisonComponent::OnBulletWorldStepped);
+		B->AddSteppingSim();
+	}
+	
+	// Kinematic characters only sweep the world, they have no body of their own in it
+	if (SimulationComponent->IsKinematicCharacter())
 	{
-		int32 DummyId;
-		B->RegisterDynamicRigidBody(SimulationComponent->GetOwner(), 0.5, 0, 10.f, false, DummyId);
+		SimulationComponent->InitializeSimulationState(OutSync, OutAux);
+		return;
+	}
+	
+	if (B)
+	{
+		B->RegisterDynamicRigidBody(SimulationComponent->GetOwner(), 0.5, 0, 10.f, false, ActivationPolicy, RigidBody);
+		// Our NP id is the same on the server and every client, unlike the name of a spawned actor
+		B->SetRigidBodyNetworkId(RigidBody, (int32)NetworkPredictionProxy.GetID());
+		bBodySleeping = false;
+		
+		if (!ActivationEventsHandle.IsValid())
+		{
+			ActivationEventsHandle = B->OnActivationEvents.AddUObject(this, &UBulletLiaisonComponent::OnBulletActivationEvents);
+		}
 	}
 }
 
@@ -81,6 +147,36 @@ void UBulletLiaisonComponent::SimulationTick(const FNetSimTimeStep& TimeStep, co
 {
 	if (!SimulationComponent) return;
 	
+	if (SimulationComponent->IsKinematicCharacter())
+	{
+		FBulletTimeStep BulletTimeStep;
+		BulletTimeStep.ServerFrame = TimeStep.Frame;
+		BulletTimeStep.BaseSimTimeMs = TimeStep.TotalSimulationTime;
+		BulletTimeStep.StepMs = TimeStep.StepMS;
+		
+		// The world is only stepped once every sim has ticked the frame, so the character sweeps it as it stands at the start of this frame
+		// whichever order the sims tick in
+		UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>();
+		if (B)
+		{
+			B->RequestWorldStep(TimeStep.Frame, TimeStep.StepMS * 0.001f);
+		}
+		
+		const FBulletTickStartData StartData(*SimInput.Cmd, *SimInput.Sync, *SimInput.Aux);
+		FBulletTickEndData EndData;
+		SimulationComponent->SimulationTick(BulletTimeStep, StartData, EndData);
+		*SimOutput.Sync = EndData.SyncState;
+		
+		// The world hash goes in once the frame has been stepped
+		PendingOutputSync = SimOutput.Sync;
+		PendingOutputFrame = TimeStep.Frame;
+		if (B)
+		{
+			B->FinishSimTick(TimeStep.Frame);
+		}
+		return;
+	}
+	
 	const float TriggerTime = 30.f;
 	int32 Seed = 200;
 	if (!bIsFirstTick)
@@ -117,17 +213,102 @@ void UBulletLiaisonComponent::SimulationTick(const FNetSimTimeStep& TimeStep, co
 	const FVector Direction = (TargetLocation - Center).GetSafeNormal();
 	
 	// Add linear force in the "Direction" 
-	if (UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>())
+	UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>();
+	if (B)
 	{
-		B->AddForce(SimulationComponent->GetOwner(), Direction * 500.f, Center);
+		// The world is stepped once for this frame no matter how many Bullet sims tick it. Asking first flushes the previous frame's step if
+		// it is somehow still pending, otherwise a force for this frame would be picked up by that step
+		B->RequestWorldStep(TimeStep.Frame, TimeStep.StepMS * 0.001f);
 		
-	// call StepPhysics in our bullet world
-		B->StepPhysics(TimeStep.StepMS * 0.001f);
+		// Forces accumulate on the body until the world is stepped, so this only queues them for this frame
+		B->AddForce(SimulationComponent->GetOwner(), Direction * 500.f, Center);
+	}
+	
+	// The body state this frame ends on is only known once the world has been stepped, which OnBulletWorldStepped writes into our output.
+	// NP doesn't touch the output until every sim of the frame has ticked, and the last of them steps the world
+	PendingOutputSync = SimOutput.Sync;
+	PendingOutputFrame = TimeStep.Frame;
+	if (B)
+	{
+		B->FinishSimTick(TimeStep.Frame);
 	}
 	
 	//TODO:@GreggoryAddison::TEST | Add simple forces to the owner's dynamic rb based on the input or even simpler a deterministic randomized vector force just to see what happens
 }
 
+void UBulletLiaisonComponent::WriteWorldStateHash(int32 SimFrame, FBulletSyncState& OutSyncState) const
+{
+	OutSyncState.WorldHashFrame = INDEX_NONE;
+	OutSyncState.WorldHash = 0;
+	OutSyncState.LocalWorldFrame = INDEX_NONE;
+	
+	UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>();
+	if (!B) return;
+	
+	// Whichever of our states the authority's hash is matched with, ours is looked up in this world by our own frame number
+	OutSyncState.WorldHashSource = B;
+	OutSyncState.LocalWorldFrame = SimFrame;
+	
+	uint32 Hash = 0;
+	if (B->GetReplicatedWorldStateHash(SimFrame, Hash))
+	{
+		OutSyncState.WorldHashFrame = SimFrame;
+		OutSyncState.WorldHash = Hash;
+	}
+}
+
+void UBulletLiaisonComponent::OnBulletWorldStepped(int32 SimFrame, float DeltaSeconds)
+{
+	if (RigidBody.IsSet())
+	{
+		// A sleeping body hasn't moved since we last read it
+		if (bBodySleeping && LastSteppedFrame != INDEX_NONE)
+		{
+			LastSteppedFrame = SimFrame;
+		}
+		else if (UBulletPhysicsWorldSubsystem* B = GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>())
+		{
+			FVector UnusedForce;
+			B->GetPhysicsState(RigidBody, LastSteppedTransform, LastSteppedVelocity, LastSteppedAngularVelocity, UnusedForce);
+			LastSteppedFrame = SimFrame;
+		}
+	}
+	
+	if (PendingOutputSync && PendingOutputFrame == SimFrame)
+	{
+		PublishSteppedState(SimFrame, *PendingOutputSync);
+	}
+	PendingOutputSync = nullptr;
+}
+
+void UBulletLiaisonComponent::PublishSteppedState(int32 SimFrame, FBulletSyncState& OutSync) const
+{
+	if (LastSteppedFrame == SimFrame)
+	{
+		FBulletDefaultSyncState& OutSyncState = OutSync.DataCollection.FindOrAddMutableDataByType<FBulletDefaultSyncState>();
+		// GetPhysicsState reports angular velocity with the same x100 scaling as linear velocity
+		const FVector AngularVelocityDegrees = FVector(
+			FMath::RadiansToDegrees(LastSteppedAngularVelocity.X * WORLD_TO_BULLET_SCALE),
+			FMath::RadiansToDegrees(LastSteppedAngularVelocity.Y * WORLD_TO_BULLET_SCALE),
+			FMath::RadiansToDegrees(LastSteppedAngularVelocity.Z * WORLD_TO_BULLET_SCALE));
+		OutSyncState.SetTransforms_WorldSpace(LastSteppedTransform.GetLocation(), LastSteppedTransform.Rotator(), LastSteppedVelocity, AngularVelocityDegrees);
+	}
+	
+	// A frame's output is the state the next frame starts from, which is the snapshot the step just recorded
+	WriteWorldStateHash(SimFrame + 1, OutSync);
+}
+
+void UBulletLiaisonComponent::OnBulletActivationEvents(TConstArrayView<FBulletActivationEvent> Events)
+{
+	for (const FBulletActivationEvent& Event : Events)
+	{
+		if (Event.Body == RigidBody)
+		{
+			bBodySleeping = Event.Type == EBulletActivationEventType::FellAsleep;
+		}
+	}
+}
+
 void UBulletLiaisonComponent::FinalizeSmoothingFrame(const FBulletSyncState* Sync, const FBulletAuxStateContext* AuxState)
 {
 }
@@ -198,6 +379,26 @@ void UBulletLiaisonComponent::BeginPlay()
 	
 }
 
+void UBulletLiaisonComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UBulletPhysicsWorldSubsystem* B = GetWorld() ? GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>() : nullptr)
+	{
+		if (WorldSteppedHandle.IsValid())
+		{
+			B->OnWorldStepped.Remove(WorldSteppedHandle);
+			B->RemoveSteppingSim();
+		}
+		B->OnActivationEvents.Remove(ActivationEventsHandle);
+		B->UnregisterRigidBody(RigidBody);
+	}
+	WorldSteppedHandle.Reset();
+	ActivationEventsHandle.Reset();
+	RigidBody.Reset();
+	PendingOutputSync = nullptr;
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 ENetworkPredictionLocalInputPolicy UBulletLiaisonComponent::GetLocalInputPolicy() const
 {
 	switch (GetOwner()->GetLocalRole())
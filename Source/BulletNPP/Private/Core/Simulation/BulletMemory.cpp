@@ -0,0 +1,139 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletMemory.h"
+
+#include "BulletLogChannels.h"
+#include "HAL/IConsoleManager.h"
+#include <atomic>
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "LinearMath/btAlignedAllocator.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+LLM_DEFINE_TAG(Bullet);
+
+namespace
+{
+	bool bInstalled = false;
+
+	std::atomic<int64> LiveBytes = 0;
+	std::atomic<int64> PeakBytes = 0;
+	std::atomic<int64> LiveAllocations = 0;
+
+	// Every block starts with a header ahead of what bullet gets, far enough to keep bullet's alignment. The size and offset sit right before bullet's pointer
+	struct FAllocationHeader
+	{
+		uint64 Size;
+		uint64 Offset;
+	};
+	static_assert(sizeof(FAllocationHeader) == 16, "The header has to fit the smallest offset");
+
+	void* AlignedAlloc(size_t Size, int Alignment)
+	{
+		LLM_SCOPE_BYTAG(Bullet);
+
+		const size_t Offset = FMath::Max<size_t>(Alignment, sizeof(FAllocationHeader));
+		uint8* Block = static_cast<uint8*>(FMemory::Malloc(Size + Offset, (uint32)Offset));
+		if (!Block)
+		{
+			return nullptr;
+		}
+
+		uint8* Ptr = Block + Offset;
+		FAllocationHeader* Header = reinterpret_cast<FAllocationHeader*>(Ptr) - 1;
+		Header->Size = Size;
+		Header->Offset = Offset;
+
+		const int64 Live = LiveBytes.fetch_add(Size, std::memory_order_relaxed) + Size;
+		LiveAllocations.fetch_add(1, std::memory_order_relaxed);
+		int64 Peak = PeakBytes.load(std::memory_order_relaxed);
+		while (Live > Peak && !PeakBytes.compare_exchange_weak(Peak, Live, std::memory_order_relaxed))
+		{
+		}
+		return Ptr;
+	}
+
+	void AlignedFree(void* Ptr)
+	{
+		if (!Ptr)
+		{
+			return;
+		}
+
+		const FAllocationHeader* Header = static_cast<FAllocationHeader*>(Ptr) - 1;
+		LiveBytes.fetch_sub(Header->Size, std::memory_order_relaxed);
+		LiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+		FMemory::Free(static_cast<uint8*>(Ptr) - Header->Offset);
+	}
+
+	// Only bullet's own aligned allocator uses these, and it's replaced above. Hooked as well so nothing of bullet's can reach the system malloc
+	void* Alloc(size_t Size)
+	{
+		return AlignedAlloc(Size, 16);
+	}
+
+	void LogMemory(const TArray<FString>& Args)
+	{
+		UE_LOG(LogBullet, Display, TEXT("bullet.Memory: %.2f MB live in %lld allocations, %.2f MB peak"),
+			FBulletMemory::GetLiveBytes() / (1024.0 * 1024.0), FBulletMemory::GetLiveAllocations(), FBulletMemory::GetPeakBytes() / (1024.0 * 1024.0));
+	}
+
+	FAutoConsoleCommand CmdMemory(
+		TEXT("bullet.Memory"),
+		TEXT("Logs how much memory bullet has allocated through FMemory. Add it to MemReportCommands to have it in every memreport"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&LogMemory));
+}
+
+void FBulletMemory::Install()
+{
+#if WITH_BULLET_UE_ALLOCATOR
+	if (bInstalled)
+	{
+		return;
+	}
+
+	btAlignedAllocSetCustom(Alloc, AlignedFree);
+	btAlignedAllocSetCustomAligned(AlignedAlloc, AlignedFree);
+	bInstalled = true;
+#endif
+}
+
+void FBulletMemory::Uninstall()
+{
+#if WITH_BULLET_UE_ALLOCATOR
+	if (!bInstalled)
+	{
+		return;
+	}
+
+	// Bullet's free would be handed our blocks, and the module's code has to stay around to free them anyway
+	if (LiveAllocations.load() != 0)
+	{
+		UE_LOG(LogBullet, Warning, TEXT("FBulletMemory::Uninstall: %lld bullet allocations (%lld bytes) are still alive, leaving the allocator hooked"), LiveAllocations.load(), LiveBytes.load());
+		return;
+	}
+
+	// Null puts back bullet's defaults
+	btAlignedAllocSetCustomAligned(nullptr, nullptr);
+	btAlignedAllocSetCustom(nullptr, nullptr);
+	bInstalled = false;
+#endif
+}
+
+int64 FBulletMemory::GetLiveBytes()
+{
+	return LiveBytes.load(std::memory_order_relaxed);
+}
+
+int64 FBulletMemory::GetPeakBytes()
+{
+	return PeakBytes.load(std::memory_order_relaxed);
+}
+
+int64 FBulletMemory::GetLiveAllocations()
+{
+	return LiveAllocations.load(std::memory_order_relaxed);
+}
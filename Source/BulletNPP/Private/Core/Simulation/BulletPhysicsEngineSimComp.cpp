@@ -4,7 +4,12 @@
 #include "Core/Simulation/BulletPhysicsEngineSimComp.h"
 
 #include "BulletLogChannels.h"
+#include "Components/CapsuleComponent.h"
+#include "Core/DataTypes/BulletDataModelTypes.h"
+#include "Core/Simulation/BulletBlackboard.h"
+#include "Core/Simulation/BulletCharacterMovement.h"
 #include "Core/Simulation/BulletLiaisonComponent.h"
+#include "Core/Singletons/BulletPhysicsWorldSubsystem.h"
 
 
 // Sets default values for this component's properties
@@ -27,6 +32,8 @@ void UBulletPhysicsEngineSimComp::InitializeComponent()
 {
 	Super::InitializeComponent();
 	
+	SimBlackboard = NewObject<UBulletBlackboard>(this, TEXT("SimBlackboard"), RF_Transient);
+	
 	
 	// Instantiate our sister backend component that will actually talk to the system driving the simulation
 	if (BackendClass)
@@ -49,6 +56,11 @@ void UBulletPhysicsEngineSimComp::InitializeComponent()
 
 void UBulletPhysicsEngineSimComp::UninitializeComponent()
 {
+	if (SimBlackboard)
+	{
+		SimBlackboard->InvalidateAll();
+	}
+	
 	Super::UninitializeComponent();
 }
 
@@ -69,16 +81,40 @@ void UBulletPhysicsEngineSimComp::PostLoad()
 
 void UBulletPhysicsEngineSimComp::ProduceInput(const int32 DeltaTimeMS, FBulletInputCmdContext* Cmd)
 {
+	AActor* Owner = GetOwner();
+	if (Cmd && Owner && Owner->Implements<UBulletInputProducerInterface>())
+	{
+		IBulletInputProducerInterface::Execute_ProduceInput(Owner, DeltaTimeMS, *Cmd);
+	}
 }
 
 void UBulletPhysicsEngineSimComp::RestoreFrame(const FBulletSyncState* SyncState,
 	const FBulletAuxStateContext* AuxState, const FBulletTimeStep& NewBaseTimeStep)
 {
+	// Floors and the like were found on frames we're about to simulate again, possibly differently
+	if (SimBlackboard)
+	{
+		SimBlackboard->Invalidate(BulletPhysicsEngine::EInvalidationReason::Rollback);
+	}
 }
 
 void UBulletPhysicsEngineSimComp::FinalizeFrame(const FBulletSyncState* SyncState,
 	const FBulletAuxStateContext* AuxState)
 {
+	if (!bKinematicCharacter || !SyncState) return;
+	
+	USceneComponent* UpdatedComponent = GetUpdatedComponent();
+	const FBulletDefaultSyncState* DefaultSync = SyncState->DataCollection.FindDataByType<FBulletDefaultSyncState>();
+	if (UpdatedComponent && DefaultSync)
+	{
+		// The simulation already resolved collision against the Bullet world, the component just follows it
+		UpdatedComponent->SetWorldLocationAndRotation(DefaultSync->GetLocation_WorldSpace(), DefaultSync->GetOrientation_WorldSpace(), false, nullptr, ETeleportType::TeleportPhysics);
+	}
+	
+	if (AuxState)
+	{
+		OnPostFinalize.Broadcast(*SyncState, *AuxState);
+	}
 }
 
 void UBulletPhysicsEngineSimComp::FinalizeUnchangedFrame()
@@ -98,15 +134,109 @@ void UBulletPhysicsEngineSimComp::TickInterpolatedSimProxy(const FBulletTimeStep
 
 void UBulletPhysicsEngineSimComp::InitializeSimulationState(FBulletSyncState* OutSync, FBulletAuxStateContext* OutAux)
 {
+	if (!OutSync) return;
+	
+	FBulletDefaultSyncState& DefaultSync = OutSync->DataCollection.FindOrAddMutableDataByType<FBulletDefaultSyncState>();
+	if (const USceneComponent* UpdatedComponent = GetUpdatedComponent())
+	{
+		DefaultSync.SetTransforms_WorldSpace(UpdatedComponent->GetComponentLocation(), UpdatedComponent->GetComponentRotation(), FVector::ZeroVector, FVector::ZeroVector);
+	}
+	
+	// Falling finds the floor on the first tick if we start out standing on one
+	OutSync->MovementMode = BulletDefaultModeNames::Falling;
 }
 
 void UBulletPhysicsEngineSimComp::SimulationTick(const FBulletTimeStep& InTimeStep, const FBulletTickStartData& SimInput, FBulletTickEndData& SimOutput)
 {
+	SimOutput.SyncState = SimInput.SyncState;
+	SimOutput.AuxState = SimInput.AuxState;
+	SimOutput.InitForNewFrame();
+	
+	if (!bKinematicCharacter) return;
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletCharacterSimulationTick);
+	
+	const FBulletDefaultSyncState* StartSync = SimInput.SyncState.DataCollection.FindDataByType<FBulletDefaultSyncState>();
+	const UBulletPhysicsWorldSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<UBulletPhysicsWorldSubsystem>() : nullptr;
+	if (!StartSync || !Subsystem || !Subsystem->GetBulletWorld()) return;
+	
+	const float DeltaSeconds = InTimeStep.StepMs * 0.001f;
+	
+	FVector MoveIntent = FVector::ZeroVector;
+	FVector OrientationIntent = FVector::ZeroVector;
+	bool bJumpPressed = false;
+	if (const FBulletDefaultInputs* Inputs = SimInput.InputCmd.DataCollection.FindDataByType<FBulletDefaultInputs>())
+	{
+		switch (Inputs->GetMoveInputType())
+		{
+		case EBulletMoveInputType::DirectionalIntent:
+			MoveIntent = Inputs->GetMoveInput_WorldSpace();
+			break;
+		case EBulletMoveInputType::Velocity:
+			MoveIntent = CharacterSettings.MaxSpeed > 0.f ? Inputs->GetMoveInput_WorldSpace() / CharacterSettings.MaxSpeed : FVector::ZeroVector;
+			break;
+		default:
+			break;
+		}
+		OrientationIntent = Inputs->GetOrientationIntentDir_WorldSpace();
+		bJumpPressed = Inputs->bIsJumpJustPressed;
+	}
+	
+	FBulletCharacterState State;
+	State.Mode = SimInput.SyncState.MovementMode.IsNone() ? BulletDefaultModeNames::Falling : SimInput.SyncState.MovementMode;
+	State.Location = StartSync->GetLocation_WorldSpace();
+	State.Velocity = StartSync->GetVelocity_WorldSpace();
+	// Only reused if it was found from exactly where we are now, so a floor left over from another frame is never trusted
+	if (SimBlackboard)
+	{
+		SimBlackboard->TryGet(BulletCommonBlackboard::LastFloorResult, State.Floor);
+	}
+	
+	float Radius, HalfHeight;
+	GetCapsuleSize(Radius, HalfHeight);
+	const FBulletCharacterMovement Movement(Subsystem->GetBulletWorld(), Subsystem->GetWorldOrigin(), CharacterSettings, Radius, HalfHeight);
+	Movement.Tick(State, MoveIntent, bJumpPressed, DeltaSeconds);
+	
+	FRotator Orientation = StartSync->GetOrientation_WorldSpace();
+	if (!OrientationIntent.IsNearlyZero())
+	{
+		Orientation.Yaw = FMath::FixedTurn(Orientation.Yaw, OrientationIntent.Rotation().Yaw, CharacterSettings.TurningRate * DeltaSeconds);
+	}
+	
+	FBulletDefaultSyncState& EndSync = SimOutput.SyncState.DataCollection.FindOrAddMutableDataByType<FBulletDefaultSyncState>();
+	EndSync.SetTransforms_WorldSpace(State.Location, Orientation, State.Velocity, FVector::ZeroVector);
+	SimOutput.MoveRecord.SetDeltaSeconds(DeltaSeconds);
+	SimOutput.MoveRecord.Append(FBulletMovementSubstep(State.Mode, State.Location - StartSync->GetLocation_WorldSpace()));
+	
+	if (State.Mode != SimInput.SyncState.MovementMode)
+	{
+		SimOutput.SyncState.MovementMode = State.Mode;
+		SimOutput.MovementEndState.NextModeName = State.Mode;
+		OnMovementModeChanged.Broadcast(SimInput.SyncState.MovementMode, State.Mode);
+	}
+	
+	if (SimBlackboard)
+	{
+		SimBlackboard->Set(BulletCommonBlackboard::LastFloorResult, State.Floor);
+	}
 }
 
 USceneComponent* UBulletPhysicsEngineSimComp::GetUpdatedComponent() const
 {
-	return nullptr;
+	return GetOwner() ? GetOwner()->GetRootComponent() : nullptr;
+}
+
+void UBulletPhysicsEngineSimComp::GetCapsuleSize(float& OutRadius, float& OutHalfHeight) const
+{
+	if (const UCapsuleComponent* Capsule = Cast<UCapsuleComponent>(GetUpdatedComponent()))
+	{
+		OutRadius = Capsule->GetScaledCapsuleRadius();
+		OutHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+		return;
+	}
+	
+	OutRadius = CharacterSettings.CapsuleRadius;
+	OutHalfHeight = CharacterSettings.CapsuleHalfHeight;
 }
 
 
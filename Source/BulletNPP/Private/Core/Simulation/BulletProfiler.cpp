@@ -0,0 +1,178 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletProfiler.h"
+
+#include "Core/Simulation/BulletMemory.h"
+#include "Core/Singletons/BulletPhysicsWorldSubsystem.h"
+
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "LinearMath/btQuickprof.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+DECLARE_STATS_GROUP(TEXT("Bullet"), STATGROUP_Bullet, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Manifold Pool Used"), STAT_BulletManifoldPoolUsed, STATGROUP_Bullet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Manifold Pool Peak"), STAT_BulletManifoldPoolPeak, STATGROUP_Bullet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Manifold Pool Overflow"), STAT_BulletManifoldPoolOverflow, STATGROUP_Bullet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Algorithm Pool Used"), STAT_BulletAlgorithmPoolUsed, STATGROUP_Bullet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Algorithm Pool Peak"), STAT_BulletAlgorithmPoolPeak, STATGROUP_Bullet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Algorithm Pool Overflow"), STAT_BulletAlgorithmPoolOverflow, STATGROUP_Bullet);
+
+#if WITH_BULLET_INSIGHTS
+
+TRACE_DECLARE_INT_COUNTER(BulletOverlappingPairs, TEXT("Bullet/Overlapping Pairs"));
+TRACE_DECLARE_INT_COUNTER(BulletManifolds, TEXT("Bullet/Manifolds"));
+TRACE_DECLARE_INT_COUNTER(BulletContacts, TEXT("Bullet/Contacts"));
+TRACE_DECLARE_INT_COUNTER(BulletIslands, TEXT("Bullet/Islands"));
+TRACE_DECLARE_INT_COUNTER(BulletActiveBodies, TEXT("Bullet/Active Bodies"));
+TRACE_DECLARE_INT_COUNTER(BulletSolverIterations, TEXT("Bullet/Solver Iterations"));
+TRACE_DECLARE_MEMORY_COUNTER(BulletHeapBytes, TEXT("Bullet/Heap"));
+TRACE_DECLARE_INT_COUNTER(BulletManifoldPoolUsed, TEXT("Bullet/Manifold Pool Used"));
+TRACE_DECLARE_INT_COUNTER(BulletManifoldPoolOverflow, TEXT("Bullet/Manifold Pool Overflow"));
+TRACE_DECLARE_INT_COUNTER(BulletAlgorithmPoolUsed, TEXT("Bullet/Algorithm Pool Used"));
+TRACE_DECLARE_INT_COUNTER(BulletAlgorithmPoolOverflow, TEXT("Bullet/Algorithm Pool Overflow"));
+
+namespace
+{
+	btEnterProfileZoneFunc* PreviousEnterZone = nullptr;
+	btLeaveProfileZoneFunc* PreviousLeaveZone = nullptr;
+
+	// Zones nest deeper than this in no bullet code path, anything past it just isn't traced
+	constexpr int32 MaxTracedZoneDepth = 64;
+
+	// Which of the zones open on this thread began a scope, a bit per nesting level. The channel can be toggled with zones open,
+	// and every leave has to match what its enter did
+	thread_local uint64 TracedZones = 0;
+	thread_local int32 ZoneDepth = 0;
+
+	void EnterZone(const char* Name)
+	{
+		const uint64 ZoneBit = ZoneDepth < MaxTracedZoneDepth ? uint64(1) << ZoneDepth : 0;
+		if (ZoneBit && UE_TRACE_CHANNELEXPR_IS_ENABLED(CpuChannel))
+		{
+			// Bullet's zone names are all literals, trace caches the event type for each
+			FCpuProfilerTrace::OutputBeginDynamicEvent(Name);
+			TracedZones |= ZoneBit;
+		}
+		else
+		{
+			TracedZones &= ~ZoneBit;
+		}
+		++ZoneDepth;
+	}
+
+	void LeaveZone()
+	{
+		// A zone entered before Install has nothing to close
+		if (ZoneDepth == 0)
+		{
+			return;
+		}
+
+		--ZoneDepth;
+		if (ZoneDepth < MaxTracedZoneDepth && (TracedZones & (uint64(1) << ZoneDepth)))
+		{
+			FCpuProfilerTrace::OutputEndEvent();
+		}
+	}
+}
+
+#endif
+
+void FBulletProfiler::Install()
+{
+#if WITH_BULLET_INSIGHTS
+	if (PreviousEnterZone)
+	{
+		return;
+	}
+
+	PreviousEnterZone = btGetCurrentEnterProfileZoneFunc();
+	PreviousLeaveZone = btGetCurrentLeaveProfileZoneFunc();
+	btSetCustomEnterProfileZoneFunc(EnterZone);
+	btSetCustomLeaveProfileZoneFunc(LeaveZone);
+#endif
+}
+
+void FBulletProfiler::Uninstall()
+{
+#if WITH_BULLET_INSIGHTS
+	if (!PreviousEnterZone)
+	{
+		return;
+	}
+
+	btSetCustomEnterProfileZoneFunc(PreviousEnterZone);
+	btSetCustomLeaveProfileZoneFunc(PreviousLeaveZone);
+	PreviousEnterZone = nullptr;
+	PreviousLeaveZone = nullptr;
+#endif
+}
+
+void FBulletProfiler::ReportWorldCounters(btDiscreteDynamicsWorld* World)
+{
+#if WITH_BULLET_INSIGHTS && COUNTERSTRACE_ENABLED
+	if (!World || !UE_TRACE_CHANNELEXPR_IS_ENABLED(CountersChannel))
+	{
+		return;
+	}
+
+	btDispatcher* Dispatcher = World->getDispatcher();
+	int32 NumContacts = 0;
+	for (int32 i = 0; i < Dispatcher->getNumManifolds(); ++i)
+	{
+		NumContacts += Dispatcher->getManifoldByIndexInternal(i)->getNumContacts();
+	}
+
+	// Statics are left out of bullet's union find, and the step left it sorted by island, so every change of id starts another one
+	const btUnionFind& UnionFind = World->getSimulationIslandManager()->getUnionFind();
+	int32 NumIslands = 0;
+	for (int32 i = 0; i < UnionFind.getNumElements(); ++i)
+	{
+		NumIslands += (i == 0 || UnionFind.getElement(i).m_id != UnionFind.getElement(i - 1).m_id) ? 1 : 0;
+	}
+
+	int32 NumActiveBodies = 0;
+	const btCollisionObjectArray& Objects = World->getCollisionObjectArray();
+	for (int32 i = 0; i < Objects.size(); ++i)
+	{
+		NumActiveBodies += (!Objects[i]->isStaticOrKinematicObject() && Objects[i]->isActive()) ? 1 : 0;
+	}
+
+	// Every world reports to the same counters, so with several stepping (a listen server and its PIE clients) they show whichever stepped last
+	TRACE_COUNTER_SET(BulletOverlappingPairs, World->getBroadphase()->getOverlappingPairCache()->getNumOverlappingPairs());
+	TRACE_COUNTER_SET(BulletManifolds, Dispatcher->getNumManifolds());
+	TRACE_COUNTER_SET(BulletContacts, NumContacts);
+	TRACE_COUNTER_SET(BulletIslands, NumIslands);
+	TRACE_COUNTER_SET(BulletActiveBodies, NumActiveBodies);
+	TRACE_COUNTER_SET(BulletSolverIterations, World->getSolverInfo().m_numIterations);
+	// Process wide, every world's bullet allocations together
+	TRACE_COUNTER_SET(BulletHeapBytes, FBulletMemory::GetLiveBytes());
+#endif
+}
+
+void FBulletProfiler::ReportPoolStats(const FBulletCollisionPoolStats& Manifolds, const FBulletCollisionPoolStats& Algorithms)
+{
+	// Like the counters above, several worlds stepping share these
+	SET_DWORD_STAT(STAT_BulletManifoldPoolUsed, Manifolds.Used);
+	SET_DWORD_STAT(STAT_BulletManifoldPoolPeak, Manifolds.Peak);
+	SET_DWORD_STAT(STAT_BulletManifoldPoolOverflow, Manifolds.Overflow);
+	SET_DWORD_STAT(STAT_BulletAlgorithmPoolUsed, Algorithms.Used);
+	SET_DWORD_STAT(STAT_BulletAlgorithmPoolPeak, Algorithms.Peak);
+	SET_DWORD_STAT(STAT_BulletAlgorithmPoolOverflow, Algorithms.Overflow);
+
+#if WITH_BULLET_INSIGHTS && COUNTERSTRACE_ENABLED
+	TRACE_COUNTER_SET(BulletManifoldPoolUsed, Manifolds.Used);
+	TRACE_COUNTER_SET(BulletManifoldPoolOverflow, Manifolds.Overflow);
+	TRACE_COUNTER_SET(BulletAlgorithmPoolUsed, Algorithms.Used);
+	TRACE_COUNTER_SET(BulletAlgorithmPoolOverflow, Algorithms.Overflow);
+#endif
+}
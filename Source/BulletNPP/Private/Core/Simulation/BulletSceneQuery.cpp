@@ -0,0 +1,302 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletSceneQuery.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Components/PrimitiveComponent.h"
+#include "Core/Libraries/BulletMathLibrary.h"
+#include "GameFramework/Actor.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	// Ray in the form btRayAabb2 wants it, distances along it are in bullet units
+	struct FQueryRay
+	{
+		btVector3 From;
+		btVector3 Direction;
+		btVector3 InvDirection;
+		unsigned int Signs[3];
+		btScalar Length;
+
+		FQueryRay(const btVector3& InFrom, const btVector3& InTo)
+			: From(InFrom)
+		{
+			Direction = InTo - InFrom;
+			Length = Direction.length();
+			if (Length > SIMD_EPSILON)
+			{
+				Direction /= Length;
+			}
+			for (int i = 0; i < 3; ++i)
+			{
+				InvDirection[i] = Direction[i] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / Direction[i];
+				Signs[i] = InvDirection[i] < btScalar(0.0);
+			}
+		}
+	};
+
+	/**
+	 * Same walk as btDbvt::rayTestInternal, apart from visiting the nearer child first and clipping the ray to ClosestFraction as it goes.
+	 * Leaf is expected to lower ClosestFraction when it finds something closer. AabbMin/AabbMax inflate every node by a swept shape's bounds.
+	 */
+	template <typename LeafFunctionType>
+	void WalkTree(const btDbvtNode* Root, const FQueryRay& Ray, const btVector3& AabbMin, const btVector3& AabbMax, const btScalar& ClosestFraction, TArray<const btDbvtNode*>& Stack, const LeafFunctionType& Leaf)
+	{
+		if (!Root) return;
+
+		Stack.Reset();
+		Stack.Add(Root);
+		while (Stack.Num() > 0)
+		{
+			const btDbvtNode* Node = Stack.Pop(EAllowShrinking::No);
+			const btVector3 Bounds[2] = { Node->volume.Mins() - AabbMax, Node->volume.Maxs() - AabbMin };
+			btScalar TMin = 1;
+			if (!btRayAabb2(Ray.From, Ray.InvDirection, Ray.Signs, Bounds, TMin, 0, ClosestFraction * Ray.Length))
+			{
+				continue;
+			}
+
+			if (Node->isinternal())
+			{
+				// Popped in reverse, so the child nearer the ray origin goes on last
+				const bool bFirstChildNearer = (Node->childs[1]->volume.Center() - Node->childs[0]->volume.Center()).dot(Ray.Direction) >= 0;
+				Stack.Add(Node->childs[bFirstChildNearer ? 1 : 0]);
+				Stack.Add(Node->childs[bFirstChildNearer ? 0 : 1]);
+			}
+			else
+			{
+				Leaf(static_cast<btBroadphaseProxy*>(Node->data));
+			}
+		}
+	}
+
+	template <typename LeafFunctionType>
+	void WalkBroadphase(const btDbvtBroadphase* Broadphase, const FQueryRay& Ray, const btVector3& AabbMin, const btVector3& AabbMax, const btScalar& ClosestFraction, TArray<const btDbvtNode*>& Stack, const LeafFunctionType& Leaf)
+	{
+		// Dynamic and static proxies live in separate trees
+		WalkTree(Broadphase->m_sets[0].m_root, Ray, AabbMin, AabbMax, ClosestFraction, Stack, Leaf);
+		WalkTree(Broadphase->m_sets[1].m_root, Ray, AabbMin, AabbMax, ClosestFraction, Stack, Leaf);
+	}
+
+	// The subsystem always builds its world on a btDbvtBroadphase
+	const btDbvtBroadphase* GetDbvtBroadphase(btCollisionWorld* World)
+	{
+		return static_cast<const btDbvtBroadphase*>(World->getBroadphase());
+	}
+
+	// A query's IgnoreActors and ObjectChannelMask, the user pointer of every object the subsystem adds is its owning actor
+	template <typename QueryType>
+	bool PassesFilter(const QueryType& Query, const btCollisionObject* Object)
+	{
+		if (Query.ObjectChannelMask != 0 && !(Query.ObjectChannelMask & ECC_TO_BITFIELD(FBulletSceneQuery::GetObjectChannel(Object))))
+		{
+			return false;
+		}
+		return Query.IgnoreActors.Num() == 0 || !Query.IgnoreActors.Contains(static_cast<AActor*>(Object->getUserPointer()));
+	}
+}
+
+void FBulletSceneQuery::SetObjectChannel(btCollisionObject* Object, const AActor* Owner, ECollisionChannel DefaultChannel)
+{
+	const UPrimitiveComponent* Root = Owner ? Cast<UPrimitiveComponent>(Owner->GetRootComponent()) : nullptr;
+	const ECollisionChannel Channel = Root ? Root->GetCollisionObjectType() : DefaultChannel;
+	// Bullet starts every user index at -1
+	const int Value = Object->getUserIndex3();
+	Object->setUserIndex3((Value > 0 ? Value & 0xff : 0) | ((int)Channel << 8));
+}
+
+ECollisionChannel FBulletSceneQuery::GetObjectChannel(const btCollisionObject* Object)
+{
+	const int Value = Object->getUserIndex3();
+	return Value > 0 ? (ECollisionChannel)((Value >> 8) & 0xff) : ECC_WorldStatic;
+}
+
+template <typename FunctionType>
+void FBulletSceneQuery::ForEachQuery(int32 NumQueries, bool bParallel, const FunctionType& Function)
+{
+	const int32 MaxChunks = bParallel && FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1;
+	const int32 NumChunks = FMath::Clamp(FMath::DivideAndRoundUp(NumQueries, MinQueriesPerChunk), 1, MaxChunks);
+	if (ChunkStacks.Num() < NumChunks)
+	{
+		ChunkStacks.SetNum(NumChunks);
+	}
+
+	const int32 QueriesPerChunk = FMath::DivideAndRoundUp(NumQueries, NumChunks);
+	ParallelFor(NumChunks, [this, NumQueries, QueriesPerChunk, &Function](int32 Chunk)
+	{
+		TArray<const btDbvtNode*>& Stack = ChunkStacks[Chunk];
+		const int32 End = FMath::Min((Chunk + 1) * QueriesPerChunk, NumQueries);
+		for (int32 i = Chunk * QueriesPerChunk; i < End; ++i)
+		{
+			Function(i, Stack);
+		}
+	}, NumChunks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+void FBulletSceneQuery::Raycast(btCollisionWorld* World, const FVector& WorldOrigin, TConstArrayView<FBulletRaycast> Rays, TArrayView<FBulletQueryHit> OutHits, bool bParallel)
+{
+	check(OutHits.Num() == Rays.Num());
+	if (Rays.Num() == 0) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletRaycastBatch);
+
+	const btDbvtBroadphase* Broadphase = GetDbvtBroadphase(World);
+	ForEachQuery(Rays.Num(), bParallel, [&](int32 Index, TArray<const btDbvtNode*>& Stack)
+	{
+		const FBulletRaycast& Ray = Rays[Index];
+		const btVector3 From = BulletHelpers::ToBtPos(Ray.Start, WorldOrigin);
+		const btVector3 To = BulletHelpers::ToBtPos(Ray.End, WorldOrigin);
+		const btTransform FromTransform(btQuaternion::getIdentity(), From);
+		const btTransform ToTransform(btQuaternion::getIdentity(), To);
+
+		btCollisionWorld::ClosestRayResultCallback Callback(From, To);
+		WalkBroadphase(Broadphase, FQueryRay(From, To), btVector3(0, 0, 0), btVector3(0, 0, 0), Callback.m_closestHitFraction, Stack,
+			[&](btBroadphaseProxy* Proxy)
+			{
+				if (!Callback.needsCollision(Proxy)) return;
+				btCollisionObject* Object = static_cast<btCollisionObject*>(Proxy->m_clientObject);
+				if (!PassesFilter(Ray, Object)) return;
+				btCollisionWorld::rayTestSingle(FromTransform, ToTransform, Object, Object->getCollisionShape(), Object->getWorldTransform(), Callback);
+			});
+
+		FBulletQueryHit& Hit = OutHits[Index];
+		Hit = FBulletQueryHit();
+		if (Callback.hasHit())
+		{
+			Hit.bHit = true;
+			Hit.Time = Callback.m_closestHitFraction;
+			Hit.Location = BulletHelpers::ToUEPos(Callback.m_hitPointWorld, WorldOrigin);
+			Hit.Normal = BulletHelpers::ToUEDir(Callback.m_hitNormalWorld, false);
+			Hit.HitObject = Callback.m_collisionObject;
+		}
+	});
+}
+
+void FBulletSceneQuery::SphereSweep(btCollisionWorld* World, const FVector& WorldOrigin, TConstArrayView<FBulletSphereSweep> Sweeps, TArrayView<FBulletQueryHit> OutHits, bool bParallel)
+{
+	check(OutHits.Num() == Sweeps.Num());
+	if (Sweeps.Num() == 0) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletSphereSweepBatch);
+
+	const btDbvtBroadphase* Broadphase = GetDbvtBroadphase(World);
+	const btScalar AllowedPenetration = World->getDispatchInfo().m_allowedCcdPenetration;
+	ForEachQuery(Sweeps.Num(), bParallel, [&](int32 Index, TArray<const btDbvtNode*>& Stack)
+	{
+		const FBulletSphereSweep& Sweep = Sweeps[Index];
+		const btVector3 From = BulletHelpers::ToBtPos(Sweep.Start, WorldOrigin);
+		const btVector3 To = BulletHelpers::ToBtPos(Sweep.End, WorldOrigin);
+		const btTransform FromTransform(btQuaternion::getIdentity(), From);
+		const btTransform ToTransform(btQuaternion::getIdentity(), To);
+
+		const btScalar Radius = BulletHelpers::ToBtSize(Sweep.Radius);
+		btSphereShape CastShape(Radius);
+		const btVector3 Extent(Radius, Radius, Radius);
+
+		btCollisionWorld::ClosestConvexResultCallback Callback(From, To);
+		WalkBroadphase(Broadphase, FQueryRay(From, To), -Extent, Extent, Callback.m_closestHitFraction, Stack,
+			[&](btBroadphaseProxy* Proxy)
+			{
+				if (!Callback.needsCollision(Proxy)) return;
+				btCollisionObject* Object = static_cast<btCollisionObject*>(Proxy->m_clientObject);
+				if (!PassesFilter(Sweep, Object)) return;
+				btCollisionWorld::objectQuerySingle(&CastShape, FromTransform, ToTransform, Object, Object->getCollisionShape(), Object->getWorldTransform(), Callback, AllowedPenetration);
+			});
+
+		FBulletQueryHit& Hit = OutHits[Index];
+		Hit = FBulletQueryHit();
+		if (Callback.hasHit())
+		{
+			Hit.bHit = true;
+			Hit.Time = Callback.m_closestHitFraction;
+			Hit.Location = BulletHelpers::ToUEPos(Callback.m_hitPointWorld, WorldOrigin);
+			Hit.Normal = BulletHelpers::ToUEDir(Callback.m_hitNormalWorld, false);
+			Hit.HitObject = Callback.m_hitCollisionObject;
+		}
+	});
+}
+
+namespace
+{
+	// Only cares whether the pair actually touches, contactPairTest also reports points within the contact breaking threshold
+	struct FOverlapContactCallback : public btCollisionWorld::ContactResultCallback
+	{
+		bool bTouching = false;
+
+		virtual btScalar addSingleResult(btManifoldPoint& Point, const btCollisionObjectWrapper*, int, int, const btCollisionObjectWrapper*, int, int) override
+		{
+			bTouching |= Point.getDistance() <= btScalar(0.);
+			return 0;
+		}
+	};
+}
+
+void FBulletSceneQuery::SphereOverlap(btCollisionWorld* World, const FVector& WorldOrigin, TConstArrayView<FBulletSphereOverlap> Spheres, TArray<FBulletOverlapResult>& OutOverlaps)
+{
+	if (Spheres.Num() == 0) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletSphereOverlapBatch);
+
+	if (ChunkStacks.Num() == 0)
+	{
+		ChunkStacks.SetNum(1);
+	}
+	TArray<const btDbvtNode*>& Stack = ChunkStacks[0];
+
+	const btDbvtBroadphase* Broadphase = GetDbvtBroadphase(World);
+	btSphereShape SphereShape(1);
+	btCollisionObject SphereObject;
+	SphereObject.setCollisionShape(&SphereShape);
+
+	for (int32 Index = 0; Index < Spheres.Num(); ++Index)
+	{
+		const FBulletSphereOverlap& Sphere = Spheres[Index];
+		const btVector3 Center = BulletHelpers::ToBtPos(Sphere.Center, WorldOrigin);
+		const btScalar Radius = BulletHelpers::ToBtSize(Sphere.Radius);
+		SphereShape.setUnscaledRadius(Radius);
+		SphereObject.setWorldTransform(btTransform(btQuaternion::getIdentity(), Center));
+		const btDbvtVolume Volume = btDbvtVolume::FromCR(Center, Radius);
+
+		for (const btDbvt& Tree : Broadphase->m_sets)
+		{
+			if (!Tree.m_root) continue;
+
+			Stack.Reset();
+			Stack.Add(Tree.m_root);
+			while (Stack.Num() > 0)
+			{
+				const btDbvtNode* Node = Stack.Pop(EAllowShrinking::No);
+				if (!Intersect(Node->volume, Volume)) continue;
+
+				if (Node->isinternal())
+				{
+					Stack.Add(Node->childs[0]);
+					Stack.Add(Node->childs[1]);
+					continue;
+				}
+
+				btBroadphaseProxy* Proxy = static_cast<btBroadphaseProxy*>(Node->data);
+				FOverlapContactCallback Callback;
+				if (!Callback.needsCollision(Proxy)) continue;
+
+				btCollisionObject* Object = static_cast<btCollisionObject*>(Proxy->m_clientObject);
+				if (!PassesFilter(Sphere, Object)) continue;
+				World->contactPairTest(&SphereObject, Object, Callback);
+				if (Callback.bTouching)
+				{
+					FBulletOverlapResult& Overlap = OutOverlaps.AddDefaulted_GetRef();
+					Overlap.QueryIndex = Index;
+					Overlap.HitObject = Object;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,157 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletTaskScheduler.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+
+bool FBulletTaskScheduler::bActivated = false;
+
+namespace
+{
+	// Set by FScopedNumThreads, 0 when the thread has no override. Kept out of the class, thread_local data can't be dll exported
+	thread_local int32 ThreadNumThreads = 0;
+	
+	// How many of our loops the thread is running a part of. Only ever counts the loops of the world the thread is stepping
+	thread_local int32 ThreadLoopDepth = 0;
+	
+	struct FScopedLoopDepth
+	{
+		FScopedLoopDepth() { ++ThreadLoopDepth; }
+		~FScopedLoopDepth() { --ThreadLoopDepth; }
+	};
+}
+
+FBulletTaskScheduler::FBulletTaskScheduler()
+	: btITaskScheduler("UnrealTaskGraph")
+	, NumThreads(GetDefaultNumThreads())
+{
+}
+
+FBulletTaskScheduler& FBulletTaskScheduler::Get()
+{
+	static FBulletTaskScheduler Scheduler;
+	return Scheduler;
+}
+
+void FBulletTaskScheduler::Activate()
+{
+	check(IsInGameThread());
+	if (!bActivated)
+	{
+		btSetTaskScheduler(&Get());
+		bActivated = true;
+	}
+}
+
+void FBulletTaskScheduler::Shutdown()
+{
+	if (bActivated)
+	{
+		btSetTaskScheduler(nullptr);
+		bActivated = false;
+	}
+}
+
+int32 FBulletTaskScheduler::GetDefaultNumThreads()
+{
+	const int32 NumWorkers = FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() : 0;
+	return FMath::Clamp(NumWorkers + 1, 1, (int32)BT_MAX_THREAD_COUNT);
+}
+
+FBulletTaskScheduler::FScopedNumThreads::FScopedNumThreads(int32 InNumThreads)
+	: PreviousNumThreads(ThreadNumThreads)
+{
+	ThreadNumThreads = FMath::Clamp(InNumThreads > 0 ? InNumThreads : GetDefaultNumThreads(), 1, (int32)BT_MAX_THREAD_COUNT);
+}
+
+FBulletTaskScheduler::FScopedNumThreads::~FScopedNumThreads()
+{
+	ThreadNumThreads = PreviousNumThreads;
+}
+
+int32 FBulletTaskScheduler::GetActiveNumThreads() const
+{
+	return ThreadNumThreads > 0 ? ThreadNumThreads : NumThreads;
+}
+
+int FBulletTaskScheduler::getMaxNumThreads() const
+{
+	return BT_MAX_THREAD_COUNT;
+}
+
+int FBulletTaskScheduler::getNumThreads() const
+{
+	return GetActiveNumThreads();
+}
+
+void FBulletTaskScheduler::setNumThreads(int InNumThreads)
+{
+	NumThreads = FMath::Clamp(InNumThreads > 0 ? InNumThreads : GetDefaultNumThreads(), 1, (int32)BT_MAX_THREAD_COUNT);
+}
+
+void FBulletTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+	const int32 Count = iEnd - iBegin;
+	if (Count <= 0) return;
+
+	const int32 NumChunks = FMath::Min(GetActiveNumThreads(), FMath::DivideAndRoundUp(Count, FMath::Max(grainSize, 1)));
+	// A loop nested inside another of ours runs inline, the outer one already has every thread busy
+	if (NumChunks <= 1 || ThreadLoopDepth > 0)
+	{
+		body.forLoop(iBegin, iEnd);
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletParallelFor);
+
+	const int32 ChunkSize = FMath::DivideAndRoundUp(Count, NumChunks);
+	ParallelFor(TEXT("BulletParallelFor"), NumChunks, 1, [&body, iBegin, iEnd, ChunkSize](int32 Chunk)
+	{
+		FScopedLoopDepth LoopDepth;
+		const int32 Begin = iBegin + Chunk * ChunkSize;
+		const int32 End = FMath::Min(Begin + ChunkSize, iEnd);
+		if (Begin < End)
+		{
+			body.forLoop(Begin, End);
+		}
+	});
+}
+
+btScalar FBulletTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+{
+	const int32 Count = iEnd - iBegin;
+	if (Count <= 0) return btScalar(0);
+
+	const int32 NumChunks = FMath::Min(GetActiveNumThreads(), FMath::DivideAndRoundUp(Count, FMath::Max(grainSize, 1)));
+	if (NumChunks <= 1 || ThreadLoopDepth > 0)
+	{
+		return body.sumLoop(iBegin, iEnd);
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletParallelSum);
+
+	const int32 ChunkSize = FMath::DivideAndRoundUp(Count, NumChunks);
+	TArray<btScalar, TInlineAllocator<BT_MAX_THREAD_COUNT>> ChunkSums;
+	ChunkSums.SetNumZeroed(NumChunks);
+
+	ParallelFor(TEXT("BulletParallelSum"), NumChunks, 1, [&body, &ChunkSums, iBegin, iEnd, ChunkSize](int32 Chunk)
+	{
+		FScopedLoopDepth LoopDepth;
+		const int32 Begin = iBegin + Chunk * ChunkSize;
+		const int32 End = FMath::Min(Begin + ChunkSize, iEnd);
+		if (Begin < End)
+		{
+			ChunkSums[Chunk] = body.sumLoop(Begin, End);
+		}
+	});
+
+	// Summed in chunk order so the result doesn't depend on which worker finished first
+	btScalar Sum = 0;
+	for (const btScalar ChunkSum : ChunkSums)
+	{
+		Sum += ChunkSum;
+	}
+	return Sum;
+}
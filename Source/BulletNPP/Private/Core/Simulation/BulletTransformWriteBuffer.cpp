@@ -0,0 +1,66 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Simulation/BulletTransformWriteBuffer.h"
+
+#include "Components/SceneComponent.h"
+
+void FBulletTransformWriteBuffer::SetComponent(int32 Slot, USceneComponent* Component)
+{
+	if (Slot >= Components.Num())
+	{
+		const int32 NewNum = Slot + 1;
+		Components.SetNum(NewNum);
+		Locations.SetNumZeroed(NewNum);
+		Rotations.SetNum(NewNum);
+		Dirty.Add(false, NewNum - Dirty.Num());
+	}
+	Components[Slot] = Component;
+	Dirty[Slot] = false;
+}
+
+void FBulletTransformWriteBuffer::RemoveSlot(int32 Slot)
+{
+	if (!Components.IsValidIndex(Slot)) return;
+
+	Components[Slot].Reset();
+	// Left in DirtySlots, Apply skips anything that isn't flagged any more
+	Dirty[Slot] = false;
+}
+
+void FBulletTransformWriteBuffer::Apply(ETeleportType TeleportType, bool bSweep, float Tolerance, float RotationTolerance)
+{
+	if (DirtySlots.Num() == 0) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(BulletApplyTransformWrites);
+
+	for (const int32 Slot : DirtySlots)
+	{
+		if (!Dirty[Slot]) continue;
+		Dirty[Slot] = false;
+
+		USceneComponent* Component = Components[Slot].Get();
+		if (!Component) continue;
+
+		const FVector& Location = Locations[Slot];
+		const FQuat& Rotation = Rotations[Slot];
+		// FQuat::Equals compares components, which isn't an angle
+		if (Component->GetComponentLocation().Equals(Location, Tolerance) && Component->GetComponentQuat().AngularDistance(Rotation) <= RotationTolerance)
+		{
+			continue;
+		}
+
+		// Only location and rotation come from bullet, the component keeps its own scale
+		Component->SetWorldLocationAndRotation(Location, Rotation, bSweep, nullptr, TeleportType);
+	}
+	DirtySlots.Reset();
+}
+
+void FBulletTransformWriteBuffer::Reset()
+{
+	Components.Empty();
+	Locations.Empty();
+	Rotations.Empty();
+	Dirty.Empty();
+	DirtySlots.Empty();
+}
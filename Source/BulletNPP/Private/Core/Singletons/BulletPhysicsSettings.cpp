@@ -0,0 +1,31 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Core/Singletons/BulletPhysicsSettings.h"
+
+#include "Engine/World.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BulletPhysicsSettings)
+
+UBulletPhysicsSettings::UBulletPhysicsSettings()
+{
+	CategoryName = TEXT("Plugins");
+	SectionName = TEXT("Bullet Physics");
+}
+
+const FBulletWorldProfile& UBulletPhysicsSettings::GetWorldProfile(const UWorld* World) const
+{
+	if (World && MapWorldProfiles.Num() > 0)
+	{
+		// PIE worlds live in a prefixed copy of the map package
+		const FString MapPackageName = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+		for (const TPair<TSoftObjectPtr<UWorld>, FBulletWorldProfile>& It : MapWorldProfiles)
+		{
+			if (It.Key.GetLongPackageName() == MapPackageName)
+			{
+				return It.Value;
+			}
+		}
+	}
+	return DefaultWorldProfile;
+}
@@ -3,9 +3,24 @@
 
 #include "Core/Singletons/BulletPhysicsWorldSubsystem.h"
 
+#include "BulletLogChannels.h"
 #include "EngineUtils.h"
-
-const FVector UE_WORLD_ORIGIN = FVector(0);
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Crc.h"
+#include "Core/Simulation/BulletDynamicsWorld.h"
+#include "Core/Simulation/BulletProfiler.h"
+#include "Core/Simulation/BulletTaskScheduler.h"
+#include "Core/Simulation/BulletLandscapeShape.h"
+#include "LandscapeHeightfieldCollisionComponent.h"
+#include "Core/Singletons/BulletPhysicsSettings.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
 
 void UBulletPhysicsWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
@@ -13,17 +28,50 @@ void UBulletPhysicsWorldSubsystem::Initialize(FSubsystemCollectionBase& Collecti
 	
 	PhysicsDeltaTime = 1/PhysicsRefreshRate;
 
-	BtCollisionConfig = new btDefaultCollisionConfiguration();
-	BtCollisionDispatcher = new btCollisionDispatcher(BtCollisionConfig);
-
-	BtBroadphase = new btDbvtBroadphase();
-
-	mt = new btSequentialImpulseConstraintSolver;
-	mt->setRandSeed(1234);
+	const FBulletWorldProfile& Profile = UBulletPhysicsSettings::Get()->GetWorldProfile(GetWorld());
+	bMultithreadedWorld = Profile.bMultithreaded;
+	bDeterministicWorld = Profile.bDeterministic;
+	WorldNumThreads = Profile.NumWorkerThreads > 0 ? FMath::Min(Profile.NumWorkerThreads, (int32)BT_MAX_THREAD_COUNT) : FBulletTaskScheduler::GetDefaultNumThreads();
 
+	if (bMultithreadedWorld)
+	{
+		// The scheduler has to be in place before any of the Mt classes are created
+		FBulletTaskScheduler::Activate();
+		UE_LOG(LogBullet, Log, TEXT("UBulletPhysicsWorldSubsystem:: multithreaded bullet world using %d threads"), WorldNumThreads);
+	}
+	
+	// Sized up front from the profile, bullet falls back to one allocation per manifold or algorithm once they run out
+	btDefaultCollisionConstructionInfo ConstructionInfo;
+	ConstructionInfo.m_defaultMaxPersistentManifoldPoolSize = FMath::Max(Profile.MaxPersistentManifolds, 1);
+	ConstructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = FMath::Max(Profile.MaxCollisionAlgorithms, 1);
+	
+	// Built the same way the standalone benchmark builds its worlds
+	const FBulletWorldParts Parts = FBulletWorldParts::Create(bMultithreadedWorld, WorldNumThreads, ConstructionInfo);
+	BtCollisionConfig = Parts.CollisionConfig;
+	BtBroadphase = Parts.Broadphase;
+	BtCollisionDispatcher = Parts.Dispatcher;
+	BtSolverPool = Parts.SolverPool;
+	mt = Parts.Solver;
 	BtConstraintSolver = mt;
-	BtWorld = new btDiscreteDynamicsWorld(BtCollisionDispatcher, BtBroadphase, BtConstraintSolver, BtCollisionConfig);
+	BtWorld = Parts.World;
 	BtWorld->setGravity(btVector3(Gravity.X,Gravity.Y, Gravity.Z));
+	// Only active objects get their bounds refreshed each step. Everything that moves an object outside of the step (SetPhysicsState,
+	// snapshot restores, origin rebases) updates its aabb itself, as does a body falling asleep, see UpdateActivationEvents
+	BtWorld->setForceUpdateAllAabbs(false);
+	ContactStream.Attach(BtWorld);
+	
+	FBulletWorldTunables Tunables;
+	Tunables.ContactBreakingThreshold = BulletHelpers::ToBtSize(Profile.ContactBreakingThreshold);
+	Tunables.DeactivationTime = Profile.DeactivationTime;
+	Tunables.bDisableDeactivation = Profile.bDisableDeactivation;
+	Tunables.bDeterministic = bDeterministicWorld;
+	SetWorldTunables(Tunables);
+	if (bDeterministicWorld)
+	{
+		UE_LOG(LogBullet, Log, TEXT("UBulletPhysicsWorldSubsystem:: deterministic bullet world, resims reproduce the frames they replace"));
+	}
+	
+	WorldSnapshots.SetNum(FMath::Max(SnapshotHistorySize, 1));
 
 	UE_LOG(LogTemp, Warning, TEXT("UBulletPhysicsWorldSubsystem:: Bullet world init"));
 
@@ -40,6 +88,11 @@ void UBulletPhysicsWorldSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 	FName bulletDynamicTag = FName("B_DYNAMIC");
 	
 	Super::OnWorldBeginPlay(InWorld);
+	
+	// Any frame still waiting on a step once all of this world's actors (and NP) have ticked gets flushed here
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UBulletPhysicsWorldSubsystem::OnWorldPostActorTick);
+	WorldOriginOffsetHandle = FWorldDelegates::OnPostWorldOriginOffset.AddUObject(this, &UBulletPhysicsWorldSubsystem::OnWorldOriginOffset);
+	
 	for (TActorIterator<AActor> actorItr(&InWorld); actorItr; ++actorItr)
 	{
 		AActor* actor = *actorItr;
@@ -47,90 +100,399 @@ void UBulletPhysicsWorldSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 			continue;
 
 		int dummyID = 0; // Doesn't really matter
+		FBulletBodyHandle dummyHandle;
 		// Check if the actor has a UStaticMeshComponent directly
 		if (actor->ActorHasTag(bulletStaticTag))
 		{
 			RegisterStaticRigidBody(actor,0.5,0.9, false, dummyID);
 		}else if (actor->ActorHasTag(bulletDynamicTag))
 		{
-			RegisterDynamicRigidBody(actor,0.5,0.9,10.f, false,dummyID );
+			RegisterDynamicRigidBody(actor,0.5,0.9,10.f, false, DefaultActivationPolicy, dummyHandle );
+		}
+	}
+	
+	UE_LOG(LogBullet, Log, TEXT("UBulletPhysicsWorldSubsystem: registered level actors, shape cache hits %d / misses %d"), ShapeCacheStats.Hits, ShapeCacheStats.Misses);
+}
+
+
+void UBulletPhysicsWorldSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PostActorTickHandle.Reset();
+	FWorldDelegates::OnPostWorldOriginOffset.Remove(WorldOriginOffsetHandle);
+	WorldOriginOffsetHandle.Reset();
+	
+	if (BtWorld)
+	{
+		ContactStream.Detach(BtWorld);
+		
+		// Bodies first, they reference the shapes and live in the pool chunks
+		for (int32 i = 0; i < BtRigidBodies.Num(); ++i)
+		{
+			if (BtRigidBodies[i])
+			{
+				FreeRigidBody(i);
+			}
+		}
+		
+		for (btCollisionObject* Obj : BtStaticObjects)
+		{
+			BtWorld->removeCollisionObject(Obj);
+			delete Obj;
+		}
+		BtStaticObjects.Empty();
+	}
+	
+	for (auto& It : CachedDynamicShapes)
+	{
+		if (It.Value.bIsCompound)
+		{
+			delete It.Value.Shape;
 		}
 	}
+	CachedDynamicShapes.Empty();
+	DynamicBodyShapeKeys.Empty();
+	
+	for (auto& It : BtBoxCollisionShapes) { delete It.Value; }
+	for (auto& It : BtSphereCollisionShapes) { delete It.Value; }
+	for (auto& It : BtCapsuleCollisionShapes) { delete It.Value; }
+	for (auto& It : BtConvexHullCollisionShapes) { delete It.Value; }
+	for (btCollisionShape* Shape : UncachedShapes) { delete Shape; }
+	for (btStridingMeshInterface* Mesh : TriangleMeshes) { delete Mesh; }
+	// After UncachedShapes, the scaled instances point at these
+	for (auto& It : CookedTriMeshShapes) { It.Value.Release(); }
+	BtBoxCollisionShapes.Empty();
+	BtSphereCollisionShapes.Empty();
+	BtCapsuleCollisionShapes.Empty();
+	BtConvexHullCollisionShapes.Empty();
+	UncachedShapes.Empty();
+	TriangleMeshes.Empty();
+	CookedTriMeshShapes.Empty();
+	CookedTriMeshAssets.Empty();
+	
+	ParentObjectCollisionMap.Empty();
+	BtRigidBodies.Empty();
+	BtRigidBodyGenerations.Empty();
+	BtRigidBodyHashKeys.Empty();
+	BtRigidBodyActivation.Empty();
+	ActivationEvents.Empty();
+	ContactStream.Reset();
+	FreeRigidBodyIds.Empty();
+	RigidBodySlotChunks.Empty();
+	TransformWriteBuffer.Reset();
+	WorldSnapshots.Empty();
+	
+	// Reverse order of creation, the world refers to everything else
+	delete BtWorld;
+	delete BtConstraintSolver;
+	delete BtSolverPool;
+	delete BtBroadphase;
+	delete BtCollisionDispatcher;
+	delete BtCollisionConfig;
+	BtWorld = nullptr;
+	BtConstraintSolver = nullptr;
+	BtSolverPool = nullptr;
+	mt = nullptr;
+	BtBroadphase = nullptr;
+	BtCollisionDispatcher = nullptr;
+	BtCollisionConfig = nullptr;
+	
+	Super::Deinitialize();
 }
 
 
 // TODO:@GreggoryAddison::CodeUpgrade || This function needs to change. We need an option for a specific primitive component along with the parent to attach it to. In my project a single actor can have multiple shapes that are not all active at one time
-void UBulletPhysicsWorldSubsystem::RegisterDynamicRigidBody(AActor* Target, float Friction, float Restitution, float Mass, bool bUsePhysicsMaterial, UPARAM(DisplayName="RigidBodyId") int32&Id )
+void UBulletPhysicsWorldSubsystem::RegisterDynamicRigidBody(AActor* Target, float Friction, float Restitution, float Mass, bool bUsePhysicsMaterial, const FBulletActivationPolicy& ActivationPolicy, UPARAM(DisplayName="RigidBody") FBulletBodyHandle& Handle)
 {
+	btRigidBody* Body = nullptr;
 	if (!bUsePhysicsMaterial)
 	{
-		AddRigidBody(Target, GetCachedDynamicShapeData(Target, Mass), Friction, Restitution);	
+		Body = AddRigidBody(Target, GetCachedDynamicShapeData(Target, Mass), Friction, Restitution);	
 	}
 	else
 	{
 		
 	}
 	
-	const int32 objectId = BtRigidBodies.Num() - 1;
+	if (!Body)
+	{
+		Handle.Reset();
+		return;
+	}
+	
+	const int32 Index = Body->getUserIndex();
+	const FBulletBodyHandle BodyHandle(Index, BtRigidBodyGenerations[Index]);
+	ApplyActivationPolicy(Index, ActivationPolicy);
 
 	if (ParentObjectCollisionMap.Contains(Target))
 	{
-		ParentObjectCollisionMap[Target].ObjectIds.AddUnique(objectId);
+		ParentObjectCollisionMap[Target].Bodies.AddUnique(BodyHandle);
 	}
 	else
 	{
-		ParentObjectCollisionMap.Add(Target, FCollisionObjectArray(objectId));
+		ParentObjectCollisionMap.Add(Target, FCollisionObjectArray(BodyHandle));
 	}
 	
-	Id = objectId;
+	Handle = BodyHandle;
 }
 
-void UBulletPhysicsWorldSubsystem::RegisterStaticRigidBody(AActor* Target, float Friction, float Restitution, bool bUsePhysicsMaterial, UPARAM(DisplayName="RigidBodyId") int32&Id )
+void UBulletPhysicsWorldSubsystem::UnregisterRigidBody(FBulletBodyHandle Handle)
 {
-	ExtractPhysicsGeometry(Target,[Target, this, Friction, Restitution](btCollisionShape* Shape, const FTransform& RelTransform)
+	btRigidBody* Body = GetRigidBody(Handle);
+	if (!Body) return;
+	
+	if (AActor* Owner = static_cast<AActor*>(Body->getUserPointer()))
 	{
-	// Every sub-collider in the actor is passed to this callback function
-	// We're baking this in world space, so apply actor transform to relative
-	const FTransform FinalXform = RelTransform * Target->GetActorTransform();
-	AddStaticCollision(Shape, FinalXform, Friction, Restitution, Target);
-	});
+		if (FCollisionObjectArray* Objects = ParentObjectCollisionMap.Find(Owner))
+		{
+			Objects->Bodies.Remove(Handle);
+			if (Objects->Bodies.Num() == 0)
+			{
+				ParentObjectCollisionMap.Remove(Owner);
+			}
+		}
+	}
+	
+	FCachedDynamicShapeKey ShapeKey;
+	if (DynamicBodyShapeKeys.RemoveAndCopyValue(Body, ShapeKey))
+	{
+		ReleaseCachedDynamicShapeData(ShapeKey);
+	}
 	
+	FreeRigidBody(Handle.Index);
+}
 
-	const int32 objectId = BtRigidBodies.Num() - 1;
+btRigidBody* UBulletPhysicsWorldSubsystem::GetRigidBody(const FBulletBodyHandle& Handle) const
+{
+	if (!BtRigidBodies.IsValidIndex(Handle.Index) || BtRigidBodyGenerations[Handle.Index] != Handle.Generation)
+	{
+		return nullptr;
+	}
+	return BtRigidBodies[Handle.Index];
+}
 
-	if (ParentObjectCollisionMap.Contains(Target))
+int32 UBulletPhysicsWorldSubsystem::AllocateRigidBodySlot()
+{
+	if (FreeRigidBodyIds.Num() > 0)
 	{
-		ParentObjectCollisionMap[Target].ObjectIds.AddUnique(objectId);
+		return FreeRigidBodyIds.Pop(EAllowShrinking::No);
+	}
+	
+	const int32 Index = BtRigidBodies.Add(nullptr);
+	BtRigidBodyGenerations.Add(0);
+	BtRigidBodyHashKeys.Add(0);
+	BtRigidBodyActivation.AddDefaulted();
+	if (Index / RigidBodySlotsPerChunk >= RigidBodySlotChunks.Num())
+	{
+		RigidBodySlotChunks.Add(MakeUnique<FRigidBodySlot[]>(RigidBodySlotsPerChunk));
+	}
+	return Index;
+}
+
+btRigidBody* UBulletPhysicsWorldSubsystem::FinishAddRigidBody(int32 Index, btRigidBody* Body)
+{
+	// Lets anything holding the raw body (contacts, queries) get back to its slot
+	Body->setUserIndex(Index);
+	BtRigidBodies[Index] = Body;
+	// Level actors have the same name everywhere, runtime spawned ones get their id from SetRigidBodyNetworkId
+	const AActor* Owner = static_cast<const AActor*>(Body->getUserPointer());
+	BtRigidBodyHashKeys[Index] = Owner && Owner->IsNetStartupActor() ? FCrc::StrCrc32(*Owner->GetName()) | 0x80000000u : 0;
+	FBulletSceneQuery::SetObjectChannel(Body, Owner, ECC_PhysicsBody);
+	BtRigidBodyActivation[Index] = FRigidBodyActivation();
+	ApplyActivationPolicy(Index, DefaultActivationPolicy);
+	BtWorld->addRigidBody(Body);
+	return Body;
+}
+
+void UBulletPhysicsWorldSubsystem::SetActivationPolicy(FBulletBodyHandle Handle, const FBulletActivationPolicy& ActivationPolicy)
+{
+	if (GetRigidBody(Handle))
+	{
+		ApplyActivationPolicy(Handle.Index, ActivationPolicy);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::ApplyActivationPolicy(int32 Index, const FBulletActivationPolicy& ActivationPolicy)
+{
+	btRigidBody* Body = BtRigidBodies[Index];
+	SetSleepPinned(Index, false);
+	if (ActivationPolicy.bAllowSleep)
+	{
+		Body->forceActivationState(ACTIVE_TAG);
+		Body->setSleepingThresholds(BulletHelpers::ToBtSize(ActivationPolicy.LinearSleepThreshold), FMath::DegreesToRadians(ActivationPolicy.AngularSleepThreshold));
+		FBulletDynamicsWorld::SetBodyDeactivationTime(Body, ActivationPolicy.DeactivationTime);
 	}
 	else
 	{
-		ParentObjectCollisionMap.Add(Target, FCollisionObjectArray(objectId));
+		Body->forceActivationState(DISABLE_DEACTIVATION);
 	}
+	Body->setDeactivationTime(0);
 	
-	Id = objectId;
+	FRigidBodyActivation& Activation = BtRigidBodyActivation[Index];
+	Activation.bWakeOnContact = !ActivationPolicy.bAllowSleep || ActivationPolicy.bWakeOnContact;
+	if (Activation.bSleeping)
+	{
+		Activation.bSleeping = false;
+		ActivationEvents.Add({ FBulletBodyHandle(Index, BtRigidBodyGenerations[Index]), EBulletActivationEventType::Woke });
+	}
 }
 
+void UBulletPhysicsWorldSubsystem::WakeRigidBody(FBulletBodyHandle Handle)
+{
+	if (GetRigidBody(Handle))
+	{
+		WakeRigidBodySlot(Handle.Index);
+	}
+}
 
-btCollisionShape* UBulletPhysicsWorldSubsystem::GetBoxCollisionShape(const FVector& Dimensions)
+void UBulletPhysicsWorldSubsystem::WakeRigidBodySlot(int32 Index)
 {
-	// Simple brute force lookup for now, probably doesn't need anything more clever
-	btVector3 HalfSize = BulletHelpers::ToBtSize(Dimensions * 0.5);
-	for (auto&& S : BtBoxCollisionShapes)
+	btRigidBody* Body = BtRigidBodies[Index];
+	FRigidBodyActivation& Activation = BtRigidBodyActivation[Index];
+	if (!Activation.bSleeping && Body->isActive()) return;
+	
+	SetSleepPinned(Index, false);
+	Body->activate(true);
+	if (Activation.bSleeping)
+	{
+		// Cleared before the step, so UpdateActivationEvents knows this wake was asked for
+		Activation.bSleeping = false;
+		ActivationEvents.Add({ FBulletBodyHandle(Index, BtRigidBodyGenerations[Index]), EBulletActivationEventType::Woke });
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::SetSleepPinned(int32 Index, bool bPinned)
+{
+	FRigidBodyActivation& Activation = BtRigidBodyActivation[Index];
+	if (Activation.bPinned == bPinned) return;
+	
+	btRigidBody* Body = BtRigidBodies[Index];
+	if (bPinned)
+	{
+		// Already static or kinematic bodies can't be woken by contacts anyway, and must keep their own flags
+		if (Body->isStaticOrKinematicObject()) return;
+		
+		// Static objects stay out of the simulation islands, can only be woken by a forced activation and are solved
+		// with infinite mass, so whatever lands on this body rests against it rather than waking or pushing it
+		Body->setCollisionFlags(Body->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
+	}
+	else
+	{
+		Body->setCollisionFlags(Body->getCollisionFlags() & ~btCollisionObject::CF_STATIC_OBJECT);
+	}
+	Activation.bPinned = bPinned;
+}
+
+void UBulletPhysicsWorldSubsystem::SetContactReportFlags(FBulletBodyHandle Handle, int32 Flags)
+{
+	if (btRigidBody* Body = GetRigidBody(Handle))
+	{
+		ContactStream.SetReportFlags(Body, (EBulletContactReportFlags)Flags);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::SetRigidBodyNetworkId(FBulletBodyHandle Handle, int32 NetworkId)
+{
+	if (GetRigidBody(Handle))
+	{
+		// Kept apart from the name keys of level actors by the top bit
+		BtRigidBodyHashKeys[Handle.Index] = static_cast<uint32>(NetworkId) & 0x7fffffffu;
+	}
+}
+
+bool UBulletPhysicsWorldSubsystem::IsRigidBodySleeping(FBulletBodyHandle Handle) const
+{
+	const btRigidBody* Body = GetRigidBody(Handle);
+	return Body && !Body->isActive();
+}
+
+void UBulletPhysicsWorldSubsystem::UpdateActivationEvents()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UpdateActivationEvents);
+	
+	for (int32 i = 0; i < BtRigidBodies.Num(); ++i)
 	{
-		btVector3 Sz = S->getHalfExtentsWithMargin();
-		if (FMath::IsNearlyEqual(Sz.x(), HalfSize.x()) &&
-				FMath::IsNearlyEqual(Sz.y(), HalfSize.y()) &&
-				FMath::IsNearlyEqual(Sz.z(), HalfSize.z()))
+		btRigidBody* Body = BtRigidBodies[i];
+		if (!Body) continue;
+		
+		FRigidBodyActivation& Activation = BtRigidBodyActivation[i];
+		const bool bSleeping = !Body->isActive();
+		if (Activation.bSleeping == bSleeping) continue;
+		
+		if (bSleeping)
 		{
-			return S;
+			Activation.bSleeping = true;
+			// The step's aabb update ran before the body's last integration, and it won't get another while it sleeps
+			FBulletWorldParts::VisitWorld(BtWorld, bMultithreadedWorld, [Body](auto& World) { World.UpdateSingleAabb(Body); });
+			SetSleepPinned(i, !Activation.bWakeOnContact);
+			ActivationEvents.Add({ FBulletBodyHandle(i, BtRigidBodyGenerations[i]), EBulletActivationEventType::FellAsleep });
 		}
+		else
+		{
+			// Pinned bodies only wake through a forced activation, which already unpins them, so this is a no-op for those
+			SetSleepPinned(i, false);
+			Activation.bSleeping = false;
+			ActivationEvents.Add({ FBulletBodyHandle(i, BtRigidBodyGenerations[i]), EBulletActivationEventType::Woke });
+		}
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::FreeRigidBody(int32 Index)
+{
+	btRigidBody* Body = BtRigidBodies[Index];
+	ContactStream.RemoveObject(Body);
+	BtWorld->removeRigidBody(Body);
+	
+	// Both were constructed in place in the slot, so only their destructors run here
+	btMotionState* MotionState = Body->getMotionState();
+	Body->~btRigidBody();
+	if (MotionState)
+	{
+		MotionState->~btMotionState();
 	}
+	
+	TransformWriteBuffer.RemoveSlot(Index);
+	BtRigidBodies[Index] = nullptr;
+	++BtRigidBodyGenerations[Index];
+	FreeRigidBodyIds.Add(Index);
+}
+
+void UBulletPhysicsWorldSubsystem::RegisterStaticRigidBody(AActor* Target, float Friction, float Restitution, bool bUsePhysicsMaterial, UPARAM(DisplayName="RigidBodyId") int32&Id )
+{
+	ExtractPhysicsGeometry(Target,[Target, this, Friction, Restitution](btCollisionShape* Shape, const FTransform& RelTransform)
+	{
+	// Every sub-collider in the actor is passed to this callback function
+	// We're baking this in world space, so apply actor transform to relative
+	const FTransform FinalXform = RelTransform * Target->GetActorTransform();
+	AddStaticCollision(Shape, FinalXform, Friction, Restitution, Target);
+	}, true);
+	
+	// Static objects aren't rigid bodies, so they stay out of the body handle lookups
+	Id = BtStaticObjects.Num() - 1;
+}
+
+
+int32 UBulletPhysicsWorldSubsystem::QuantizeShapeDimension(double Value) const
+{
+	return FMath::RoundToInt32(Value / FMath::Max(ShapeCacheTolerance, UE_KINDA_SMALL_NUMBER));
+}
+
+btCollisionShape* UBulletPhysicsWorldSubsystem::GetBoxCollisionShape(const FVector& Dimensions)
+{
+	const FIntVector Key(QuantizeShapeDimension(Dimensions.X), QuantizeShapeDimension(Dimensions.Y), QuantizeShapeDimension(Dimensions.Z));
+	if (btBoxShape** Found = BtBoxCollisionShapes.Find(Key))
+	{
+		++ShapeCacheStats.Hits;
+		return *Found;
+	}
+	++ShapeCacheStats.Misses;
 
 	// Not found, create
+	btVector3 HalfSize = BulletHelpers::ToBtSize(Dimensions * 0.5);
 	auto S = new btBoxShape(HalfSize);
 	// Get rid of margins, just cause issues for me
 	S->setMargin(0);
-	BtBoxCollisionShapes.Add(S);
+	BtBoxCollisionShapes.Add(Key, S);
 
 	return S;
 
@@ -138,22 +500,20 @@ btCollisionShape* UBulletPhysicsWorldSubsystem::GetBoxCollisionShape(const FVect
 
 btCollisionShape* UBulletPhysicsWorldSubsystem::GetSphereCollisionShape(float Radius)
 {
-	// Simple brute force lookup for now, probably doesn't need anything more clever
-	btScalar Rad = BulletHelpers::ToBtSize(Radius);
-	for (auto&& S : BtSphereCollisionShapes)
+	const int32 Key = QuantizeShapeDimension(Radius);
+	if (btSphereShape** Found = BtSphereCollisionShapes.Find(Key))
 	{
-		// Bullet subtracts a margin from its internal shape, so add back to compare
-		if (FMath::IsNearlyEqual(S->getRadius(), Rad))
-		{
-			return S;
-		}
+		++ShapeCacheStats.Hits;
+		return *Found;
 	}
+	++ShapeCacheStats.Misses;
 
 	// Not found, create
+	btScalar Rad = BulletHelpers::ToBtSize(Radius);
 	auto S = new btSphereShape(Rad);
 	// Get rid of margins, just cause issues for me
 	S->setMargin(0);
-	BtSphereCollisionShapes.Add(S);
+	BtSphereCollisionShapes.Add(Key, S);
 
 	return S;
 
@@ -161,30 +521,25 @@ btCollisionShape* UBulletPhysicsWorldSubsystem::GetSphereCollisionShape(float Ra
 
 btCollisionShape* UBulletPhysicsWorldSubsystem::GetCapsuleCollisionShape(float Radius, float Height)
 {
-	// Simple brute force lookup for now, probably doesn't need anything more clever
-	btScalar R = BulletHelpers::ToBtSize(Radius);
-	btScalar H = BulletHelpers::ToBtSize(Height);
-	btScalar HalfH = H * 0.5f;
-
-	for (auto&& S : BtCapsuleCollisionShapes)
+	const FIntPoint Key(QuantizeShapeDimension(Radius), QuantizeShapeDimension(Height));
+	if (btCapsuleShape** Found = BtCapsuleCollisionShapes.Find(Key))
 	{
-		// Bullet subtracts a margin from its internal shape, so add back to compare
-		if (FMath::IsNearlyEqual(S->getRadius(), R) &&
-				FMath::IsNearlyEqual(S->getHalfHeight(), HalfH))
-		{
-			return S;
-		}
+		++ShapeCacheStats.Hits;
+		return *Found;
 	}
+	++ShapeCacheStats.Misses;
 
 	// Not found, create
+	btScalar R = BulletHelpers::ToBtSize(Radius);
+	btScalar H = BulletHelpers::ToBtSize(Height);
 	auto S = new btCapsuleShape(R, H);
-	BtCapsuleCollisionShapes.Add(S);
+	BtCapsuleCollisionShapes.Add(Key, S);
 
 	return S;
 
 }
 
-btCollisionShape* UBulletPhysicsWorldSubsystem::GetTriangleMeshShape(TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d)
+btCollisionShape* UBulletPhysicsWorldSubsystem::GetTriangleMeshShape(const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d)
 {
 	btTriangleMesh* triangleMesh = new btTriangleMesh();
 
@@ -195,36 +550,81 @@ btCollisionShape* UBulletPhysicsWorldSubsystem::GetTriangleMeshShape(TArray<FVec
 
 	}
 	btBvhTriangleMeshShape* Trimesh= new btBvhTriangleMeshShape(triangleMesh,true);
+	TriangleMeshes.Add(triangleMesh);
+	UncachedShapes.Add(Trimesh);
 	return Trimesh;
 }
 
+btCollisionShape* UBulletPhysicsWorldSubsystem::GetCookedConvexHullShape(UBulletCookedConvexHulls* Cooked, int32 HullIndex, const FVector& Scale)
+{
+	const FConvexHullShapeKey Key = MakeConvexHullShapeKey(Cooked, HullIndex, Scale);
+	if (btConvexHullShape** Found = BtConvexHullCollisionShapes.Find(Key))
+	{
+		++ShapeCacheStats.Hits;
+		return *Found;
+	}
+	++ShapeCacheStats.Misses;
+
+	btConvexHullShape* C = Cooked->CreateHullShape(HullIndex, Scale);
+	BtConvexHullCollisionShapes.Add(Key, C);
+	return C;
+}
+
+btCollisionShape* UBulletPhysicsWorldSubsystem::GetCookedTriMeshShape(UBulletCookedTriMesh* Cooked, const FVector& Scale)
+{
+	FBulletCookedTriMeshShape* ShapeData = CookedTriMeshShapes.Find(Cooked);
+	if (ShapeData)
+	{
+		++ShapeCacheStats.Hits;
+	}
+	else
+	{
+		++ShapeCacheStats.Misses;
+		ShapeData = &CookedTriMeshShapes.Add(Cooked, Cooked->CreateShape());
+		CookedTriMeshAssets.Add(Cooked);
+	}
+
+	// Scaled shapes are a pointer and a scale, cheap enough to have one per instance
+	btScaledBvhTriangleMeshShape* Scaled = new btScaledBvhTriangleMeshShape(ShapeData->Shape, btVector3(Scale.X, Scale.Y, Scale.Z));
+	UncachedShapes.Add(Scaled);
+	return Scaled;
+}
+
+UBulletPhysicsWorldSubsystem::FConvexHullShapeKey UBulletPhysicsWorldSubsystem::MakeConvexHullShapeKey(const UObject* Source, int32 HullIndex, const FVector& Scale)
+{
+	// Scale is a ratio rather than a length so it gets its own, finer grid
+	constexpr double ScaleGrid = 1.0e-4;
+	return FConvexHullShapeKey{
+		Source,
+		HullIndex,
+		FIntVector(FMath::RoundToInt32(Scale.X / ScaleGrid), FMath::RoundToInt32(Scale.Y / ScaleGrid), FMath::RoundToInt32(Scale.Z / ScaleGrid))
+	};
+}
+
 btCollisionShape* UBulletPhysicsWorldSubsystem::GetConvexHullCollisionShape(UBodySetup* BodySetup, int ConvexIndex, const FVector& Scale)
 {
-	for (auto&& S : BtConvexHullCollisionShapes)
-	{ 
-		if (S.BodySetup == BodySetup && S.HullIndex == ConvexIndex && S.Scale.Equals(Scale))
-		{
-			return S.Shape;
-		}
+	const FConvexHullShapeKey Key = MakeConvexHullShapeKey(BodySetup, ConvexIndex, Scale);
+	if (btConvexHullShape** Found = BtConvexHullCollisionShapes.Find(Key))
+	{
+		++ShapeCacheStats.Hits;
+		return *Found;
 	}
+	++ShapeCacheStats.Misses;
 
 	const FKConvexElem& Elem = BodySetup->AggGeom.ConvexElems[ConvexIndex];
 	auto C = new btConvexHullShape();
 	for (auto&& P : Elem.VertexData)
 	{
-		C->addPoint(BulletHelpers::ToBtPos(P, FVector::ZeroVector));
+		// Bounds are worked out once below instead of after every point
+		C->addPoint(BulletHelpers::ToBtPos(P * Scale, FVector::ZeroVector), false);
 	}
+	C->recalcLocalAabb();
 	// Very important! Otherwise there's a gap between 
 	C->setMargin(0);
 	// Apparently this is good to call?
 	C->initializePolyhedralFeatures();
 
-	BtConvexHullCollisionShapes.Add({
-			BodySetup,
-			ConvexIndex,
-			Scale,
-			C
-			});
+	BtConvexHullCollisionShapes.Add(Key, C);
 
 	return C;
 }
@@ -232,12 +632,79 @@ btCollisionShape* UBulletPhysicsWorldSubsystem::GetConvexHullCollisionShape(UBod
 
 
 
-const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& UBulletPhysicsWorldSubsystem::GetCachedDynamicShapeData(AActor* Actor, float Mass)
+UBulletPhysicsWorldSubsystem::FCachedDynamicShapeKey UBulletPhysicsWorldSubsystem::MakeDynamicShapeKey(TObjectKey<UClass> Class, uint32 GeometryHash, float Mass)
 {
-	// We re-use compound shapes based on (leaf) BP class
-	const FName ClassName = Actor->GetClass()->GetFName();
+	return FCachedDynamicShapeKey{ Class, GeometryHash, FMath::RoundToInt32(Mass * 1000.f) };
+}
 
+uint32 UBulletPhysicsWorldSubsystem::HashDynamicShapeGeometry(AActor* Actor) const
+{
+	const FTransform InvActorTransform = Actor->GetActorTransform().Inverse();
+	
+	// Snapped like the shape caches so instances that end up with the same shapes share them
+	auto HashTransform = [this](uint32 Hash, const FTransform& RelTransform)
+	{
+		constexpr double RatioGrid = 1.0e-4;
+		const FVector Location = RelTransform.GetLocation();
+		const FVector Scale = RelTransform.GetScale3D();
+		// q and -q are the same rotation
+		FQuat Rotation = RelTransform.GetRotation();
+		if (Rotation.W < 0.0)
+		{
+			Rotation = -Rotation;
+		}
+		Hash = HashCombineFast(Hash, GetTypeHash(FIntVector(QuantizeShapeDimension(Location.X), QuantizeShapeDimension(Location.Y), QuantizeShapeDimension(Location.Z))));
+		Hash = HashCombineFast(Hash, GetTypeHash(FIntVector4(FMath::RoundToInt32(Rotation.X / RatioGrid), FMath::RoundToInt32(Rotation.Y / RatioGrid),
+			FMath::RoundToInt32(Rotation.Z / RatioGrid), FMath::RoundToInt32(Rotation.W / RatioGrid))));
+		return HashCombineFast(Hash, GetTypeHash(FIntVector(FMath::RoundToInt32(Scale.X / RatioGrid), FMath::RoundToInt32(Scale.Y / RatioGrid), FMath::RoundToInt32(Scale.Z / RatioGrid))));
+	};
+	
+	uint32 Hash = 0;
+	TInlineComponentArray<UActorComponent*, 20> Components;
+	
+	Actor->GetComponents(UStaticMeshComponent::StaticClass(), Components);
+	for (UActorComponent* Comp : Components)
+	{
+		const UStaticMeshComponent* SMC = Cast<UStaticMeshComponent>(Comp);
+		if (!SMC->GetStaticMesh()) continue;
+		
+		// The mesh's body setup and cooked data are what the shapes are built from
+		Hash = HashCombineFast(Hash, GetTypeHash(TObjectKey<UStaticMesh>(SMC->GetStaticMesh())));
+		Hash = HashTransform(Hash, SMC->GetComponentTransform() * InvActorTransform);
+	}
+	
+	Actor->GetComponents(UShapeComponent::StaticClass(), Components);
+	for (UActorComponent* Comp : Components)
+	{
+		// Every shape component has its own body setup, so it's its shape and size that gets shared
+		const UShapeComponent* Sc = Cast<UShapeComponent>(Comp);
+		const FCollisionShape CollisionShape = Sc->GetCollisionShape();
+		const FVector Extent = CollisionShape.GetExtent();
+		Hash = HashCombineFast(Hash, GetTypeHash((uint8)CollisionShape.ShapeType));
+		Hash = HashCombineFast(Hash, GetTypeHash(FIntVector(QuantizeShapeDimension(Extent.X), QuantizeShapeDimension(Extent.Y), QuantizeShapeDimension(Extent.Z))));
+		Hash = HashTransform(Hash, Sc->GetComponentTransform() * InvActorTransform);
+	}
+	
+	// Heightfields are built per component, an actor with one never shares its shape
+	Actor->GetComponents(ULandscapeHeightfieldCollisionComponent::StaticClass(), Components);
+	for (UActorComponent* Comp : Components)
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(TObjectKey<UActorComponent>(Comp)));
+	}
+	
+	return Hash;
+}
 
+const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& UBulletPhysicsWorldSubsystem::GetCachedDynamicShapeData(AActor* Actor, float Mass)
+{
+	// We re-use compound shapes based on (leaf) BP class and the geometry of this instance
+	const TObjectKey<UClass> Class(Actor->GetClass());
+	const uint32 GeometryHash = HashDynamicShapeGeometry(Actor);
+	const FCachedDynamicShapeKey Key = MakeDynamicShapeKey(Class, GeometryHash, Mass);
+	if (const CachedDynamicShapeData* Found = CachedDynamicShapes.Find(Key))
+	{
+		return *Found;
+	}
 
 	// Because we want to support compound colliders, we need to extract all colliders first before
 	// constructing the final body.
@@ -252,7 +719,8 @@ const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& UBulletPhysicsWorldS
 
 
 	CachedDynamicShapeData ShapeData;
-	ShapeData.ClassName = ClassName;
+	ShapeData.Class = Class;
+	ShapeData.GeometryHash = GeometryHash;
 
 	// Single shape with no transform is simplest
 	if (ShapeRelXforms.Num() == 1 &&
@@ -264,8 +732,9 @@ const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& UBulletPhysicsWorldS
 	}
 	else
 	{
-		// Compound or offset single shape; we will cache these by blueprint type
-		btCompoundShape* CS = new btCompoundShape();
+		// Compound or offset single shape; we will cache these by blueprint type.
+		// The child tree lets a pair keep child algorithms around that a rewound world wouldn't recreate, so deterministic worlds go without
+		btCompoundShape* CS = new btCompoundShape(!bDeterministicWorld);
 		for (int i = 0; i < Shapes.Num(); ++i)
 		{
 			// We don't use the actor origin when converting transform in this case since object space
@@ -282,30 +751,52 @@ const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& UBulletPhysicsWorldS
 	ShapeData.Shape->calculateLocalInertia(Mass, ShapeData.Inertia);
 
 	// Cache for future use
-	CachedDynamicShapes.Add(ShapeData);
-
-	return CachedDynamicShapes.Last();
+	return CachedDynamicShapes.Add(Key, ShapeData);
 
 }
 
 btRigidBody* UBulletPhysicsWorldSubsystem::AddRigidBody(AActor* Actor, const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& ShapeData, float Friction, float Restitution)
 {
-	return AddRigidBody(Actor, ShapeData.Shape, ShapeData.Inertia, ShapeData.Mass, Friction, Restitution);
+	const FCachedDynamicShapeKey Key = MakeDynamicShapeKey(ShapeData.Class, ShapeData.GeometryHash, ShapeData.Mass);
+	btRigidBody* Body = AddRigidBody(Actor, ShapeData.Shape, ShapeData.Inertia, ShapeData.Mass, Friction, Restitution);
+	
+	// The body holds on to the shared shape until it's unregistered
+	if (CachedDynamicShapeData* Cached = CachedDynamicShapes.Find(Key))
+	{
+		++Cached->RefCount;
+		DynamicBodyShapeKeys.Add(Body, Key);
+	}
+	return Body;
+}
+
+void UBulletPhysicsWorldSubsystem::ReleaseCachedDynamicShapeData(const FCachedDynamicShapeKey& Key)
+{
+	CachedDynamicShapeData* Cached = CachedDynamicShapes.Find(Key);
+	if (!Cached || --Cached->RefCount > 0) return;
+	
+	// Simple shapes are owned by the shape caches, only the compound wrapper belongs to us
+	if (Cached->bIsCompound)
+	{
+		delete Cached->Shape;
+	}
+	CachedDynamicShapes.Remove(Key);
 }
 
 
 btRigidBody* UBulletPhysicsWorldSubsystem::AddRigidBody(AActor* Actor, btCollisionShape* CollisionShape, btVector3 Inertia, float Mass, float Friction, float Restitution)
 {
 
-	FBulletMotionState* MotionState = new FBulletMotionState(Actor, UE_WORLD_ORIGIN);
+	const int32 Index = AllocateRigidBodySlot();
+	FRigidBodySlot& Slot = GetRigidBodySlot(Index);
+	FBulletMotionState* MotionState = new (Slot.MotionStateStorage) FBulletMotionState(Actor, WorldOrigin);
+	if (bDeferTransformWrites)
+	{
+		MotionState->SetWriteBuffer(&TransformWriteBuffer, Index);
+	}
 	const btRigidBody::btRigidBodyConstructionInfo rbInfo(Mass, MotionState, CollisionShape, Inertia);
-	btRigidBody* body = new btRigidBody(rbInfo);
+	btRigidBody* body = new (Slot.BodyStorage) btRigidBody(rbInfo);
 	body->setUserPointer(Actor);
-	body->setActivationState(DISABLE_DEACTIVATION);
-	body->setDeactivationTime(0);
-	BtWorld->addRigidBody(body);
-	BtRigidBodies.Add(body);
-	return body;
+	return FinishAddRigidBody(Index, body);
 }
 
 btRigidBody* UBulletPhysicsWorldSubsystem::AddRigidBody(USkeletalMeshComponent* skel, const FTransform& PhysicsAssetTransform, btCollisionShape* collisionShape, float mass, float friction, float restitution)
@@ -314,48 +805,63 @@ btRigidBody* UBulletPhysicsWorldSubsystem::AddRigidBody(USkeletalMeshComponent*
 	btVector3 inertia(0,0,0);
 	checkf(collisionShape!=nullptr, TEXT("Please configure physics asset for: %s"), *skel->GetName());
 	collisionShape->calculateLocalInertia(mass, inertia);
-	FBulletUEMotionState* objMotionState = new FBulletUEMotionState(skel, UE_WORLD_ORIGIN, PhysicsAssetTransform);
+	const int32 Index = AllocateRigidBodySlot();
+	FRigidBodySlot& Slot = GetRigidBodySlot(Index);
+	FBulletUEMotionState* objMotionState = new (Slot.MotionStateStorage) FBulletUEMotionState(skel, WorldOrigin, PhysicsAssetTransform);
+	if (bDeferTransformWrites)
+	{
+		objMotionState->SetWriteBuffer(&TransformWriteBuffer, Index);
+	}
 	const btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, objMotionState, collisionShape, inertia);
-	btRigidBody* body = new btRigidBody(rbInfo);
+	btRigidBody* body = new (Slot.BodyStorage) btRigidBody(rbInfo);
 	body->setUserPointer(skel->GetOwner());
-	body->setActivationState(DISABLE_DEACTIVATION);
-	body->setDeactivationTime(0);
 
-	BtWorld->addRigidBody(body);
-	BtRigidBodies.Add(body);
-	return body;
+	return FinishAddRigidBody(Index, body);
 }
 
-void UBulletPhysicsWorldSubsystem::SetPhysicsState(int ID, FTransform transforms, FVector Velocity, FVector AngularVelocity, FVector& Force)
+void UBulletPhysicsWorldSubsystem::SetPhysicsState(FBulletBodyHandle Handle, FTransform transforms, FVector Velocity, FVector AngularVelocity, FVector& Force)
 {
 
-	if (BtRigidBodies[ID]) {
-		BtRigidBodies[ID]->setWorldTransform(BulletHelpers::ToBt(transforms, UE_WORLD_ORIGIN));
-		BtRigidBodies[ID]->setLinearVelocity(BulletHelpers::ToBtPos(Velocity, UE_WORLD_ORIGIN));
-		BtRigidBodies[ID]->setAngularVelocity(BulletHelpers::ToBtPos(AngularVelocity, FVector(0)));
+	if (btRigidBody* Body = GetRigidBody(Handle)) {
+		WakeRigidBodySlot(Handle.Index);
+		const btTransform WorldTransform = BulletHelpers::ToBt(transforms, WorldOrigin);
+		Body->setWorldTransform(WorldTransform);
+		Body->setInterpolationWorldTransform(WorldTransform);
+		Body->setLinearVelocity(BulletHelpers::ToBtDir(Velocity));
+		Body->setAngularVelocity(BulletHelpers::ToBtDir(AngularVelocity));
+		Body->setInterpolationLinearVelocity(Body->getLinearVelocity());
+		Body->setInterpolationAngularVelocity(Body->getAngularVelocity());
+		Body->updateInertiaTensor();
+		
+		// The broadphase would otherwise keep the old bounds until the next step
+		FBulletWorldParts::VisitWorld(BtWorld, bMultithreadedWorld, [Body](auto& World) { World.UpdateSingleAabb(Body); });
 	}
 
 
 }
 
-void UBulletPhysicsWorldSubsystem::GetPhysicsState(int ID, FTransform& transforms, FVector& Velocity, FVector& AngularVelocity,FVector& Force)
+void UBulletPhysicsWorldSubsystem::GetPhysicsState(FBulletBodyHandle Handle, FTransform& transforms, FVector& Velocity, FVector& AngularVelocity,FVector& Force)
 {
-	if (BtRigidBodies.Num()<=ID) {
+	btRigidBody* Body = GetRigidBody(Handle);
+	if (!Body) {
 		UE_LOG(LogTemp, Warning, TEXT("No rigid "));
 		return;
 	}
-	if (BtRigidBodies[ID]) {
-		transforms= BulletHelpers::ToUE( BtRigidBodies[ID]->getWorldTransform(),UE_WORLD_ORIGIN) ;
-		Velocity = BulletHelpers::ToUEPos(BtRigidBodies[ID]->getLinearVelocity(), UE_WORLD_ORIGIN);
-		AngularVelocity = BulletHelpers::ToUEPos(BtRigidBodies[ID]->getAngularVelocity(), FVector(0));
-		Force = BulletHelpers::ToUEPos(BtRigidBodies[ID]->getTotalForce(), UE_WORLD_ORIGIN);
-	}
+	transforms= BulletHelpers::ToUE( Body->getWorldTransform(),WorldOrigin) ;
+	Velocity = BulletHelpers::ToUEDir(Body->getLinearVelocity());
+	AngularVelocity = BulletHelpers::ToUEDir(Body->getAngularVelocity());
+	Force = BulletHelpers::ToUEDir(Body->getTotalForce());
 }
 
 void UBulletPhysicsWorldSubsystem::StepPhysics(float deltaSeconds, int maxSubSteps, float fixedTimeStep)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(StepPhysics);
+	// The scheduler is shared between worlds, this only sets our thread count for loops started from this thread while we step
+	FBulletTaskScheduler::FScopedNumThreads ScopedNumThreads(WorldNumThreads);
 	BtWorld->stepSimulation(deltaSeconds,maxSubSteps,fixedTimeStep);
+	FBulletProfiler::ReportWorldCounters(BtWorld);
+	UpdatePoolStats();
+	ApplyTransformWrites();
 
 #if WITH_EDITOR
 	if (DebugEnabled) {
@@ -364,60 +870,848 @@ void UBulletPhysicsWorldSubsystem::StepPhysics(float deltaSeconds, int maxSubSte
 #endif
 }
 
-void UBulletPhysicsWorldSubsystem::AddImpulse(AActor* Target, FVector Impulse, FVector Location)
+void UBulletPhysicsWorldSubsystem::SetWorldTunables(const FBulletWorldTunables& Tunables)
 {
-	int32 Id = INDEX_NONE;
-	if (!ParentObjectCollisionMap.Contains(Target)) return;
-	if (ParentObjectCollisionMap[Target].ObjectIds.Num() == 0) return;
-	
-	Id = ParentObjectCollisionMap[Target].ObjectIds[0];
+	if (!BtWorld) return;
 	
-	BtRigidBodies[Id]->applyImpulse(BulletHelpers::ToBtDir(Impulse, true), BulletHelpers::ToBtPos(Location, UE_WORLD_ORIGIN));
+	// Both the world and its dispatcher were created by FBulletWorldParts in Initialize
+	FBulletWorldParts::SetTunables(BtWorld, BtCollisionDispatcher, bMultithreadedWorld, Tunables);
 }
 
-void UBulletPhysicsWorldSubsystem::AddForce(AActor* Target, FVector Force, FVector Location)
+void UBulletPhysicsWorldSubsystem::UpdatePoolStats()
 {
-	int32 Id = INDEX_NONE;
-	if (!ParentObjectCollisionMap.Contains(Target)) return;
-	if (ParentObjectCollisionMap[Target].ObjectIds.Num() == 0) return;
+	auto Update = [this](FBulletCollisionPoolStats& Stats, const FBulletPoolCounts& Counts, const TCHAR* PoolName, const TCHAR* ProfileSetting)
+	{
+		if (Counts.Overflow > 0 && Stats.PeakOverflow == 0)
+		{
+			UE_LOG(LogBullet, Warning, TEXT("UBulletPhysicsWorldSubsystem:: %s: the %s pool of %d ran out, the rest are allocated one by one. Raise %s in the world's profile"),
+				*GetNameSafe(GetWorld()), PoolName, Counts.Capacity, ProfileSetting);
+		}
+		Stats.Used = Counts.Used;
+		Stats.Capacity = Counts.Capacity;
+		Stats.Overflow = Counts.Overflow;
+		// What the pool would have needed to hold everything
+		Stats.Peak = FMath::Max(Stats.Peak, Counts.Used + Counts.Overflow);
+		Stats.PeakOverflow = FMath::Max(Stats.PeakOverflow, Counts.Overflow);
+	};
+	Update(ManifoldPoolStats, FBulletWorldParts::GetManifoldPoolCounts(BtWorld), TEXT("persistent manifold"), TEXT("MaxPersistentManifolds"));
+	Update(AlgorithmPoolStats, FBulletWorldParts::GetAlgorithmPoolCounts(BtWorld, bMultithreadedWorld), TEXT("collision algorithm"), TEXT("MaxCollisionAlgorithms"));
 	
-	Id = ParentObjectCollisionMap[Target].ObjectIds[0];
-	BtRigidBodies[Id]->applyForce(BulletHelpers::ToBtDir(Force, true), BulletHelpers::ToBtPos(Location, UE_WORLD_ORIGIN));
+	FBulletProfiler::ReportPoolStats(ManifoldPoolStats, AlgorithmPoolStats);
 }
 
-
-btCollisionObject* UBulletPhysicsWorldSubsystem::GetStaticObject(int ID)
+void UBulletPhysicsWorldSubsystem::ApplyTransformWrites()
 {
-	return BtStaticObjects[ID];
+	TransformWriteBuffer.Apply(TransformWriteTeleportType, bSweepTransformWrites, TransformWriteTolerance, TransformWriteRotationTolerance);
 }
 
-
-void UBulletPhysicsWorldSubsystem::SetupStaticGeometryPhysics(TArray<AActor*> Actors, float Friction, float Restitution)
+void UBulletPhysicsWorldSubsystem::RequestWorldStep(int32 SimFrame, float DeltaSeconds)
 {
-	for (AActor* Actor : Actors)
+	if (SimFrame == PendingStepFrame)
 	{
-		ExtractPhysicsGeometry(Actor,[Actor, this, Friction, Restitution](btCollisionShape* Shape, const FTransform& RelTransform)
-		{
-		// Every sub-collider in the actor is passed to this callback function
-		// We're baking this in world space, so apply actor transform to relative
-		const FTransform FinalXform = RelTransform * Actor->GetActorTransform();
-		AddStaticCollision(Shape, FinalXform, Friction, Restitution, Actor);
-		});
+		// Another sim already asked for this frame, its forces are simply accumulated on the bodies until the step
+		return;
 	}
+
+	// NP has moved on to a different frame (forward, or backwards for a resim) so everything queued for the previous one goes in now
+	FlushWorldStep();
+	
+	PendingStepFrame = SimFrame;
+	PendingStepSeconds = DeltaSeconds;
+	NumFinishedSims = 0;
 }
 
-void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(AActor* Actor, PhysicsGeometryCallback CB)
+void UBulletPhysicsWorldSubsystem::FinishSimTick(int32 SimFrame)
 {
-	TInlineComponentArray<UActorComponent*, 20> Components;
-	// Used to easily get a component's transform relative to actor, not parent component
-	const FTransform InvActorTransform = Actor->GetActorTransform().Inverse();
+	if (SimFrame != PendingStepFrame) return;
+	
+	if (++NumFinishedSims >= NumSteppingSims)
+	{
+		FlushWorldStep();
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::FlushWorldStep()
+{
+	if (PendingStepFrame == INDEX_NONE)
+	{
+		return;
+	}
+	
+	const int32 SteppedFrame = PendingStepFrame;
+	const float SteppedSeconds = PendingStepSeconds;
+	PendingStepFrame = INDEX_NONE;
+	PendingStepSeconds = 0.0f;
+	NumFinishedSims = 0;
+	
+	// NP frames are fixed so we advance exactly one NP frame worth of sim, split into our sub steps
+	const int32 NumSubSteps = FMath::Max(SubSteps, 1);
+	StepPhysics(SteppedSeconds, NumSubSteps, SteppedSeconds / NumSubSteps);
+	LastRestoredFrame = INDEX_NONE;
+	
+	UpdateActivationEvents();
+	// Picks up bodies UpdateActivationEvents put back to where they fell asleep
+	ApplyTransformWrites();
+	
+	ContactStream.FinishStep(WorldOrigin, [this](const btCollisionObject* Object, TObjectPtr<AActor>& OutActor, FBulletBodyHandle& OutBody)
+	{
+		ResolveQueryObject(Object, OutActor, OutBody);
+	});
+	
+	// What we just produced is the starting state of the next frame
+	RecordWorldSnapshot(SteppedFrame + 1);
+	
+	if (ActivationEvents.Num() > 0)
+	{
+		OnActivationEvents.Broadcast(ActivationEvents);
+		ActivationEvents.Reset();
+	}
+	
+	if (ContactStream.GetEvents().Num() > 0)
+	{
+		OnContactEvents.Broadcast(ContactStream.GetEvents());
+	}
+	
+	OnWorldStepped.Broadcast(SteppedFrame, SteppedSeconds);
+}
+
+namespace
+{
+	// Snapped to the hash grid in absolute coordinates, so worlds that were rebased differently still agree
+	uint32 HashBodyState(const FBulletBodySnapshot& Body, const FVector& WorldOrigin, double InvPrecision)
+	{
+		const btVector3& Position = Body.WorldTransform.getOrigin();
+		btQuaternion Rotation = Body.WorldTransform.getRotation();
+		// q and -q are the same rotation
+		if (Rotation.getW() < 0)
+		{
+			Rotation = -Rotation;
+		}
+		
+		const double Values[] = {
+			Position.x() + WorldOrigin.X / BULLET_TO_WORLD_SCALE, Position.y() + WorldOrigin.Y / BULLET_TO_WORLD_SCALE, Position.z() + WorldOrigin.Z / BULLET_TO_WORLD_SCALE,
+			Rotation.x(), Rotation.y(), Rotation.z(), Rotation.w(),
+			Body.LinearVelocity.x(), Body.LinearVelocity.y(), Body.LinearVelocity.z(),
+			Body.AngularVelocity.x(), Body.AngularVelocity.y(), Body.AngularVelocity.z() };
+		
+		int64 Quantized[UE_ARRAY_COUNT(Values)];
+		for (int32 i = 0; i < UE_ARRAY_COUNT(Values); ++i)
+		{
+			Quantized[i] = FMath::RoundToInt64(Values[i] * InvPrecision);
+		}
+		return FCrc::MemCrc32(Quantized, sizeof(Quantized));
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::RecordWorldSnapshot(int32 Frame)
+{
+	if (Frame < 0 || WorldSnapshots.Num() == 0 || !BtWorld) return;
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(RecordWorldSnapshot);
+	
+	FBulletWorldSnapshot& Snapshot = WorldSnapshots[Frame % WorldSnapshots.Num()];
+	Snapshot.Frame = Frame;
+	Snapshot.WorldOrigin = WorldOrigin;
+	Snapshot.LocalTime = FBulletWorldParts::VisitWorld(BtWorld, bMultithreadedWorld, [](const auto& World) { return World.GetLocalTime(); });
+	
+	// Hashed while the state is copied anyway
+	const double InvHashPrecision = 1.0 / FMath::Max(StateHashPrecision, UE_KINDA_SMALL_NUMBER * UE_KINDA_SMALL_NUMBER);
+	Snapshot.StateHash = 0;
+	StateHashScratch.Reset();
+	
+	// Only grows when bodies were registered since this slot was last used
+	Snapshot.Bodies.SetNum(BtRigidBodies.Num(), EAllowShrinking::No);
+	for (int32 i = 0; i < BtRigidBodies.Num(); ++i)
+	{
+		const btRigidBody* Body = BtRigidBodies[i];
+		FBulletBodySnapshot& BodySnapshot = Snapshot.Bodies[i];
+		BodySnapshot.Generation = Body ? BtRigidBodyGenerations[i] : INDEX_NONE;
+		BodySnapshot.StateHash = 0;
+		if (!Body) continue;
+		
+		BodySnapshot.WorldTransform = Body->getWorldTransform();
+		BodySnapshot.LinearVelocity = Body->getLinearVelocity();
+		BodySnapshot.AngularVelocity = Body->getAngularVelocity();
+		BodySnapshot.TotalForce = Body->getTotalForce();
+		BodySnapshot.TotalTorque = Body->getTotalTorque();
+		BodySnapshot.DeactivationTime = Body->getDeactivationTime();
+		BodySnapshot.ActivationState = Body->getActivationState();
+		
+		if (bHashWorldState)
+		{
+			BodySnapshot.StateHash = HashBodyState(BodySnapshot, WorldOrigin, InvHashPrecision);
+			StateHashScratch.Add({ BtRigidBodyHashKeys[i], BodySnapshot.StateHash });
+		}
+	}
+	
+	if (bHashWorldState)
+	{
+		// Combined in network id order rather than slot order, which depends on when each body was registered on this machine.
+		// Bodies with the same id are ordered by their own hash
+		StateHashScratch.Sort([](const FBodyHashEntry& A, const FBodyHashEntry& B)
+		{
+			return A.Key != B.Key ? A.Key < B.Key : A.StateHash < B.StateHash;
+		});
+		Snapshot.StateHash = FCrc::MemCrc32(StateHashScratch.GetData(), StateHashScratch.Num() * sizeof(FBodyHashEntry));
+	}
+	
+	// A deterministic world needs its contacts back to replay the same frames
+	Snapshot.Manifolds.Reset();
+	Snapshot.ManifoldPoints.Reset();
+	if (bSnapshotContacts || bDeterministicWorld)
+	{
+		const btDispatcher* Dispatcher = BtWorld->getDispatcher();
+		const int32 NumManifolds = Dispatcher->getNumManifolds();
+		Snapshot.Manifolds.SetNum(NumManifolds, EAllowShrinking::No);
+		for (int32 i = 0; i < NumManifolds; ++i)
+		{
+			const btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+			FBulletManifoldSnapshot& ManifoldSnapshot = Snapshot.Manifolds[i];
+			ManifoldSnapshot.Body0 = GetSnapshotObjectId(Manifold->getBody0());
+			ManifoldSnapshot.Body1 = GetSnapshotObjectId(Manifold->getBody1());
+			ManifoldSnapshot.FirstPoint = Snapshot.ManifoldPoints.Num();
+			ManifoldSnapshot.NumContacts = Manifold->getNumContacts();
+			for (int32 p = 0; p < ManifoldSnapshot.NumContacts; ++p)
+			{
+				Snapshot.ManifoldPoints.Add(Manifold->getContactPoint(p));
+			}
+		}
+	}
+	
+	Snapshot.PairObjects.Reset();
+	if (bDeterministicWorld)
+	{
+		const btBroadphasePairArray& Pairs = BtWorld->getPairCache()->getOverlappingPairArray();
+		Snapshot.PairObjects.SetNum(Pairs.size() * 2, EAllowShrinking::No);
+		for (int32 i = 0; i < Pairs.size(); ++i)
+		{
+			Snapshot.PairObjects[i * 2] = GetSnapshotObjectId(static_cast<const btCollisionObject*>(Pairs[i].m_pProxy0->m_clientObject));
+			Snapshot.PairObjects[i * 2 + 1] = GetSnapshotObjectId(static_cast<const btCollisionObject*>(Pairs[i].m_pProxy1->m_clientObject));
+		}
+	}
+}
+
+FBulletBodyHandle UBulletPhysicsWorldSubsystem::GetSnapshotObjectId(const btCollisionObject* Object) const
+{
+	// Rigid bodies carry their pool slot in the user index, static objects their index in BtStaticObjects
+	const int32 Index = Object->getUserIndex();
+	if (BtRigidBodies.IsValidIndex(Index) && BtRigidBodies[Index] == Object)
+	{
+		return FBulletBodyHandle(Index, BtRigidBodyGenerations[Index]);
+	}
+	if (BtStaticObjects.IsValidIndex(Index) && BtStaticObjects[Index] == Object)
+	{
+		return FBulletBodyHandle(Index, INDEX_NONE);
+	}
+	return FBulletBodyHandle();
+}
+
+btCollisionObject* UBulletPhysicsWorldSubsystem::ResolveSnapshotObjectId(const FBulletBodyHandle& Id) const
+{
+	if (Id.Generation == INDEX_NONE)
+	{
+		return BtStaticObjects.IsValidIndex(Id.Index) ? BtStaticObjects[Id.Index] : nullptr;
+	}
+	return GetRigidBody(Id);
+}
+
+bool UBulletPhysicsWorldSubsystem::RestoreWorldSnapshot(int32 Frame)
+{
+	if (Frame == LastRestoredFrame)
+	{
+		// Another sim in this rollback already put the world back
+		return true;
+	}
+	
+	if (Frame < 0 || WorldSnapshots.Num() == 0 || !BtWorld) return false;
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(RestoreWorldSnapshot);
+	
+	const FBulletWorldSnapshot& Snapshot = WorldSnapshots[Frame % WorldSnapshots.Num()];
+	if (Snapshot.Frame != Frame)
+	{
+		UE_LOG(LogBullet, Warning, TEXT("UBulletPhysicsWorldSubsystem::RestoreWorldSnapshot: frame %d is not in the snapshot history (slot holds %d). Increase SnapshotHistorySize."), Frame, Snapshot.Frame);
+		return false;
+	}
+	
+	// Anything queued for a frame we're rolling back over is stale now
+	PendingStepFrame = INDEX_NONE;
+	PendingStepSeconds = 0.0f;
+	NumFinishedSims = 0;
+	
+	// Snapshots taken before a rebase are still relative to the old origin
+	const btVector3 OriginOffset = BulletHelpers::ToBtDir(Snapshot.WorldOrigin - WorldOrigin);
+	
+	const int32 NumBodies = FMath::Min(Snapshot.Bodies.Num(), BtRigidBodies.Num());
+	for (int32 i = 0; i < NumBodies; ++i)
+	{
+		btRigidBody* Body = BtRigidBodies[i];
+		const FBulletBodySnapshot& BodySnapshot = Snapshot.Bodies[i];
+		// Bodies registered after the snapshot was taken keep their current state
+		if (!Body || BtRigidBodyGenerations[i] != BodySnapshot.Generation) continue;
+		
+		btTransform WorldTransform = BodySnapshot.WorldTransform;
+		WorldTransform.getOrigin() += OriginOffset;
+		Body->setWorldTransform(WorldTransform);
+		Body->setInterpolationWorldTransform(WorldTransform);
+		Body->setLinearVelocity(BodySnapshot.LinearVelocity);
+		Body->setAngularVelocity(BodySnapshot.AngularVelocity);
+		Body->setInterpolationLinearVelocity(BodySnapshot.LinearVelocity);
+		Body->setInterpolationAngularVelocity(BodySnapshot.AngularVelocity);
+		// The world inertia follows the orientation, and is otherwise only brought up to date by the next integration
+		Body->updateInertiaTensor();
+		
+		// Totals were captured with the linear/angular factors already applied
+		Body->clearForces();
+		Body->applyCentralForce(BodySnapshot.TotalForce);
+		Body->applyTorque(BodySnapshot.TotalTorque);
+		
+		Body->forceActivationState(BodySnapshot.ActivationState);
+		Body->setDeactivationTime(BodySnapshot.DeactivationTime);
+		
+		FRigidBodyActivation& Activation = BtRigidBodyActivation[i];
+		Activation.bSleeping = !Body->isActive();
+		SetSleepPinned(i, Activation.bSleeping && !Activation.bWakeOnContact);
+		
+		FBulletWorldParts::VisitWorld(BtWorld, bMultithreadedWorld, [Body](auto& World) { World.UpdateSingleAabb(Body); });
+	}
+	
+	if (bDeterministicWorld)
+	{
+		PairRestoreObjects.SetNum(Snapshot.PairObjects.Num(), EAllowShrinking::No);
+		for (int32 i = 0; i < Snapshot.PairObjects.Num(); ++i)
+		{
+			PairRestoreObjects[i] = ResolveSnapshotObjectId(Snapshot.PairObjects[i]);
+		}
+	}
+	
+	FBulletWorldParts::VisitWorld(BtWorld, bMultithreadedWorld, [this, &Snapshot](auto& World)
+	{
+		World.SetLocalTime(Snapshot.LocalTime);
+		if (bDeterministicWorld)
+		{
+			// The pairs the first run had, with fresh contact caches for the snapshot's contacts to go into
+			World.RestoreCollisionPairs(PairRestoreObjects.GetData(), PairRestoreObjects.Num() / 2);
+		}
+	});
+	
+	if (bSnapshotContacts || bDeterministicWorld)
+	{
+		RestoreManifolds(Snapshot, OriginOffset);
+	}
+	
+	// Contacts are compared against the rewound world from here on, so the resimulated frames report theirs again
+	ContactStream.ResetToWorld(BtWorld->getDispatcher(), WorldOrigin, [this](const btCollisionObject* Object, TObjectPtr<AActor>& OutActor, FBulletBodyHandle& OutBody)
+	{
+		ResolveQueryObject(Object, OutActor, OutBody);
+	});
+	
+	LastRestoredFrame = Frame;
+	return true;
+}
+
+void UBulletPhysicsWorldSubsystem::RestoreManifolds(const FBulletWorldSnapshot& Snapshot, const btVector3& OriginOffset)
+{
+	ManifoldRestoreLookup.Reset();
+	ManifoldRestorePairLookup.Reset();
+	ManifoldRestoreUsed.Init(false, Snapshot.Manifolds.Num());
+	ManifoldRestoreLeftovers.Reset();
+	// Later captures first, so the pair lookup below hands them out in the order they were captured
+	for (int32 i = Snapshot.Manifolds.Num() - 1; i >= 0; --i)
+	{
+		const FBulletManifoldSnapshot& ManifoldSnapshot = Snapshot.Manifolds[i];
+		if (ManifoldSnapshot.NumContacts == 0) continue;
+		
+		const btManifoldPoint& FirstPoint = Snapshot.ManifoldPoints[ManifoldSnapshot.FirstPoint];
+		ManifoldRestoreLookup.Add(MakeTuple(ManifoldSnapshot.Body0, ManifoldSnapshot.Body1, FirstPoint.m_index0, FirstPoint.m_index1), i);
+		ManifoldRestorePairLookup.Add(MakeTuple(ManifoldSnapshot.Body0, ManifoldSnapshot.Body1), i);
+	}
+	
+	auto RestoreManifold = [this, &Snapshot, &OriginOffset](btPersistentManifold* Manifold, int32 SnapshotIndex)
+	{
+		const FBulletManifoldSnapshot& ManifoldSnapshot = Snapshot.Manifolds[SnapshotIndex];
+		ManifoldRestoreUsed[SnapshotIndex] = true;
+		for (int32 p = 0; p < ManifoldSnapshot.NumContacts; ++p)
+		{
+			btManifoldPoint& Point = Manifold->getContactPoint(p);
+			Point = Snapshot.ManifoldPoints[ManifoldSnapshot.FirstPoint + p];
+			Point.m_positionWorldOnA += OriginOffset;
+			Point.m_positionWorldOnB += OriginOffset;
+		}
+		Manifold->setNumContacts(ManifoldSnapshot.NumContacts);
+	};
+	
+	// Caches that have contacts now are matched on their pair and the child their contacts came from
+	btDispatcher* Dispatcher = BtWorld->getDispatcher();
+	for (int32 i = 0; i < Dispatcher->getNumManifolds(); ++i)
+	{
+		btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+		const int32* SnapshotIndex = Manifold->getNumContacts() > 0
+			? ManifoldRestoreLookup.Find(MakeTuple(GetSnapshotObjectId(Manifold->getBody0()), GetSnapshotObjectId(Manifold->getBody1()),
+				Manifold->getContactPoint(0).m_index0, Manifold->getContactPoint(0).m_index1))
+			: nullptr;
+		if (SnapshotIndex && !ManifoldRestoreUsed[*SnapshotIndex])
+		{
+			RestoreManifold(Manifold, *SnapshotIndex);
+		}
+		else
+		{
+			ManifoldRestoreLeftovers.Add(Manifold);
+		}
+	}
+	
+	// The rest take whatever the snapshot has left for their pair
+	for (btPersistentManifold* Manifold : ManifoldRestoreLeftovers)
+	{
+		bool bRestored = false;
+		for (auto It = ManifoldRestorePairLookup.CreateKeyIterator(MakeTuple(GetSnapshotObjectId(Manifold->getBody0()), GetSnapshotObjectId(Manifold->getBody1()))); It; ++It)
+		{
+			if (!ManifoldRestoreUsed[It.Value()])
+			{
+				RestoreManifold(Manifold, It.Value());
+				bRestored = true;
+				break;
+			}
+		}
+		
+		if (!bRestored)
+		{
+			// This pair only started touching after the frame we're going back to
+			Manifold->clearManifold();
+		}
+	}
+	
+	// Pairs that were touching back then but have since separated get their contacts rebuilt by the narrowphase during the resim
+}
+
+bool UBulletPhysicsWorldSubsystem::GetWorldStateHash(int32 Frame, uint32& OutHash) const
+{
+	if (!bHashWorldState || Frame < 0 || WorldSnapshots.Num() == 0) return false;
+	
+	const FBulletWorldSnapshot& Snapshot = WorldSnapshots[Frame % WorldSnapshots.Num()];
+	if (Snapshot.Frame != Frame) return false;
+	
+	OutHash = Snapshot.StateHash;
+	return true;
+}
+
+bool UBulletPhysicsWorldSubsystem::GetReplicatedWorldStateHash(int32 Frame, uint32& OutHash) const
+{
+	// Clients compare the authority's hash against their own snapshots, they never send theirs
+	if (GetWorld()->GetNetMode() == NM_Client) return false;
+	if (StateHashReplicationInterval <= 0 || Frame % StateHashReplicationInterval != 0) return false;
+	
+	return GetWorldStateHash(Frame, OutHash);
+}
+
+void UBulletPhysicsWorldSubsystem::CheckAuthorityWorldStateHash(int32 LocalFrame, int32 AuthorityFrame, uint32 AuthorityHash)
+{
+	uint32 LocalHash = 0;
+	if (GetWorldStateHash(LocalFrame, LocalHash) && LocalHash != AuthorityHash)
+	{
+		ReportWorldStateMismatch(LocalFrame, AuthorityFrame, LocalHash, AuthorityHash);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::ReportWorldStateMismatch(int32 LocalFrame, int32 AuthorityFrame, uint32 LocalHash, uint32 AuthorityHash)
+{
+	// Every sim we reconcile carries the same hash, and resims check the same frames again
+	if (LocalFrame == LastMismatchFrame) return;
+	
+	LastMismatchFrame = LocalFrame;
+	++NumMismatches;
+	
+	if (FirstDesync.Frame != INDEX_NONE)
+	{
+		UE_LOG(LogBullet, Verbose, TEXT("UBulletPhysicsWorldSubsystem: bullet world differs from the authority on frame %d (authority frame %d) as well, %d frames so far"), LocalFrame, AuthorityFrame, NumMismatches);
+		return;
+	}
+	
+	UE_LOG(LogBullet, Warning, TEXT("UBulletPhysicsWorldSubsystem: bullet world diverged from the authority on frame %d (authority frame %d, hash %08x, authority %08x). bullet.DumpDesync lists the bodies that differ"),
+		LocalFrame, AuthorityFrame, LocalHash, AuthorityHash);
+	
+	FirstDesync.Frame = LocalFrame;
+	FirstDesync.AuthorityFrame = AuthorityFrame;
+	FirstDesync.LocalHash = LocalHash;
+	FirstDesync.AuthorityHash = AuthorityHash;
+	CaptureBodyStates(LocalFrame, FirstDesync.LocalBodies);
+	
+	// The authority is a few frames ahead and will soon drop this one from its history, so its side is grabbed now when it's in the same process
+	FirstDesync.AuthorityBodies.Reset();
+	FirstDesync.bHasAuthorityBodies = false;
+	if (!GEngine) return;
+	
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		const UWorld* OtherWorld = Context.World();
+		if (!OtherWorld || OtherWorld == GetWorld()) continue;
+		
+		const ENetMode NetMode = OtherWorld->GetNetMode();
+		if (NetMode != NM_DedicatedServer && NetMode != NM_ListenServer) continue;
+		
+		if (const UBulletPhysicsWorldSubsystem* Authority = OtherWorld->GetSubsystem<UBulletPhysicsWorldSubsystem>())
+		{
+			FirstDesync.bHasAuthorityBodies = Authority->CaptureBodyStates(AuthorityFrame, FirstDesync.AuthorityBodies);
+			break;
+		}
+	}
+}
+
+bool UBulletPhysicsWorldSubsystem::CaptureBodyStates(int32 Frame, TArray<FBulletBodyStateRecord>& OutBodies) const
+{
+	OutBodies.Reset();
+	if (Frame < 0 || WorldSnapshots.Num() == 0) return false;
+	
+	const FBulletWorldSnapshot& Snapshot = WorldSnapshots[Frame % WorldSnapshots.Num()];
+	if (Snapshot.Frame != Frame) return false;
+	
+	for (int32 i = 0; i < Snapshot.Bodies.Num(); ++i)
+	{
+		const FBulletBodySnapshot& BodySnapshot = Snapshot.Bodies[i];
+		if (BodySnapshot.Generation == INDEX_NONE) continue;
+		
+		// A body unregistered since then has lost its owner
+		const bool bLive = BtRigidBodies.IsValidIndex(i) && BtRigidBodies[i] && BtRigidBodyGenerations[i] == BodySnapshot.Generation;
+		const AActor* Owner = bLive ? static_cast<const AActor*>(BtRigidBodies[i]->getUserPointer()) : nullptr;
+		
+		FBulletBodyStateRecord& Record = OutBodies.AddDefaulted_GetRef();
+		Record.Owner = Owner ? Owner->GetName() : FString::Printf(TEXT("<body %d>"), i);
+		Record.NetworkKey = bLive ? BtRigidBodyHashKeys[i] : 0;
+		Record.Slot = i;
+		Record.StateHash = BodySnapshot.StateHash;
+		Record.Location = BulletHelpers::ToUEPos(BodySnapshot.WorldTransform.getOrigin(), Snapshot.WorldOrigin);
+		Record.Rotation = BulletHelpers::ToUE(BodySnapshot.WorldTransform.getRotation());
+		Record.LinearVelocity = BulletHelpers::ToUEDir(BodySnapshot.LinearVelocity);
+		Record.AngularVelocity = FVector(
+			FMath::RadiansToDegrees(BodySnapshot.AngularVelocity.x()),
+			FMath::RadiansToDegrees(BodySnapshot.AngularVelocity.y()),
+			FMath::RadiansToDegrees(BodySnapshot.AngularVelocity.z()));
+	}
+	return true;
+}
+
+namespace
+{
+	void LogBodyState(const FBulletBodyStateRecord& Body)
+	{
+		UE_LOG(LogBullet, Display, TEXT("  %s [slot %d] hash %08x location %s rotation %s velocity %s angular velocity %s"),
+			*Body.Owner, Body.Slot, Body.StateHash, *Body.Location.ToString(), *Body.Rotation.Rotator().ToString(), *Body.LinearVelocity.ToString(), *Body.AngularVelocity.ToString());
+	}
+	
+	// Slots and runtime actor names differ between worlds, so bodies are matched by their network id and which of the bodies with that id they are.
+	// Bodies without one can't be matched
+	TMap<TPair<uint32, int32>, int32> MakeBodyStateKeys(const TArray<FBulletBodyStateRecord>& Bodies)
+	{
+		TMap<TPair<uint32, int32>, int32> Keys;
+		TMap<uint32, int32> KeyCounts;
+		for (int32 i = 0; i < Bodies.Num(); ++i)
+		{
+			if (Bodies[i].NetworkKey == 0) continue;
+			
+			int32& Count = KeyCounts.FindOrAdd(Bodies[i].NetworkKey);
+			Keys.Add(MakeTuple(Bodies[i].NetworkKey, Count++), i);
+		}
+		return Keys;
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::DumpDesync(int32 Frame) const
+{
+	if (Frame != INDEX_NONE)
+	{
+		TArray<FBulletBodyStateRecord> Bodies;
+		if (!CaptureBodyStates(Frame, Bodies))
+		{
+			UE_LOG(LogBullet, Warning, TEXT("bullet.DumpDesync: frame %d is not in the snapshot history"), Frame);
+			return;
+		}
+		
+		uint32 Hash = 0;
+		GetWorldStateHash(Frame, Hash);
+		UE_LOG(LogBullet, Display, TEXT("bullet.DumpDesync: frame %d, world hash %08x, %d bodies"), Frame, Hash, Bodies.Num());
+		for (const FBulletBodyStateRecord& Body : Bodies)
+		{
+			LogBodyState(Body);
+		}
+		return;
+	}
+	
+	if (FirstDesync.Frame == INDEX_NONE)
+	{
+		UE_LOG(LogBullet, Display, TEXT("bullet.DumpDesync: the bullet world hasn't diverged from the authority"));
+		return;
+	}
+	
+	UE_LOG(LogBullet, Display, TEXT("bullet.DumpDesync: first desync on frame %d (authority frame %d), hash %08x, authority %08x. %d frames have differed so far"),
+		FirstDesync.Frame, FirstDesync.AuthorityFrame, FirstDesync.LocalHash, FirstDesync.AuthorityHash, NumMismatches);
+	
+	if (!FirstDesync.bHasAuthorityBodies)
+	{
+		UE_LOG(LogBullet, Display, TEXT("bullet.DumpDesync: the authority isn't in this process, these are all %d bodies of the frame. Compare with bullet.DumpDesync %d on the server while it still has the frame"),
+			FirstDesync.LocalBodies.Num(), FirstDesync.AuthorityFrame);
+		for (const FBulletBodyStateRecord& Body : FirstDesync.LocalBodies)
+		{
+			LogBodyState(Body);
+		}
+		return;
+	}
+	
+	const TMap<TPair<uint32, int32>, int32> LocalKeys = MakeBodyStateKeys(FirstDesync.LocalBodies);
+	const TMap<TPair<uint32, int32>, int32> AuthorityKeys = MakeBodyStateKeys(FirstDesync.AuthorityBodies);
+	
+	int32 NumDiffering = 0;
+	for (const FBulletBodyStateRecord& Local : FirstDesync.LocalBodies)
+	{
+		if (Local.NetworkKey == 0)
+		{
+			UE_LOG(LogBullet, Display, TEXT("  %s [slot %d] has no network id and can't be compared"), *Local.Owner, Local.Slot);
+		}
+	}
+	
+	for (const TPair<TPair<uint32, int32>, int32>& It : LocalKeys)
+	{
+		const FBulletBodyStateRecord& Local = FirstDesync.LocalBodies[It.Value];
+		const int32* AuthorityIndex = AuthorityKeys.Find(It.Key);
+		if (!AuthorityIndex)
+		{
+			++NumDiffering;
+			UE_LOG(LogBullet, Display, TEXT("  %s [slot %d] only exists here"), *Local.Owner, Local.Slot);
+			continue;
+		}
+		
+		const FBulletBodyStateRecord& Authority = FirstDesync.AuthorityBodies[*AuthorityIndex];
+		if (Local.StateHash == Authority.StateHash) continue;
+		
+		++NumDiffering;
+		UE_LOG(LogBullet, Display, TEXT("  %s [slot %d]: location off by %.4f cm (%s, authority %s), rotation by %.4f deg, velocity by %.4f cm/s, angular velocity by %.4f deg/s"),
+			*Local.Owner, Local.Slot, FVector::Dist(Local.Location, Authority.Location), *Local.Location.ToString(), *Authority.Location.ToString(),
+			FMath::RadiansToDegrees(Local.Rotation.AngularDistance(Authority.Rotation)), FVector::Dist(Local.LinearVelocity, Authority.LinearVelocity),
+			FVector::Dist(Local.AngularVelocity, Authority.AngularVelocity));
+	}
+	
+	for (const TPair<TPair<uint32, int32>, int32>& It : AuthorityKeys)
+	{
+		if (LocalKeys.Contains(It.Key)) continue;
+		
+		++NumDiffering;
+		UE_LOG(LogBullet, Display, TEXT("  %s only exists on the authority"), *FirstDesync.AuthorityBodies[It.Value].Owner);
+	}
+	
+	UE_LOG(LogBullet, Display, TEXT("bullet.DumpDesync: %d of %d bodies differ"), NumDiffering, FirstDesync.LocalBodies.Num());
+}
+
+void UBulletPhysicsWorldSubsystem::ResetDesync()
+{
+	FirstDesync = FBulletDesyncCapture();
+	LastMismatchFrame = INDEX_NONE;
+	NumMismatches = 0;
+}
+
+namespace
+{
+	void DumpDesyncCommand(const TArray<FString>& Args, UWorld* World)
+	{
+		UBulletPhysicsWorldSubsystem* Subsystem = World ? World->GetSubsystem<UBulletPhysicsWorldSubsystem>() : nullptr;
+		if (!Subsystem)
+		{
+			UE_LOG(LogBullet, Warning, TEXT("bullet.DumpDesync: this world has no bullet physics"));
+			return;
+		}
+		
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			Subsystem->ResetDesync();
+			return;
+		}
+		
+		Subsystem->DumpDesync(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : INDEX_NONE);
+	}
+	
+	FAutoConsoleCommandWithWorldAndArgs CmdDumpDesync(
+		TEXT("bullet.DumpDesync"),
+		TEXT("Logs the bodies that differed from the authority on the first frame the world hashes disagreed. bullet.DumpDesync <frame> logs every body of that frame instead, bullet.DumpDesync reset waits for the next desync"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&DumpDesyncCommand));
+}
+
+void UBulletPhysicsWorldSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick InLevelTick, float InDeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		FlushWorldStep();
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::OnWorldOriginOffset(UWorld* InWorld, FIntVector SrcOrigin, FIntVector DstOrigin)
+{
+	if (InWorld != GetWorld()) return;
+	
+	// UE has moved everything by -(Dst - Src). Our origin moved with it, so bullet is still consistent, only the UE coordinates of it changed
+	const FVector Offset = FVector(DstOrigin - SrcOrigin);
+	WorldOrigin -= Offset;
+	for (FBulletWorldSnapshot& Snapshot : WorldSnapshots)
+	{
+		Snapshot.WorldOrigin -= Offset;
+	}
+	
+	for (btRigidBody* Body : BtRigidBodies)
+	{
+		if (Body && Body->getMotionState())
+		{
+			static_cast<FBulletMotionStateBase*>(Body->getMotionState())->SetWorldOrigin(WorldOrigin);
+		}
+	}
+	
+	if (bFollowWorldOriginShifts)
+	{
+		// Put bullet's origin back on UE's, which is now where the action is
+		RebaseWorldOrigin(FVector::ZeroVector);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::RebaseWorldOrigin(FVector NewOrigin)
+{
+	if (!BtWorld || NewOrigin.Equals(WorldOrigin)) return;
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(RebaseWorldOrigin);
+	
+	// Whatever was queued for the current frame has to be stepped in the coordinates it was queued in
+	FlushWorldStep();
+	
+	const btVector3 Offset = BulletHelpers::ToBtDir(NewOrigin - WorldOrigin);
+	if (bMultithreadedWorld)
+	{
+		static_cast<FBulletDynamicsWorldMt*>(BtWorld)->ShiftOrigin(Offset);
+	}
+	else
+	{
+		static_cast<FBulletDynamicsWorld*>(BtWorld)->ShiftOrigin(Offset);
+	}
+	WorldOrigin = NewOrigin;
+	
+	for (int32 i = 0; i < BtRigidBodies.Num(); ++i)
+	{
+		btRigidBody* Body = BtRigidBodies[i];
+		if (!Body) continue;
+		
+		// Every motion state was constructed by AddRigidBody in a pool slot, so they all share the base
+		if (Body->getMotionState())
+		{
+			static_cast<FBulletMotionStateBase*>(Body->getMotionState())->SetWorldOrigin(WorldOrigin);
+		}
+	}
+	
+	UE_LOG(LogBullet, Log, TEXT("UBulletPhysicsWorldSubsystem: rebased bullet world origin to %s"), *WorldOrigin.ToString());
+}
+
+void UBulletPhysicsWorldSubsystem::RaycastBatch(const TArray<FBulletRaycast>& Rays, TArray<FBulletQueryHit>& OutHits, bool bParallel)
+{
+	OutHits.SetNum(Rays.Num(), EAllowShrinking::No);
+	if (!BtWorld) return;
+	
+	SceneQuery.Raycast(BtWorld, WorldOrigin, Rays, OutHits, bParallel);
+	for (FBulletQueryHit& Hit : OutHits)
+	{
+		ResolveQueryObject(Hit.HitObject, Hit.Actor, Hit.Body);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::SphereSweepBatch(const TArray<FBulletSphereSweep>& Sweeps, TArray<FBulletQueryHit>& OutHits, bool bParallel)
+{
+	OutHits.SetNum(Sweeps.Num(), EAllowShrinking::No);
+	if (!BtWorld) return;
+	
+	SceneQuery.SphereSweep(BtWorld, WorldOrigin, Sweeps, OutHits, bParallel);
+	for (FBulletQueryHit& Hit : OutHits)
+	{
+		ResolveQueryObject(Hit.HitObject, Hit.Actor, Hit.Body);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::SphereOverlapBatch(const TArray<FBulletSphereOverlap>& Spheres, TArray<FBulletOverlapResult>& OutOverlaps)
+{
+	OutOverlaps.Reset();
+	if (!BtWorld) return;
+	
+	SceneQuery.SphereOverlap(BtWorld, WorldOrigin, Spheres, OutOverlaps);
+	for (FBulletOverlapResult& Overlap : OutOverlaps)
+	{
+		ResolveQueryObject(Overlap.HitObject, Overlap.Actor, Overlap.Body);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::ResolveQueryObject(const btCollisionObject* Object, TObjectPtr<AActor>& OutActor, FBulletBodyHandle& OutBody) const
+{
+	if (!Object) return;
+	
+	OutActor = static_cast<AActor*>(Object->getUserPointer());
+	// Pooled rigid bodies carry their slot in the user index, static objects their index in BtStaticObjects
+	const int32 Index = Object->getUserIndex();
+	if (BtRigidBodies.IsValidIndex(Index) && BtRigidBodies[Index] == Object)
+	{
+		OutBody = FBulletBodyHandle(Index, BtRigidBodyGenerations[Index]);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::AddImpulse(AActor* Target, FVector Impulse, FVector Location)
+{
+	if (!ParentObjectCollisionMap.Contains(Target)) return;
+	if (ParentObjectCollisionMap[Target].Bodies.Num() == 0) return;
+	
+	const FBulletBodyHandle& Handle = ParentObjectCollisionMap[Target].Bodies[0];
+	btRigidBody* Body = GetRigidBody(Handle);
+	if (!Body) return;
+	
+	WakeRigidBodySlot(Handle.Index);
+	// Bullet wants the point relative to the centre of mass, not in world space
+	Body->applyImpulse(BulletHelpers::ToBtDir(Impulse, true), BulletHelpers::ToBtPos(Location, WorldOrigin) - Body->getCenterOfMassPosition());
+}
+
+void UBulletPhysicsWorldSubsystem::AddForce(AActor* Target, FVector Force, FVector Location)
+{
+	if (!ParentObjectCollisionMap.Contains(Target)) return;
+	if (ParentObjectCollisionMap[Target].Bodies.Num() == 0) return;
+	
+	const FBulletBodyHandle& Handle = ParentObjectCollisionMap[Target].Bodies[0];
+	btRigidBody* Body = GetRigidBody(Handle);
+	if (!Body) return;
+	
+	WakeRigidBodySlot(Handle.Index);
+	Body->applyForce(BulletHelpers::ToBtDir(Force, true), BulletHelpers::ToBtPos(Location, WorldOrigin) - Body->getCenterOfMassPosition());
+}
+
+
+btCollisionObject* UBulletPhysicsWorldSubsystem::GetStaticObject(int ID)
+{
+	return BtStaticObjects[ID];
+}
+
+
+void UBulletPhysicsWorldSubsystem::SetupStaticGeometryPhysics(TArray<AActor*> Actors, float Friction, float Restitution)
+{
+	for (AActor* Actor : Actors)
+	{
+		ExtractPhysicsGeometry(Actor,[Actor, this, Friction, Restitution](btCollisionShape* Shape, const FTransform& RelTransform)
+		{
+		// Every sub-collider in the actor is passed to this callback function
+		// We're baking this in world space, so apply actor transform to relative
+		const FTransform FinalXform = RelTransform * Actor->GetActorTransform();
+		AddStaticCollision(Shape, FinalXform, Friction, Restitution, Actor);
+		}, true);
+	}
+}
+
+void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(AActor* Actor, PhysicsGeometryCallback CB, bool bComplexCollision)
+{
+	TInlineComponentArray<UActorComponent*, 20> Components;
+	// Used to easily get a component's transform relative to actor, not parent component
+	const FTransform InvActorTransform = Actor->GetActorTransform().Inverse();
 
 	// Collisions from meshes
 
 	Actor->GetComponents(UStaticMeshComponent::StaticClass(), Components);
 	for (auto&& Comp : Components)
 	{
-		ExtractPhysicsGeometry(Cast<UStaticMeshComponent>(Comp), InvActorTransform, CB);
+		ExtractPhysicsGeometry(Cast<UStaticMeshComponent>(Comp), InvActorTransform, CB, bComplexCollision);
 	}
 
 	// Collisions from separate collision components
@@ -426,6 +1720,13 @@ void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(AActor* Actor, Physics
 	{
 		ExtractPhysicsGeometry(Cast<UShapeComponent>(Comp), InvActorTransform, CB);
 	}
+
+	// Landscape heightfields
+	Actor->GetComponents(ULandscapeHeightfieldCollisionComponent::StaticClass(), Components);
+	for (auto&& Comp : Components)
+	{
+		ExtractPhysicsGeometry(Cast<ULandscapeHeightfieldCollisionComponent>(Comp), InvActorTransform, CB);
+	}
 }
 
 btCollisionObject* UBulletPhysicsWorldSubsystem::AddStaticCollision(btCollisionShape* Shape, const FTransform& Transform, float Friction,
@@ -435,20 +1736,24 @@ btCollisionObject* UBulletPhysicsWorldSubsystem::AddStaticCollision(btCollisionS
 		UE_LOG(LogTemp, Warning, TEXT("UBulletPhysicsWorldSubsystem::AddStaticCollision: BtWorld is empty"));
 		return nullptr;
 	}
-	btTransform Xform = BulletHelpers::ToBt(Transform, UE_WORLD_ORIGIN);
+	btTransform Xform = BulletHelpers::ToBt(Transform, WorldOrigin);
 	btCollisionObject* Obj = new btCollisionObject();
 	Obj->setCollisionShape(Shape);
 	Obj->setWorldTransform(Xform);
 	Obj->setFriction(Friction);
 	Obj->setRestitution(Restitution);
 	Obj->setUserPointer(Actor);
-	Obj->setActivationState(DISABLE_DEACTIVATION);
+	// Lets snapshots name the object, see GetSnapshotObjectId
+	Obj->setUserIndex(BtStaticObjects.Num());
+	FBulletSceneQuery::SetObjectChannel(Obj, Actor, ECC_WorldStatic);
+	// Static geometry never moves, sleeping keeps it out of the per step aabb update now that it isn't forced for every object, see Initialize
+	Obj->setActivationState(ISLAND_SLEEPING);
 	BtWorld->addCollisionObject(Obj);
 	BtStaticObjects.Add(Obj);
 	return Obj;
 }
 
-void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(UStaticMeshComponent* SMC, const FTransform& InvActorXform, PhysicsGeometryCallback CB)
+void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(UStaticMeshComponent* SMC, const FTransform& InvActorXform, PhysicsGeometryCallback CB, bool bComplexCollision)
 {
 	UStaticMesh* Mesh = SMC->GetStaticMesh();
 	if (!Mesh)
@@ -459,15 +1764,32 @@ void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(UStaticMeshComponent*
 	
 	// We want the complete transform from actor to this component, not just relative to parent
 	FTransform CompFullRelXForm = CompTransform * InvActorXform;
-	ExtractPhysicsGeometry(CompFullRelXForm, Mesh->GetBodySetup(), CB);
+	UBodySetup* BodySetup = Mesh->GetBodySetup();
+
+	// Complex collision only comes from a mesh cooked in the editor, see UBulletCookedTriMesh
+	// The triangle data Chaos cooks from is editor only, and building a bvh here would be paid on every level load
+	UBulletCookedTriMesh* Cooked = bComplexCollision ? Mesh->GetAssetUserData<UBulletCookedTriMesh>() : nullptr;
+	if (Cooked && Cooked->IsCooked() && BodySetup &&
+		(BodySetup->GetCollisionTraceFlag() == CTF_UseComplexAsSimple || BodySetup->AggGeom.GetElementCount() == 0))
+	{
+		CB(GetCookedTriMeshShape(Cooked, CompFullRelXForm.GetScale3D()), CompFullRelXForm);
+		return;
+	}
 
-	// Not supporting complex collision shapes right now
-	// If we did, note that Mesh->ComplexCollisionMesh is WITH_EDITORONLY_DATA so not available at runtime
-	// See StaticMeshRender.cpp, FStaticMeshSceneProxy::GetDynamicMeshElements
-	// Line 1417+, bDrawComplexCollision
-	// Looks like we have to access LODForCollision, RenderData->LODResources
-	// So they use a mesh LOD for collision for complex shapes, never drawn usually?
+	// Dynamic bodies take a cooked convex decomposition over the mesh's own simple collision, see UBulletCookedConvexHulls
+	UBulletCookedConvexHulls* CookedHulls = bComplexCollision ? nullptr : Mesh->GetAssetUserData<UBulletCookedConvexHulls>();
+	if (CookedHulls && CookedHulls->IsCooked())
+	{
+		// The hulls carry the scale, so only the position and rotation are left to the transform
+		const FVector Scale = CompFullRelXForm.GetScale3D();
+		for (int32 i = 0; i < CookedHulls->Hulls.Num(); ++i)
+		{
+			CB(GetCookedConvexHullShape(CookedHulls, i, Scale), CompFullRelXForm);
+		}
+		return;
+	}
 
+	ExtractPhysicsGeometry(CompFullRelXForm, BodySetup, CB);
 }
 
 
@@ -479,6 +1801,20 @@ void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(UShapeComponent* Sc, c
 }
 
 
+void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(ULandscapeHeightfieldCollisionComponent* Lc, const FTransform& InvActorXform, PhysicsGeometryCallback CB)
+{
+	// Scale is baked into the shape, ShapeXform only places its centre
+	FTransform ShapeXform;
+	btCollisionShape* Shape = FBulletLandscapeHeightfieldShape::Create(Lc, ShapeXform);
+	if (!Shape)
+		return;
+
+	// Every landscape component gets its own heightfield, nothing to share with other actors
+	UncachedShapes.Add(Shape);
+	CB(Shape, ShapeXform * InvActorXform);
+}
+
+
 void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(const FTransform& XformSoFar, UBodySetup* BodySetup, PhysicsGeometryCallback CB)
 {
 	FVector Scale = XformSoFar.GetScale3D();
@@ -492,6 +1828,7 @@ void UBulletPhysicsWorldSubsystem::ExtractPhysicsGeometry(const FTransform& Xfor
 		if (Scale.Z==0) {
 			btVector3 planeNormal(0,0,1);
 			Shape = new btStaticPlaneShape(planeNormal, 0);	
+			UncachedShapes.Add(Shape);
 			UE_LOG(LogTemp, Warning, TEXT("UBulletPhysicsWorldSubsystem:: creating plane"));
 		}else { 
 			// We'll re-use based on just the LxWxH, including actor scale
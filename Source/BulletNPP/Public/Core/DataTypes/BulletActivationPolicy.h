@@ -0,0 +1,57 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/DataTypes/BulletBodyHandle.h"
+#include "BulletActivationPolicy.generated.h"
+
+/** When and how a rigid body is allowed to go to sleep (be deactivated) in the bullet world */
+USTRUCT(BlueprintType)
+struct FBulletActivationPolicy
+{
+	GENERATED_BODY()
+
+	// If false the body is never deactivated and pays the full simulation cost every step
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Activation")
+	bool bAllowSleep = true;
+
+	// Linear speed (cm/s) below which the body counts as resting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Activation", meta = (ClampMin = 0, EditCondition = "bAllowSleep"))
+	float LinearSleepThreshold = 80.f;
+
+	// Angular speed (deg/s) below which the body counts as resting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Activation", meta = (ClampMin = 0, EditCondition = "bAllowSleep"))
+	float AngularSleepThreshold = 57.3f;
+
+	// How long (seconds) the body has to stay resting before it goes to sleep
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Activation", meta = (ClampMin = 0, EditCondition = "bAllowSleep"))
+	float DeactivationTime = 2.f;
+
+	// If false, a sleeping body is only woken explicitly (forces, impulses, state changes) and never by something bumping into it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Activation", meta = (EditCondition = "bAllowSleep"))
+	bool bWakeOnContact = true;
+};
+
+UENUM(BlueprintType)
+enum class EBulletActivationEventType : uint8
+{
+	// The body was sleeping and is being simulated again
+	Woke,
+
+	// The body came to rest and has been taken out of the simulation
+	FellAsleep,
+};
+
+/** A rigid body changing activation state during a world step */
+USTRUCT(BlueprintType)
+struct FBulletActivationEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Activation")
+	FBulletBodyHandle Body;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Activation")
+	EBulletActivationEventType Type = EBulletActivationEventType::Woke;
+};
@@ -0,0 +1,46 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletBodyHandle.generated.h"
+
+/**
+ * Stable reference to a rigid body registered with the bullet world subsystem.
+ * Body slots are recycled, so the generation is bumped every time a slot is freed and stale handles simply stop resolving.
+ */
+USTRUCT(BlueprintType)
+struct FBulletBodyHandle
+{
+	GENERATED_BODY()
+
+	FBulletBodyHandle() = default;
+
+	FBulletBodyHandle(int32 InIndex, int32 InGeneration)
+		: Index(InIndex)
+		, Generation(InGeneration)
+	{
+	}
+
+	// Slot of the body in the subsystem's pool
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Objects")
+	int32 Index = INDEX_NONE;
+
+	// Generation of the slot when the body was registered
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Objects")
+	int32 Generation = 0;
+
+	bool IsSet() const { return Index != INDEX_NONE; }
+
+	void Reset() { *this = FBulletBodyHandle(); }
+
+	bool operator==(const FBulletBodyHandle& Other) const
+	{
+		return Index == Other.Index && Generation == Other.Generation;
+	}
+
+	friend uint32 GetTypeHash(const FBulletBodyHandle& Handle)
+	{
+		return HashCombineFast(GetTypeHash(Handle.Index), GetTypeHash(Handle.Generation));
+	}
+};
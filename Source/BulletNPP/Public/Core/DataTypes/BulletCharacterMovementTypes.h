@@ -0,0 +1,94 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletCharacterMovementTypes.generated.h"
+
+/** Tuning for the built-in walking and falling modes. Distances are in UE units */
+USTRUCT(BlueprintType)
+struct FBulletCharacterMovementSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0))
+	float MaxSpeed = 600.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0))
+	float Acceleration = 4000.f;
+
+	// How quickly the character comes to a stop on the ground with no move input
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0))
+	float Deceleration = 4000.f;
+
+	// Fraction of Acceleration available while falling
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0, ClampMax = 1))
+	float AirControlPercentage = 0.4f;
+
+	// Yaw turned per second towards the orientation intent
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0))
+	float TurningRate = 500.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0))
+	float JumpUpwardsSpeed = 500.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character")
+	float GravityZ = -980.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0))
+	float TerminalVelocity = 4000.f;
+
+	// Tallest ledge the character walks up onto, and furthest drop it stays stuck to the ground over
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0))
+	float MaxStepHeight = 45.f;
+
+	// Steepest slope, in degrees, that still counts as floor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0, ClampMax = 90))
+	float MaxWalkSlopeAngle = 44.765f;
+
+	// Gap kept between the capsule and whatever it touches, so the next sweep doesn't start inside it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 0.01))
+	float SkinWidth = 0.5f;
+
+	// Sweeps a single move may take to slide around or step over what it runs into
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 1, ClampMax = 8))
+	int32 MaxMoveIterations = 4;
+
+	// Capsule used when the updated component isn't a capsule component
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 1))
+	float CapsuleRadius = 34.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Character", meta = (ClampMin = 1))
+	float CapsuleHalfHeight = 88.f;
+
+	float GetWalkableFloorZ() const { return FMath::Cos(FMath::DegreesToRadians(MaxWalkSlopeAngle)); }
+};
+
+/** What a downward capsule sweep found under the character. Cached in the sim blackboard under BulletCommonBlackboard::LastFloorResult */
+USTRUCT(BlueprintType)
+struct FBulletFloorCheckResult
+{
+	GENERATED_BODY()
+
+	// The capsule hit something within the sweep
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Character")
+	bool bBlockingHit = false;
+
+	// What was hit is flat enough to stand on
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Character")
+	bool bWalkableFloor = false;
+
+	// How far the capsule could drop before touching the floor
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Character")
+	float FloorDist = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Character")
+	FVector ImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Character")
+	FVector ImpactNormal = FVector::ZeroVector;
+
+	// Capsule centre the check was made from. A cached result is only reused from the exact same spot
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Character")
+	FVector Location = FVector::ZeroVector;
+};
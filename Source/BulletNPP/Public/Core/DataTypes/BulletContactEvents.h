@@ -0,0 +1,77 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/DataTypes/BulletBodyHandle.h"
+#include "BulletContactEvents.generated.h"
+
+/** Which contact events a rigid body wants. A pair is reported when either of its bodies asks for the event */
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EBulletContactReportFlags : uint8
+{
+	None = 0 UMETA(Hidden),
+
+	// The pair started touching this step
+	Begin = 1 << 0,
+
+	// The pair was already touching and still is. Not sent while both bodies are asleep
+	Persist = 1 << 1,
+
+	// The pair stopped touching, or one of its bodies was unregistered
+	End = 1 << 2,
+};
+ENUM_CLASS_FLAGS(EBulletContactReportFlags);
+
+UENUM(BlueprintType)
+enum class EBulletContactEventType : uint8
+{
+	Begin,
+	Persist,
+	End,
+};
+
+/**
+ * Two bullet objects touching over a world step. Compound shapes can touch through several manifolds, they are merged into one event per pair.
+ * Point and Normal are from the deepest contact of the step's last sub step, the impulse is summed over every contact and sub step.
+ */
+USTRUCT(BlueprintType)
+struct FBulletContactEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	EBulletContactEventType Type = EBulletContactEventType::Begin;
+
+	// Only set for registered rigid bodies, static geometry leaves them unset
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	FBulletBodyHandle BodyA;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	FBulletBodyHandle BodyB;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	TObjectPtr<AActor> ActorA = nullptr;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	TObjectPtr<AActor> ActorB = nullptr;
+
+	// Halfway between the two surfaces, in UE space
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	FVector Point = FVector::ZeroVector;
+
+	// On B, pointing towards A
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	FVector Normal = FVector::ZeroVector;
+
+	// Along the normal, kg cm/s. Always 0 for End events
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	float NormalImpulse = 0.f;
+
+	// Friction and restitution of the two materials, combined the way the solver used them
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	float Friction = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	float Restitution = 0.f;
+};
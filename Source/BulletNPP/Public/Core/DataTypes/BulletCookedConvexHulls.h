@@ -0,0 +1,76 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "BulletCookedConvexHulls.generated.h"
+
+class btConvexHullShape;
+class UStaticMesh;
+
+/** One convex piece of a decomposed mesh, with the faces bullet's polyhedral clipping works from already worked out */
+USTRUCT()
+struct FBulletCookedHull
+{
+	GENERATED_BODY()
+
+	// Hull vertices in bullet units, relative to the mesh
+	UPROPERTY()
+	TArray<FVector3f> Vertices;
+
+	// Vertex indices of every face, back to back. FaceSizes says how many belong to each face
+	UPROPERTY()
+	TArray<int32> FaceIndices;
+
+	UPROPERTY()
+	TArray<int32> FaceSizes;
+
+	// Outward normal and plane constant of every face, unscaled
+	UPROPERTY()
+	TArray<FVector4f> FacePlanes;
+};
+
+/**
+ * Convex decomposition of a static mesh for dynamic bodies, cooked in the editor with bullet's bundled VHACD.
+ * Add it to a static mesh's Asset User Data. Every save decomposes the mesh's collision triangles, cuts each hull down
+ * to MaxHullVertices and works out its faces, so spawning a body only copies the results into bullet.
+ * Dynamic bodies use the hulls in place of the mesh's simple collision.
+ */
+UCLASS(MinimalAPI, meta = (DisplayName = "Bullet Convex Decomposition"))
+class UBulletCookedConvexHulls : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	// Voxels VHACD splits the mesh into, more keeps thinner features but cooks slower
+	UPROPERTY(EditAnywhere, Category = "Bullet Physics|Decomposition", meta = (ClampMin = 10000, ClampMax = 16000000))
+	int32 Resolution = 100000;
+
+	// How far a hull may stray from the mesh, relative to the mesh's size. Lower gives more hulls
+	UPROPERTY(EditAnywhere, Category = "Bullet Physics|Decomposition", meta = (ClampMin = 0, ClampMax = 1))
+	float Concavity = 0.0025f;
+
+	// Vertex budget of every hull. Fewer vertices means less for the narrowphase to clip against
+	UPROPERTY(EditAnywhere, Category = "Bullet Physics|Decomposition", meta = (ClampMin = 4, ClampMax = 256))
+	int32 MaxHullVertices = 24;
+
+	UPROPERTY(VisibleAnywhere, Category = "Bullet Physics|Decomposition")
+	TArray<FBulletCookedHull> Hulls;
+
+	// Hash of the triangles and settings Hulls were cooked from, saves re-running VHACD when neither changed
+	UPROPERTY()
+	uint32 SourceHash = 0;
+
+	bool IsCooked() const { return Hulls.Num() > 0; }
+
+	/** Builds a hull shape with its polyhedral features, the vertices and faces scaled by Scale */
+	BULLETNPP_API btConvexHullShape* CreateHullShape(int32 HullIndex, const FVector& Scale) const;
+
+#if WITH_EDITOR
+	/** Decomposes the collision triangles of Mesh, or empties this if it has none */
+	BULLETNPP_API void Cook(UStaticMesh* Mesh);
+
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+};
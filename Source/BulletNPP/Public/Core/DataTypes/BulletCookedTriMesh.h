@@ -0,0 +1,73 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "BulletCookedTriMesh.generated.h"
+
+class btTriangleIndexVertexArray;
+class btBvhTriangleMeshShape;
+class UStaticMesh;
+
+/** Bullet objects built on top of a cooked mesh. The vertices and indices stay in the asset, so it has to outlive them */
+struct BULLETNPP_API FBulletCookedTriMeshShape
+{
+	btTriangleIndexVertexArray* MeshInterface = nullptr;
+	btBvhTriangleMeshShape* Shape = nullptr;
+	// Aligned copy of the cooked bvh, the shape's btOptimizedBvh lives inside it. Null when the bvh had to be rebuilt
+	void* BvhBuffer = nullptr;
+
+	void Release();
+};
+
+/**
+ * Complex collision of a static mesh, cooked for bullet in the editor so that loading a level doesn't build any BVH.
+ * Add it to a static mesh's Asset User Data. Every save re-cooks the mesh's collision triangles into an indexed
+ * vertex array and a serialized quantized btOptimizedBvh, which ship with the mesh.
+ * Static bodies use it when the body setup asks for complex as simple, or has no simple collision at all.
+ */
+UCLASS(MinimalAPI, meta = (DisplayName = "Bullet Cooked Collision"))
+class UBulletCookedTriMesh : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	// Collision vertices in bullet units, relative to the mesh
+	UPROPERTY(VisibleAnywhere, Category = "Bullet Physics|Collision")
+	TArray<FVector3f> Vertices;
+
+	// Three per triangle
+	UPROPERTY()
+	TArray<int32> Indices;
+
+	// Bounds of Vertices, which the bvh is quantized against
+	UPROPERTY()
+	FVector3f AabbMin = FVector3f::ZeroVector;
+
+	UPROPERTY()
+	FVector3f AabbMax = FVector3f::ZeroVector;
+
+	// btOptimizedBvh as written by serializeInPlace. Its layout depends on bullet's precision, see BvhLayoutSize
+	UPROPERTY()
+	TArray<uint8> BvhData;
+
+	// sizeof(btQuantizedBvh) and btScalar of the build that cooked BvhData, a runtime that doesn't match rebuilds the bvh instead
+	UPROPERTY()
+	int32 BvhLayoutSize = 0;
+
+	UPROPERTY()
+	int32 BvhScalarSize = 0;
+
+	bool IsCooked() const { return Indices.Num() >= 3 && Vertices.Num() >= 3; }
+
+	/** Builds the unscaled shape for this mesh, sharing the asset's vertices and indices. Release the result once the shape is no longer used */
+	BULLETNPP_API FBulletCookedTriMeshShape CreateShape() const;
+
+#if WITH_EDITOR
+	/** Cooks the collision triangles of Mesh, or empties this if it has none */
+	BULLETNPP_API void Cook(UStaticMesh* Mesh);
+
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+#endif
+};
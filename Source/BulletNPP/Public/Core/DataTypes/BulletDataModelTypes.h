@@ -142,7 +142,8 @@ struct TStructOpsTypeTraits< FBulletDefaultInputs > : public TStructOpsTypeTrait
 
 
 
-// Data block containing basic sync state information
+// Data block containing basic sync state information.
+// Rigid bodies driven by UBulletLiaisonComponent publish where the world's step for a frame left them, once every sim has ticked that frame
 USTRUCT(BlueprintType)
 struct FBulletDefaultSyncState : public FBulletDataStructBase
 {
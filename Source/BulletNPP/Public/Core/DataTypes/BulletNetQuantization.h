@@ -0,0 +1,65 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletNetQuantization.generated.h"
+
+/**
+ * How finely FBulletDefaultSyncState goes over the network, set in the project's Bullet Physics settings.
+ * Server and clients have to agree on every value here, it isn't sent along with the state.
+ */
+USTRUCT(BlueprintType)
+struct FBulletSyncStateQuantization
+{
+	GENERATED_BODY()
+
+	// Location step (cm), also used for the captured movement base position
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Quantization", meta = (ClampMin = 0.001))
+	float LocationPrecision = 0.01f;
+
+	// Linear velocity step (cm/s)
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Quantization", meta = (ClampMin = 0.001))
+	float VelocityPrecision = 0.1f;
+
+	// Angular velocity step (deg/s)
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Quantization", meta = (ClampMin = 0.001))
+	float AngularVelocityPrecision = 0.1f;
+
+	// Bits for each of the three smallest quaternion components of the orientation and movement base rotation, plus 2 for which one was dropped
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Quantization", meta = (ClampMin = 6, ClampMax = 30))
+	int32 OrientationBits = 15;
+
+	// How far (cm) a client may be from the server before it reconciles. Never goes below the error LocationPrecision can cause on its own
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Reconciliation", meta = (ClampMin = 0))
+	float LocationTolerance = 5.f;
+
+	// How far (degrees) a client's orientation may be from the server's before it reconciles, 0 never reconciles on orientation.
+	// Never goes below the error OrientationBits can cause on its own
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Reconciliation", meta = (ClampMin = 0))
+	float OrientationTolerance = 0.f;
+
+	/** Location tolerance actually used, LocationTolerance raised to cover rounding */
+	BULLETNPP_API double GetLocationTolerance() const;
+
+	/** Orientation tolerance actually used (degrees), OrientationTolerance raised to cover rounding. 0 when orientation isn't compared */
+	BULLETNPP_API double GetOrientationTolerance() const;
+};
+
+namespace BulletNetQuantization
+{
+	/**
+	 * Sends every component as a whole number of Precision steps, all with the bit count of the largest one after a 6 bit header.
+	 * Small values only pay for the bits they need and a vector that rounds to zero is just the header, so resting bodies cost next to nothing.
+	 */
+	BULLETNPP_API void SerializeVector(FArchive& Ar, FVector& Value, double Precision);
+
+	/** Smallest three: which component is largest in 2 bits, then the other three in BitsPerComponent bits each. The largest is rebuilt from the unit length */
+	BULLETNPP_API void SerializeQuat(FArchive& Ar, FQuat& Value, int32 BitsPerComponent);
+
+	/** Worst case distance between a vector and what arrives after SerializeVector */
+	BULLETNPP_API double GetMaxVectorError(double Precision);
+
+	/** Worst case angle (degrees) between a rotation and what arrives after SerializeQuat */
+	BULLETNPP_API double GetMaxQuatError(int32 BitsPerComponent);
+}
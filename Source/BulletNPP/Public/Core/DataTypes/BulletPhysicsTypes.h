@@ -165,18 +165,44 @@ struct TStructOpsTypeTraits< FBulletDataStructBase > : public TStructOpsTypeTrai
 
 
 
+namespace BulletPhysicsEngine
+{
+	// Where one struct of a data collection lives in its storage. DataType caches GetDataScriptStruct so lookups don't need a virtual call
+	struct FDataCollectionEntry
+	{
+		const UScriptStruct* Type = nullptr;
+		const UScriptStruct* DataType = nullptr;
+		int32 Offset = 0;
+		int32 Size = 0;
+	};
+
+	// Data collection storage is handed out in these so every struct in it can be 16 byte aligned
+	struct alignas(16) FDataCollectionBlock
+	{
+		uint8 Bytes[16];
+	};
+}
+
+class FBulletDataCollectionConstIterator;
 
 // Contains a group of different FBulletDataStructBase-derived data, and supports net serialization of them. Note that
 //	each contained data must have a unique type.  This is to support dynamic composition of Bullet simulation model
 //  definitions (input cmd, sync state, aux state).
+//  The structs are stored back to back in one buffer, which small collections keep inline, so copying a collection over
+//  one holding the same types copies each struct in place without allocating. Adding or removing data can move the
+//  structs already in it, so don't hold on to pointers across either.
 USTRUCT(BlueprintType)
 struct FBulletDataCollection
 {
 	GENERATED_BODY()
 
 	UE_API FBulletDataCollection();
+	UE_API FBulletDataCollection(const FBulletDataCollection& Other);
+	UE_API FBulletDataCollection(FBulletDataCollection&& Other);
+	UE_API ~FBulletDataCollection();
 
-	void Empty() { DataArray.Empty(); }
+	/** Removes all data. The storage is kept for whatever is added next */
+	UE_API void Empty();
 
 	/** Serialize all data in this collection */
 	UE_API bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
@@ -189,6 +215,8 @@ struct FBulletDataCollection
 	/** Copy operator - deep copy so it can be used for archiving/saving off data */
 	UE_API FBulletDataCollection& operator=(const FBulletDataCollection& Other);
 
+	UE_API FBulletDataCollection& operator=(FBulletDataCollection&& Other);
+
 	/** Comparison operator (deep) - needs matching struct types along with identical states in those structs. See also ShouldReconcile */
 	UE_API bool operator==(const FBulletDataCollection& Other) const;
 
@@ -217,7 +245,16 @@ struct FBulletDataCollection
 	UE_API void ToString(FAnsiStringBuilderBase& Out) const;
 
 	/** Const access to data array of collections */
-	UE_API TArray<TSharedPtr<FBulletDataStructBase>>::TConstIterator GetCollectionDataIterator() const;
+	UE_API FBulletDataCollectionConstIterator GetCollectionDataIterator() const;
+
+	/** Number of data structs in this collection */
+	int32 Num() const { return Entries.Num(); }
+
+	/** Data struct at Index, in the order they were added */
+	FBulletDataStructBase* GetDataAt(int32 Index) const
+	{
+		return reinterpret_cast<FBulletDataStructBase*>(GetEntryMemory(Index));
+	}
 	
 	/** Find data of a specific type in the collection (mutable version). If not found, null will be returned. */
 	template <typename T>
@@ -281,19 +318,17 @@ struct FBulletDataCollection
 		return *(static_cast<T*>(AddDataByType(T::StaticStruct())));
 	}
 
-	/** Adds this data instance to the collection, taking ownership of it. If an existing data struct of the same type is already there, it will be removed first. */
+	/** Adds a copy of this data instance to the collection. If an existing data struct of the same type is already there, it will be removed first. */
 	UE_API void AddOrOverwriteData(const TSharedPtr<FBulletDataStructBase> DataInstance);
 
-	/** Adds data to the collection by copying over an existing struct or cloning the provided struct if no matching struct exists. 
+	/** Adds data to the collection by copying over an existing struct, or into a new one if no matching struct exists. 
 	 *  This is different than AddOrOverwriteData because the instance isn't touched, avoiding memory allocation & array changing if a matching struct exists.
 	 */
 	UE_API void AddDataByCopy(const FBulletDataStructBase* DataInstanceToCopy);
 
 
-	const TArray< TSharedPtr<FBulletDataStructBase> >& GetDataArray() const
-	{
-		return DataArray;
-	}
+	/** Pointers to every data struct, valid until data is added or removed */
+	UE_API TArray<FBulletDataStructBase*, TInlineAllocator<4>> GetDataArray() const;
 
 	/** Find data of a specific type in the collection. */
 	UE_API FBulletDataStructBase* FindDataByType(const UScriptStruct* DataStructType) const;
@@ -306,26 +341,76 @@ struct FBulletDataCollection
 
 protected:
 	UE_API FBulletDataStructBase* AddDataByType(const UScriptStruct* DataStructType);
-	static UE_API TSharedPtr<FBulletDataStructBase> CreateDataByType(const UScriptStruct* DataStructType);
-	
+
+	/** Default constructs a struct of exactly this type at the end of the storage */
+	UE_API FBulletDataStructBase* EmplaceData(const UScriptStruct* ScriptStruct);
+
+	/** Destroys the data from FirstIndex on */
+	UE_API void DestroyData(int32 FirstIndex);
+
+	/** Index of the data of a specific type, or INDEX_NONE */
+	UE_API int32 FindDataIndexByType(const UScriptStruct* DataStructType) const;
+
 	/** Helper function for serializing array of data */
-	static UE_API void NetSerializeDataArray(FArchive& Ar, UPackageMap* Map, TArray<TSharedPtr<FBulletDataStructBase>>& DataArray);
+	UE_API void NetSerializeDataArray(FArchive& Ar, UPackageMap* Map);
+
+	uint8* GetEntryMemory(int32 Index) const
+	{
+		return const_cast<uint8*>(reinterpret_cast<const uint8*>(Storage.GetData())) + Entries[Index].Offset;
+	}
+
+	int32 GetUsedBytes() const
+	{
+		return Entries.Num() > 0 ? Entries.Last().Offset + Entries.Last().Size : 0;
+	}
+
+	// Room for the default sync state or inputs on their own without going to the heap
+	static constexpr int32 InlineStorageBytes = 256;
+
+	/** Type and place of every data struct, in the order they were added */
+	TArray<BulletPhysicsEngine::FDataCollectionEntry, TInlineAllocator<4>> Entries;
 
 	/** All data in this collection */
-	TArray< TSharedPtr<FBulletDataStructBase> > DataArray;
+	TArray<BulletPhysicsEngine::FDataCollectionBlock, TInlineAllocator<InlineStorageBytes / sizeof(BulletPhysicsEngine::FDataCollectionBlock)>> Storage;
 
 
 friend class UBulletDataCollectionLibrary;
 friend class UBulletComponent;
 };
 
+/** Walks the data in a collection, in the order it was added */
+class FBulletDataCollectionConstIterator
+{
+public:
+	explicit FBulletDataCollectionConstIterator(const FBulletDataCollection& InCollection)
+		: Collection(InCollection)
+	{
+	}
+
+	FBulletDataCollectionConstIterator& operator++()
+	{
+		++Index;
+		return *this;
+	}
+
+	FBulletDataStructBase* operator*() const { return Collection.GetDataAt(Index); }
+
+	explicit operator bool() const { return Index < Collection.Num(); }
+
+	int32 GetIndex() const { return Index; }
+
+private:
+	const FBulletDataCollection& Collection;
+	int32 Index = 0;
+};
+
 
 template<>
 struct TStructOpsTypeTraits<FBulletDataCollection> : public TStructOpsTypeTraitsBase2<FBulletDataCollection>
 {
 	enum
 	{
-		WithCopy = true,		// Necessary so that DataArray is copied around
+		WithCopy = true,		// Necessary so that the data in Storage is copied around
 		WithNetSerializer = true,
 		WithIdenticalViaEquality = true,
 		WithAddStructReferencedObjects = true,
@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/DataTypes/BulletBodyHandle.h"
+#include "BulletSceneQueryTypes.generated.h"
+
+class btCollisionObject;
+
+/** A single ray in a batched raycast, in UE space */
+USTRUCT(BlueprintType)
+struct FBulletRaycast
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	FVector Start = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	FVector End = FVector::ZeroVector;
+
+	// Bodies and static collision of these actors are passed through
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	TArray<TObjectPtr<AActor>> IgnoreActors;
+
+	// Object channels that can be hit, as ECC_TO_BITFIELD bits of each object's owner root component type. 0 hits every channel
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries", meta = (Bitmask, BitmaskEnum = "/Script/Engine.ECollisionChannel"))
+	int32 ObjectChannelMask = 0;
+};
+
+/** A sphere swept from Start to End in a batched sweep, in UE space */
+USTRUCT(BlueprintType)
+struct FBulletSphereSweep
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	FVector Start = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	FVector End = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries", meta = (ClampMin = 0))
+	float Radius = 10.f;
+
+	// Bodies and static collision of these actors are passed through
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	TArray<TObjectPtr<AActor>> IgnoreActors;
+
+	// Object channels that can be hit, as ECC_TO_BITFIELD bits of each object's owner root component type. 0 hits every channel
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries", meta = (Bitmask, BitmaskEnum = "/Script/Engine.ECollisionChannel"))
+	int32 ObjectChannelMask = 0;
+};
+
+/** A sphere tested for overlaps in a batched overlap query, in UE space */
+USTRUCT(BlueprintType)
+struct FBulletSphereOverlap
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	FVector Center = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries", meta = (ClampMin = 0))
+	float Radius = 10.f;
+
+	// Bodies and static collision of these actors are passed through
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries")
+	TArray<TObjectPtr<AActor>> IgnoreActors;
+
+	// Object channels that can overlap, as ECC_TO_BITFIELD bits of each object's owner root component type. 0 overlaps every channel
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bullet Physics|Queries", meta = (Bitmask, BitmaskEnum = "/Script/Engine.ECollisionChannel"))
+	int32 ObjectChannelMask = 0;
+};
+
+/** Closest hit of a single ray or sweep. There is one per query, in the same order as the queries */
+USTRUCT(BlueprintType)
+struct FBulletQueryHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	bool bHit = false;
+
+	// How far along the query the hit is, 0 at Start and 1 at End
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	float Time = 1.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	FVector Normal = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	TObjectPtr<AActor> Actor = nullptr;
+
+	// Only set when a registered rigid body was hit, static geometry leaves it unset
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	FBulletBodyHandle Body;
+
+	const btCollisionObject* HitObject = nullptr;
+};
+
+/** Something a sphere overlap query touched. Overlaps are variable in number so each one carries the index of its query */
+USTRUCT(BlueprintType)
+struct FBulletOverlapResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	int32 QueryIndex = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	TObjectPtr<AActor> Actor = nullptr;
+
+	// Only set when a registered rigid body overlapped, static geometry leaves it unset
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Queries")
+	FBulletBodyHandle Body;
+
+	const btCollisionObject* HitObject = nullptr;
+};
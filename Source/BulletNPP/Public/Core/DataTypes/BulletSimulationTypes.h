@@ -13,6 +13,7 @@
 // TODO:@GreggoryAddison::CodeCompletion | Add FMovementModifiers & Potentially add FLayeredMoveInstance for BP support (yuck)
 
 class UBulletBlackboard;
+class UBulletPhysicsWorldSubsystem;
 
 // Names for our default modes
 namespace BulletDefaultModeNames
@@ -136,6 +137,16 @@ public:
 
 	UPROPERTY(BlueprintReadWrite, Category = Bullet)
 	FBulletDataCollection DataCollection;
+	
+	// Hash of the whole bullet world at the start of WorldHashFrame, as the authority numbers it. Only set by the authority, in every sim's state on
+	// the frames the subsystem samples, see StateHashReplicationInterval
+	int32 WorldHashFrame = INDEX_NONE;
+	uint32 WorldHash = 0;
+	
+	// The local world, and the frame of it this state starts, an authority hash is checked against. Never replicated, client frame numbers
+	// are offset from the authority's
+	TWeakObjectPtr<UBulletPhysicsWorldSubsystem> WorldHashSource;
+	int32 LocalWorldFrame = INDEX_NONE;
 
 	FBulletSyncState()
 	{
@@ -163,6 +174,19 @@ public:
 
 		bool bIgnoredResult(false);
 		DataCollection.NetSerialize(P.Ar, P.Map, bIgnoredResult);
+		
+		// A single bit on the frames that don't carry the world hash
+		uint8 bHasWorldHash = WorldHashFrame != INDEX_NONE;
+		P.Ar.SerializeBits(&bHasWorldHash, 1);
+		if (bHasWorldHash)
+		{
+			P.Ar << WorldHashFrame;
+			P.Ar << WorldHash;
+		}
+		else
+		{
+			WorldHashFrame = INDEX_NONE;
+		}
 	}
 
 	void ToString(FAnsiStringBuilderBase& Out) const
@@ -172,10 +196,20 @@ public:
 		//Out.Appendf("Layered Moves: %s\n", TCHAR_TO_ANSI(*LayeredMoveInstances.ToSimpleString()));
 		//Out.Appendf("Movement Modifiers: %s\n", TCHAR_TO_ANSI(*MovementModifiers.ToSimpleString()));
 		DataCollection.ToString(Out);
+		if (WorldHashFrame != INDEX_NONE)
+		{
+			Out.Appendf("World Hash: %08x (frame %d)\n", WorldHash, WorldHashFrame);
+		}
 	}
 
 	bool ShouldReconcile(const FBulletSyncState& AuthorityState) const
 	{
+		// Never a reason to correct on its own, it only tells bullet drift apart from the rest of the state
+		if (AuthorityState.WorldHashFrame != INDEX_NONE)
+		{
+			CheckWorldHash(AuthorityState);
+		}
+		
 		return (MovementMode != AuthorityState.MovementMode) || 
 			   DataCollection.ShouldReconcile(AuthorityState.DataCollection) /*||
 			   MovementModifiers.ShouldReconcile(AuthorityState.MovementModifiers)*/;
@@ -189,6 +223,10 @@ public:
 		//MovementModifiers = To->MovementModifiers;
 
 		DataCollection.Interpolate(From->DataCollection, To->DataCollection, Pct);
+		
+		WorldHashFrame = To->WorldHashFrame;
+		WorldHash = To->WorldHash;
+		LocalWorldFrame = To->LocalWorldFrame;
 	}
 
 	// Resets the sync state to its default configuration and removes any
@@ -198,9 +236,15 @@ public:
 		MovementMode = NAME_None;
 		DataCollection.Empty();
 		LayeredMoves.Reset();
+		WorldHashFrame = INDEX_NONE;
+		WorldHash = 0;
+		LocalWorldFrame = INDEX_NONE;
 		//LayeredMoveInstances.Reset();
 		//MovementModifiers.Reset();
 	}
+	
+private:
+	BULLETNPP_API void CheckWorldHash(const FBulletSyncState& AuthorityState) const;
 };
 
 /** 
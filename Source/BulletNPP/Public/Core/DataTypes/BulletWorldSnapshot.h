@@ -0,0 +1,103 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletMain.h"
+#include "Core/DataTypes/BulletBodyHandle.h"
+
+/**
+ * Everything we need to put a single rigid body back to where it was at the start of a NP frame.
+ * Kept as plain bullet value types so restoring a frame is a straight copy per body.
+ */
+struct FBulletBodySnapshot
+{
+	// Generation of the body's pool slot when captured, INDEX_NONE if the slot was free. A recycled slot won't match
+	int32 Generation = INDEX_NONE;
+	
+	btTransform WorldTransform;
+	btVector3 LinearVelocity;
+	btVector3 AngularVelocity;
+	btVector3 TotalForce;
+	btVector3 TotalTorque;
+	btScalar DeactivationTime = 0;
+	int32 ActivationState = 0;
+	
+	// Hash of the transform and velocities, 0 for free slots or when the subsystem doesn't hash its state
+	uint32 StateHash = 0;
+};
+
+/** Contact cache of a single overlapping pair, this is what carries the solver warm starting impulses from one frame to the next */
+struct FBulletManifoldSnapshot
+{
+	// Pair that was captured, see FBulletWorldSnapshot::PairObjects for how the objects are named
+	FBulletBodyHandle Body0;
+	FBulletBodyHandle Body1;
+	
+	// Range of the snapshot's ManifoldPoints holding this cache's contacts
+	int32 FirstPoint = 0;
+	int32 NumContacts = 0;
+};
+
+/** State of the whole bullet world at the start of a NP frame */
+struct FBulletWorldSnapshot
+{
+	// The NP frame this is the starting state of, INDEX_NONE if the slot hasn't been recorded yet
+	int32 Frame = INDEX_NONE;
+	
+	// The subsystem's world origin (UE space) when captured, transforms below are relative to it
+	FVector WorldOrigin = FVector::ZeroVector;
+	
+	// Indexed by the subsystem's rigid body pool slot
+	TArray<FBulletBodySnapshot> Bodies;
+	
+	// Only filled when the subsystem is set to capture contacts, or the world is deterministic
+	TArray<FBulletManifoldSnapshot> Manifolds;
+	// Contacts of all the manifolds back to back, most caches hold far fewer than MANIFOLD_CACHE_SIZE
+	TArray<btManifoldPoint> ManifoldPoints;
+	
+	// Step time the world had carried over to its next fixed step
+	btScalar LocalTime = 0;
+	
+	// Deterministic worlds only. Both objects of every overlapping pair back to back, in the world's pair order.
+	// Rigid bodies go by pool slot and generation, so a recycled slot doesn't pass for the body that was captured.
+	// Static objects are never removed and go by their index, with a generation of INDEX_NONE
+	TArray<FBulletBodyHandle> PairObjects;
+	
+	// Crc of the bodies' state hashes in network id order, so it doesn't depend on which slot each body ended up in but does on which body is where
+	uint32 StateHash = 0;
+};
+
+/** A body's state at the start of a frame in UE space, so captures of different worlds can be compared directly */
+struct FBulletBodyStateRecord
+{
+	// Name of the owning actor
+	FString Owner;
+	// The body's network stable id, which is what bodies of different worlds are matched up by
+	uint32 NetworkKey = 0;
+	int32 Slot = INDEX_NONE;
+	uint32 StateHash = 0;
+	
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	// cm/s
+	FVector LinearVelocity = FVector::ZeroVector;
+	// deg/s
+	FVector AngularVelocity = FVector::ZeroVector;
+};
+
+/** The world on the first frame its state hash disagreed with the authority's */
+struct FBulletDesyncCapture
+{
+	int32 Frame = INDEX_NONE;
+	// The same frame as the authority numbers it
+	int32 AuthorityFrame = INDEX_NONE;
+	uint32 LocalHash = 0;
+	uint32 AuthorityHash = 0;
+	
+	TArray<FBulletBodyStateRecord> LocalBodies;
+	
+	// Only filled when the authority's world lives in the same process (PIE)
+	TArray<FBulletBodyStateRecord> AuthorityBodies;
+	bool bHasAuthorityBodies = false;
+};
@@ -0,0 +1,66 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletMain.h"
+#include "Core/DataTypes/BulletCharacterMovementTypes.h"
+
+/** Where a character is and what it is doing, the part of its sync state the built-in modes evolve. UE space, Location is the capsule centre */
+struct FBulletCharacterState
+{
+	FName Mode = NAME_None;
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	FBulletFloorCheckResult Floor;
+};
+
+/**
+ * Walking and falling for a kinematic capsule, moved entirely with bullet convex sweeps against a bullet world.
+ * Same idea as btKinematicCharacterController (step up, move, step down) without the ghost object or any state of its own,
+ * so a tick only depends on what it is given and the world it sweeps. That keeps it deterministic and safe to resimulate.
+ * The character has no body in the world, so nothing needs filtering out of the sweeps.
+ */
+class BULLETNPP_API FBulletCharacterMovement
+{
+public:
+	FBulletCharacterMovement(const btCollisionWorld* InWorld, const FVector& InWorldOrigin, const FBulletCharacterMovementSettings& InSettings, float InRadius, float InHalfHeight);
+
+	/** Advances State by DeltaSeconds. MoveIntent is a world space direction scaled [0, 1] by how fast to go. Modes other than walking and falling are left alone */
+	void Tick(FBulletCharacterState& State, const FVector& MoveIntent, bool bJumpPressed, float DeltaSeconds) const;
+
+	/** Sweeps the capsule down from Location looking for something to stand on, as far as MaxStepHeight below it */
+	FBulletFloorCheckResult FindFloor(const FVector& Location) const;
+
+	/** Closest hit of the capsule swept between two centres. Surfaces the sweep is moving away from don't block it */
+	bool SweepCapsule(const FVector& Start, const FVector& End, float& OutTime, FVector& OutImpactPoint, FVector& OutNormal) const;
+
+private:
+	// Both return the time left over when the mode changed part way through
+	float TickWalking(FBulletCharacterState& State, const FVector& MoveIntent, bool bJumpPressed, float DeltaSeconds) const;
+	float TickFalling(FBulletCharacterState& State, const FVector& MoveIntent, float DeltaSeconds) const;
+
+	// Moves along the ground, walking up ramps and stepping over anything low enough
+	void MoveAlongFloor(FBulletCharacterState& State, FVector Delta) const;
+
+	// Up by MaxStepHeight, along Delta and back down onto walkable floor. Leaves State alone and returns false when there's nowhere to land
+	bool StepUp(FBulletCharacterState& State, const FVector& Delta) const;
+
+	FBulletFloorCheckResult FindFloor(const FVector& Location, float Distance) const;
+
+	// Drops Location onto Floor, leaving SkinWidth between them
+	void SnapToFloor(FVector& Location, FBulletFloorCheckResult& Floor) const;
+
+	// Moves Location towards Location + Delta, stopping SkinWidth short of a hit. Returns whether something was hit
+	bool SafeMove(FVector& Location, const FVector& Delta, float& OutTime, FVector& OutImpactPoint, FVector& OutNormal) const;
+
+	bool IsWalkable(const FVector& Normal) const { return Normal.Z >= WalkableFloorZ; }
+
+	const btCollisionWorld* World;
+	FVector WorldOrigin;
+	FBulletCharacterMovementSettings Settings;
+	float Radius;
+	float HalfHeight;
+	float WalkableFloorZ;
+	btCapsuleShapeZ Capsule;
+};
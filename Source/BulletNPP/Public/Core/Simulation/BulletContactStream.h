@@ -0,0 +1,118 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletMain.h"
+#include "Core/DataTypes/BulletContactEvents.h"
+
+/**
+ * Contact events of a bullet world, one compact array per step, built from its manifolds instead of bullet's process wide contact callbacks.
+ * After every sub step each manifold is summarised into its own slot of a scratch array, spread over the task scheduler, so the workers never share anything they write.
+ * The summaries are then merged per pair in manifold order, so the events come out the same whatever the thread count.
+ * A body's report flags are kept in the low byte of its third user index, which lets the parallel pass skip unreported pairs without looking anything up.
+ */
+class BULLETNPP_API FBulletContactStream
+{
+public:
+	// Fills in the actor and body handle of a bullet object
+	using FResolveObject = TFunctionRef<void(const btCollisionObject*, TObjectPtr<AActor>&, FBulletBodyHandle&)>;
+
+	// Manifolds summarised per scheduler task
+	static constexpr int32 ManifoldsPerTask = 64;
+
+	/** Gathers World's contacts after every one of its sub steps, through its internal tick callback. Detach before either goes away */
+	void Attach(btDynamicsWorld* World);
+
+	void Detach(btDynamicsWorld* World);
+
+	void SetReportFlags(btCollisionObject* Object, EBulletContactReportFlags Flags);
+
+	static EBulletContactReportFlags GetReportFlags(const btCollisionObject* Object);
+
+	/** Turns everything gathered since the last call into this step's events, against the pairs that were touching after the previous one */
+	void FinishStep(const FVector& WorldOrigin, FResolveObject ResolveObject);
+
+	/** Ends every pair Object is part of with the next step. Call before it's removed from the world */
+	void RemoveObject(const btCollisionObject* Object);
+
+	/**
+	 * Takes the pairs touching in the world right now as the ones the next step is compared against, without sending anything.
+	 * For after the world has been rewound, resimulated steps then report their contacts again.
+	 */
+	void ResetToWorld(btDispatcher* Dispatcher, const FVector& WorldOrigin, FResolveObject ResolveObject);
+
+	/** Events of the last finished step, valid until the next one */
+	const TArray<FBulletContactEvent>& GetEvents() const { return Events; }
+
+	void Reset();
+
+private:
+	// One manifold's contacts over a sub step, in bullet space. Flags are None when the manifold isn't reported
+	struct FManifoldSummary
+	{
+		const btCollisionObject* ObjectA;
+		const btCollisionObject* ObjectB;
+		btVector3 Point;
+		btVector3 Normal;
+		btScalar Distance;
+		btScalar Impulse;
+		btScalar Friction;
+		btScalar Restitution;
+		EBulletContactReportFlags Flags;
+		bool bAwake;
+	};
+
+	// Objects in pointer order, manifolds don't keep the same order when a pair separates and touches again
+	using FPairKey = TTuple<const btCollisionObject*, const btCollisionObject*>;
+
+	static FPairKey MakePairKey(const btCollisionObject* ObjectA, const btCollisionObject* ObjectB)
+	{
+		return ObjectA < ObjectB ? MakeTuple(ObjectA, ObjectB) : MakeTuple(ObjectB, ObjectA);
+	}
+
+	// A reported pair touching during the current step, geometry from the deepest contact of the latest sub step and the impulse summed over all of them
+	struct FStepPair
+	{
+		FManifoldSummary Summary;
+		btScalar Impulse;
+		int32 SubStep;
+	};
+
+	// A reported pair that was touching after the last finished step, with the event it last sent so it can be ended without touching bullet
+	struct FTouchingPair
+	{
+		FBulletContactEvent Event;
+		const btCollisionObject* ObjectA = nullptr;
+		EBulletContactReportFlags Flags = EBulletContactReportFlags::None;
+		uint32 LastStep = 0;
+	};
+
+	// The parallel pass, writes the summary of manifold i to ManifoldSummaries[i]
+	struct FSummariseManifolds;
+
+	static void OnInternalTick(btDynamicsWorld* World, btScalar TimeStep);
+
+	/** Summarises the contacts of the sub step that just finished and merges them into StepPairs */
+	void GatherSubStep(btDispatcher* Dispatcher);
+
+	// Moves StepPairs into TouchingPairs, adding this step's events if bSendEvents
+	void UpdateTouchingPairs(const FVector& WorldOrigin, FResolveObject ResolveObject, bool bSendEvents);
+
+	TArray<FManifoldSummary> ManifoldSummaries;
+
+	TArray<FStepPair> StepPairs;
+	TMap<FPairKey, int32> StepPairIndices;
+	int32 NumSubSteps = 0;
+
+	TMap<FPairKey, FTouchingPair> TouchingPairs;
+	uint32 NumSteps = 0;
+
+	// End events of pairs whose objects were removed between steps
+	TArray<FBulletContactEvent> RemovedPairEvents;
+
+	TArray<FBulletContactEvent> Events;
+
+	// Objects with any report flags, nothing is gathered while there are none
+	int32 NumReportingObjects = 0;
+};
@@ -0,0 +1,680 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletMain.h"
+#include <atomic>
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "LinearMath/btPoolAllocator.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+
+/**
+ * Tunables bullet keeps in process wide globals, held per world instead so worlds can be tuned apart and stepped at the same time,
+ * along with the world's own settings. Values are in bullet units.
+ */
+struct FBulletWorldTunables
+{
+	// Contacts that drift further apart than this are dropped from their manifold, and aabbs are padded by it. Replaces gContactBreakingThreshold
+	btScalar ContactBreakingThreshold = btScalar(0.02);
+
+	// Resting time before a body without its own deactivation time goes to sleep. Replaces gDeactivationTime
+	btScalar DeactivationTime = btScalar(2.);
+
+	// Nothing in the world ever goes to sleep. Replaces gDisableDeactivation
+	bool bDisableDeactivation = false;
+
+	// Exact broadphase bounds, and pairs, manifolds and solver in a fixed order every step, so stepping the same state gives the same result
+	// however the world got there. See TBulletDynamicsWorld::RestoreCollisionPairs for putting a rewound world's pairs back
+	bool bDeterministic = false;
+};
+
+
+/**
+ * The bullet world the subsystem builds, on top of either the single or multithreaded discrete world.
+ * Bodies carry their own deactivation time (in ms) in their second user index. A negative value falls back to the world's.
+ * None of the overrides here read or write bullet's tunable globals or touch the quickprof frame counters, so separate worlds can step concurrently.
+ */
+template <typename BaseWorldType>
+class TBulletDynamicsWorld : public BaseWorldType
+{
+public:
+	using BaseWorldType::BaseWorldType;
+
+	FBulletWorldTunables Tunables;
+
+	static void SetBodyDeactivationTime(btRigidBody* Body, btScalar Seconds)
+	{
+		Body->setUserIndex2(Seconds >= 0 ? (int)(Seconds * 1000 + btScalar(0.5)) : -1);
+	}
+
+	// Id of the object's broadphase proxy. Handed out in the order objects are added and kept for as long as they stay in the world
+	static int GetStableId(const btCollisionObject* Obj)
+	{
+		return Obj->getBroadphaseHandle() ? Obj->getBroadphaseHandle()->m_uniqueId : -1;
+	}
+
+	/** Step time carried over to the next fixed step, as much part of the world's state as the bodies when rewinding it */
+	btScalar GetLocalTime() const { return this->m_localTime; }
+	void SetLocalTime(btScalar LocalTime) { this->m_localTime = LocalTime; }
+
+	/**
+	 * Deterministic worlds only. Puts back the overlapping pairs a snapshot recorded, once its bodies have been restored, so the resim starts
+	 * from the pairs the first run had rather than the ones the world has now. PairObjects holds both objects of every pair back to back,
+	 * all of them in the world. Pairs with a null object, one that has since left the world, are skipped. Every pair is rebuilt and given fresh algorithms and manifolds by one
+	 * narrowphase pass, ready for the snapshot's contacts to be copied in. Must not be called during a step.
+	 */
+	void RestoreCollisionPairs(btCollisionObject* const* PairObjects, int NumPairs)
+	{
+		BT_PROFILE("restoreCollisionPairs");
+
+		// The bounds a step would have left the restored bodies with
+		this->updateAabbs();
+
+		btOverlappingPairCache* PairCache = this->getPairCache();
+		btDispatcher* Dispatcher = this->getDispatcher();
+		btBroadphasePairArray& Pairs = PairCache->getOverlappingPairArray();
+		while (Pairs.size() > 0)
+		{
+			const btBroadphasePair& Pair = Pairs[Pairs.size() - 1];
+			PairCache->removeOverlappingPair(Pair.m_pProxy0, Pair.m_pProxy1, Dispatcher);
+		}
+
+		for (int i = 0; i < NumPairs; i++)
+		{
+			btCollisionObject* Obj0 = PairObjects[i * 2];
+			btCollisionObject* Obj1 = PairObjects[i * 2 + 1];
+			if (!Obj0 || !Obj1) continue;
+
+			PairCache->addOverlappingPair(Obj0->getBroadphaseHandle(), Obj1->getBroadphaseHandle());
+		}
+
+		btCollisionObjectArray& Objects = this->getCollisionObjectArray();
+		SortOverlappingPairs();
+
+		// The first run kept the algorithms and contacts of pairs that fell asleep, so sleeping objects count as awake for this one pass
+		SleepingObjects.resize(0);
+		for (int i = 0; i < Objects.size(); i++)
+		{
+			if (Objects[i]->getActivationState() == ISLAND_SLEEPING)
+			{
+				SleepingObjects.push_back(Objects[i]);
+				Objects[i]->setActivationState(ACTIVE_TAG);
+			}
+		}
+		Dispatcher->dispatchAllCollisionPairs(PairCache, this->getDispatchInfo(), Dispatcher);
+		for (int i = 0; i < SleepingObjects.size(); i++)
+		{
+			SleepingObjects[i]->setActivationState(ISLAND_SLEEPING);
+		}
+		SortManifolds();
+	}
+
+	/**
+	 * Moves everything in the world by -Offset, so whatever was at Offset ends up at the origin.
+	 * Contact points move with the bodies so the manifolds stay valid, and every broadphase proxy is refreshed, sleeping and static ones included.
+	 * Must not be called during a step.
+	 */
+	void ShiftOrigin(const btVector3& Offset)
+	{
+		BT_PROFILE("shiftOrigin");
+
+		btCollisionObjectArray& Objects = this->getCollisionObjectArray();
+		for (int i = 0; i < Objects.size(); i++)
+		{
+			btCollisionObject* Obj = Objects[i];
+			Obj->getWorldTransform().getOrigin() -= Offset;
+
+			btTransform Interpolation = Obj->getInterpolationWorldTransform();
+			Interpolation.getOrigin() -= Offset;
+			Obj->setInterpolationWorldTransform(Interpolation);
+
+			UpdateSingleAabb(Obj);
+		}
+
+		btDispatcher* Dispatcher = this->getDispatcher();
+		for (int i = 0; i < Dispatcher->getNumManifolds(); i++)
+		{
+			btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+			for (int p = 0; p < Manifold->getNumContacts(); p++)
+			{
+				btManifoldPoint& Point = Manifold->getContactPoint(p);
+				Point.m_positionWorldOnA -= Offset;
+				Point.m_positionWorldOnB -= Offset;
+			}
+		}
+	}
+
+	/**
+	 * Same as btDiscreteDynamicsWorld::stepSimulation without its global side effects: the debug drawer's DBG_NoDeactivation only applies to this world
+	 * instead of being written to gDisableDeactivation, and the shared quickprof clock and frame counter are left alone.
+	 */
+	virtual int stepSimulation(btScalar TimeStep, int MaxSubSteps = 1, btScalar FixedTimeStep = btScalar(1.) / btScalar(60.)) override
+	{
+		int NumSimulationSubSteps = 0;
+
+		if (MaxSubSteps)
+		{
+			// Fixed time step with interpolation
+			this->m_fixedTimeStep = FixedTimeStep;
+			this->m_localTime += TimeStep;
+			if (this->m_localTime >= FixedTimeStep)
+			{
+				NumSimulationSubSteps = int(this->m_localTime / FixedTimeStep);
+				this->m_localTime -= NumSimulationSubSteps * FixedTimeStep;
+			}
+		}
+		else
+		{
+			// Variable time step
+			FixedTimeStep = TimeStep;
+			this->m_localTime = this->m_latencyMotionStateInterpolation ? 0 : TimeStep;
+			this->m_fixedTimeStep = 0;
+			if (btFuzzyZero(TimeStep))
+			{
+				NumSimulationSubSteps = 0;
+				MaxSubSteps = 0;
+			}
+			else
+			{
+				NumSimulationSubSteps = 1;
+				MaxSubSteps = 1;
+			}
+		}
+
+		if (Tunables.bDeterministic)
+		{
+			// Bullet only shuffles the solver's constraints, and the Mt solver's batch phases, when asked to. Its seed isn't rewound with the bodies
+			this->getSolverInfo().m_solverMode &= ~SOLVER_RANDMIZE_ORDER;
+		}
+
+		btIDebugDraw* DebugDrawer = this->getDebugDrawer();
+		bDebugDisableDeactivation = DebugDrawer && (DebugDrawer->getDebugMode() & btIDebugDraw::DBG_NoDeactivation) != 0;
+
+		if (NumSimulationSubSteps)
+		{
+			// Clamp the number of sub steps, to prevent simulation grinding spiralling down to a halt
+			const int ClampedSimulationSteps = (NumSimulationSubSteps > MaxSubSteps) ? MaxSubSteps : NumSimulationSubSteps;
+
+			this->saveKinematicState(FixedTimeStep * ClampedSimulationSteps);
+
+			this->applyGravity();
+
+			for (int i = 0; i < ClampedSimulationSteps; i++)
+			{
+				this->internalSingleStepSimulation(FixedTimeStep);
+				this->synchronizeMotionStates();
+			}
+		}
+		else
+		{
+			this->synchronizeMotionStates();
+		}
+
+		this->clearForces();
+
+		return NumSimulationSubSteps;
+	}
+
+	/**
+	 * Same as btCollisionWorld::updateSingleAabb, padded by this world's contact breaking threshold. Bullet's isn't virtual and reads
+	 * gContactBreakingThreshold, so anything refreshing a single object's bounds outside of a step goes through this one instead.
+	 */
+	void UpdateSingleAabb(btCollisionObject* Obj)
+	{
+		const btVector3 ContactThreshold(Tunables.ContactBreakingThreshold, Tunables.ContactBreakingThreshold, Tunables.ContactBreakingThreshold);
+		btBroadphaseInterface* Broadphase = this->getBroadphase();
+		btDispatcher* Dispatcher = this->getDispatcher();
+
+		btVector3 MinAabb, MaxAabb;
+		Obj->getCollisionShape()->getAabb(Obj->getWorldTransform(), MinAabb, MaxAabb);
+		MinAabb -= ContactThreshold;
+		MaxAabb += ContactThreshold;
+
+		if (this->getDispatchInfo().m_useContinuous && Obj->getInternalType() == btCollisionObject::CO_RIGID_BODY && !Obj->isStaticOrKinematicObject())
+		{
+			btVector3 MinAabb2, MaxAabb2;
+			Obj->getCollisionShape()->getAabb(Obj->getInterpolationWorldTransform(), MinAabb2, MaxAabb2);
+			MinAabb2 -= ContactThreshold;
+			MaxAabb2 += ContactThreshold;
+			MinAabb.setMin(MinAabb2);
+			MaxAabb.setMax(MaxAabb2);
+		}
+
+		// Moving objects should be moderately sized, probably something wrong if not
+		if (Tunables.bDeterministic && !Obj->isStaticObject() && (MaxAabb - MinAabb).length2() < btScalar(1e12))
+		{
+			// Exact bounds every step, rather than padded ones that are only moved once something leaves them, so which pairs exist
+			// depends on where the bodies are and not on how they got there. FBulletWorldParts always builds a btDbvtBroadphase
+			static_cast<btDbvtBroadphase*>(Broadphase)->setAabbForceUpdate(Obj->getBroadphaseHandle(), MinAabb, MaxAabb, Dispatcher);
+		}
+		else if (Obj->isStaticObject() || ((MaxAabb - MinAabb).length2() < btScalar(1e12)))
+		{
+			Broadphase->setAabb(Obj->getBroadphaseHandle(), MinAabb, MaxAabb, Dispatcher);
+		}
+		else
+		{
+			Obj->setActivationState(DISABLE_SIMULATION);
+		}
+	}
+
+	// Same as btCollisionWorld::updateAabbs, through UpdateSingleAabb
+	virtual void updateAabbs() override
+	{
+		BT_PROFILE("updateAabbs");
+
+		btCollisionObjectArray& Objects = this->getCollisionObjectArray();
+		for (int i = 0; i < Objects.size(); i++)
+		{
+			btCollisionObject* Obj = Objects[i];
+			if (!this->m_forceUpdateAllAabbs && !Obj->isActive()) continue;
+
+			UpdateSingleAabb(Obj);
+		}
+	}
+
+	virtual void computeOverlappingPairs() override
+	{
+		if (!Tunables.bDeterministic)
+		{
+			BaseWorldType::computeOverlappingPairs();
+			return;
+		}
+
+		// Bullet checks a tenth of the pairs for separation each step, carrying on from where it stopped. Checking all of them from the
+		// start drops every separated pair straight away, rather than after some number of steps that depends on the history
+		btDbvtBroadphase* Broadphase = static_cast<btDbvtBroadphase*>(this->getBroadphase());
+		const int CleanupPercent = Broadphase->m_cupdates;
+		Broadphase->m_cupdates = 100;
+		Broadphase->m_cid = 0;
+		BaseWorldType::computeOverlappingPairs();
+		Broadphase->m_cupdates = CleanupPercent;
+
+		SortOverlappingPairs();
+	}
+
+	virtual void performDiscreteCollisionDetection() override
+	{
+		BaseWorldType::performDiscreteCollisionDetection();
+
+		if (Tunables.bDeterministic)
+		{
+			SortManifolds();
+		}
+	}
+
+protected:
+	// Set from the debug drawer every step, the per world version of bullet writing gDisableDeactivation
+	bool bDebugDisableDeactivation = false;
+
+	// Scratch of the deterministic ordering, kept so its memory is reused
+	btAlignedObjectArray<btBroadphasePair> PairScratch;
+	btAlignedObjectArray<btPersistentManifold*> ManifoldScratch;
+	btAlignedObjectArray<btCollisionObject*> SleepingObjects;
+
+	// Manifolds by the ids of their objects. A compound pair has a manifold per touching child, told apart by the child of their first contact.
+	// Empty manifolds never reach the solver, so it doesn't matter where they end up
+	struct FManifoldOrder
+	{
+		bool operator()(const btPersistentManifold* A, const btPersistentManifold* B) const
+		{
+			const int IdA0 = GetStableId(A->getBody0());
+			const int IdB0 = GetStableId(B->getBody0());
+			if (IdA0 != IdB0) return IdA0 < IdB0;
+			const int IdA1 = GetStableId(A->getBody1());
+			const int IdB1 = GetStableId(B->getBody1());
+			if (IdA1 != IdB1) return IdA1 < IdB1;
+
+			if (A->getNumContacts() == 0 || B->getNumContacts() == 0) return A->getNumContacts() > B->getNumContacts();
+			const btManifoldPoint& PointA = A->getContactPoint(0);
+			const btManifoldPoint& PointB = B->getContactPoint(0);
+			if (PointA.m_index0 != PointB.m_index0) return PointA.m_index0 < PointB.m_index0;
+			if (PointA.m_index1 != PointB.m_index1) return PointA.m_index1 < PointB.m_index1;
+			if (PointA.m_partId0 != PointB.m_partId0) return PointA.m_partId0 < PointB.m_partId0;
+			return PointA.m_partId1 < PointB.m_partId1;
+		}
+	};
+
+	// Puts the overlapping pairs in bullet's own pair order (btBroadphasePairSortPredicate), by the ids of their objects. Removing and re-adding
+	// them rebuilds the pair cache's hash chains along with the array, and without a dispatcher the pairs keep their algorithms through it
+	void SortOverlappingPairs()
+	{
+		btOverlappingPairCache* PairCache = this->getPairCache();
+		btBroadphasePairArray& Pairs = PairCache->getOverlappingPairArray();
+		const btBroadphasePairSortPredicate PairOrder;
+
+		bool bSorted = true;
+		for (int i = 1; i < Pairs.size() && bSorted; i++)
+		{
+			bSorted = !PairOrder(Pairs[i], Pairs[i - 1]);
+		}
+		if (bSorted) return;
+
+		BT_PROFILE("sortOverlappingPairs");
+
+		PairScratch.copyFromArray(Pairs);
+		PairScratch.quickSort(PairOrder);
+		for (int i = 0; i < PairScratch.size(); i++)
+		{
+			PairCache->removeOverlappingPair(PairScratch[i].m_pProxy0, PairScratch[i].m_pProxy1, nullptr);
+		}
+		for (int i = 0; i < PairScratch.size(); i++)
+		{
+			const btBroadphasePair& Sorted = PairScratch[i];
+			if (btBroadphasePair* Pair = PairCache->addOverlappingPair(Sorted.m_pProxy0, Sorted.m_pProxy1))
+			{
+				Pair->m_algorithm = Sorted.m_algorithm;
+				Pair->m_internalInfo1 = Sorted.m_internalInfo1;
+			}
+			else if (Sorted.m_algorithm)
+			{
+				// Only refused when the filters changed since, the pair would have been dropped with its algorithm anyway
+				Sorted.m_algorithm->~btCollisionAlgorithm();
+				this->getDispatcher()->freeCollisionAlgorithm(Sorted.m_algorithm);
+			}
+		}
+	}
+
+	// Puts the dispatcher's manifolds in FManifoldOrder. Bullet adds them in pair order, or in the order the threads got to them with the Mt
+	// dispatcher, and moves the last one into the gap a released one leaves
+	void SortManifolds()
+	{
+		btDispatcher* Dispatcher = this->getDispatcher();
+		const int NumManifolds = Dispatcher->getNumManifolds();
+		btPersistentManifold** Manifolds = Dispatcher->getInternalManifoldPointer();
+		const FManifoldOrder ManifoldOrder;
+
+		bool bSorted = true;
+		for (int i = 1; i < NumManifolds && bSorted; i++)
+		{
+			bSorted = !ManifoldOrder(Manifolds[i], Manifolds[i - 1]);
+		}
+		if (bSorted) return;
+
+		BT_PROFILE("sortManifolds");
+
+		ManifoldScratch.resize(NumManifolds);
+		for (int i = 0; i < NumManifolds; i++)
+		{
+			ManifoldScratch[i] = Manifolds[i];
+		}
+		ManifoldScratch.quickSort(ManifoldOrder);
+		for (int i = 0; i < NumManifolds; i++)
+		{
+			Manifolds[i] = ManifoldScratch[i];
+			// The dispatcher finds a manifold it releases by this
+			Manifolds[i]->m_index1a = i;
+		}
+	}
+
+	// Same as btDiscreteDynamicsWorld::updateActivationState, apart from where the deactivation time comes from
+	virtual void updateActivationState(btScalar TimeStep) override
+	{
+		BT_PROFILE("updateActivationState");
+
+		for (int i = 0; i < this->m_nonStaticRigidBodies.size(); i++)
+		{
+			btRigidBody* Body = this->m_nonStaticRigidBodies[i];
+			if (!Body) continue;
+
+			Body->updateDeactivation(TimeStep);
+
+			if (WantsSleeping(Body))
+			{
+				if (Body->isStaticOrKinematicObject())
+				{
+					Body->setActivationState(ISLAND_SLEEPING);
+				}
+				else
+				{
+					if (Body->getActivationState() == ACTIVE_TAG)
+						Body->setActivationState(WANTS_DEACTIVATION);
+					if (Body->getActivationState() == ISLAND_SLEEPING)
+					{
+						Body->setAngularVelocity(btVector3(0, 0, 0));
+						Body->setLinearVelocity(btVector3(0, 0, 0));
+					}
+				}
+			}
+			else
+			{
+				if (Body->getActivationState() != DISABLE_DEACTIVATION)
+					Body->setActivationState(ACTIVE_TAG);
+			}
+		}
+	}
+
+	bool WantsSleeping(const btRigidBody* Body) const
+	{
+		const int State = Body->getActivationState();
+		if (State == DISABLE_DEACTIVATION) return false;
+
+		const btScalar DeactivationTime = Body->getUserIndex2() >= 0 ? Body->getUserIndex2() * btScalar(0.001) : Tunables.DeactivationTime;
+		if (Tunables.bDisableDeactivation || bDebugDisableDeactivation || DeactivationTime == btScalar(0.)) return false;
+
+		if (State == ISLAND_SLEEPING || State == WANTS_DEACTIVATION) return true;
+
+		return Body->getDeactivationTime() > DeactivationTime;
+	}
+};
+
+using FBulletDynamicsWorld = TBulletDynamicsWorld<btDiscreteDynamicsWorld>;
+using FBulletDynamicsWorldMt = TBulletDynamicsWorld<btDiscreteDynamicsWorldMt>;
+
+
+/** Collision dispatcher that gives new manifolds the world's contact breaking threshold rather than gContactBreakingThreshold */
+template <typename BaseDispatcherType>
+class TBulletCollisionDispatcher : public BaseDispatcherType
+{
+public:
+	using BaseDispatcherType::BaseDispatcherType;
+
+	// Kept in sync with the world's FBulletWorldTunables by the subsystem
+	btScalar ContactBreakingThreshold = btScalar(0.02);
+
+	// Live collision algorithms that didn't fit in the configuration's pool. Counted as they're made rather than found through the pairs,
+	// so the child algorithms compound pairs keep for each touching child are included. Narrowphase threads allocate concurrently
+	std::atomic<int> NumOverflowAlgorithms{0};
+
+	virtual void* allocateCollisionAlgorithm(int Size) override
+	{
+		void* Mem = BaseDispatcherType::allocateCollisionAlgorithm(Size);
+		if (!this->m_collisionAlgorithmPoolAllocator->validPtr(Mem))
+		{
+			NumOverflowAlgorithms.fetch_add(1, std::memory_order_relaxed);
+		}
+		return Mem;
+	}
+
+	virtual void freeCollisionAlgorithm(void* Ptr) override
+	{
+		if (!this->m_collisionAlgorithmPoolAllocator->validPtr(Ptr))
+		{
+			NumOverflowAlgorithms.fetch_sub(1, std::memory_order_relaxed);
+		}
+		BaseDispatcherType::freeCollisionAlgorithm(Ptr);
+	}
+
+	virtual btPersistentManifold* getNewManifold(const btCollisionObject* Body0, const btCollisionObject* Body1) override
+	{
+		btPersistentManifold* Manifold = BaseDispatcherType::getNewManifold(Body0, Body1);
+
+		// Same choice bullet makes, with our threshold in place of the global one
+		const btScalar Threshold = (this->m_dispatcherFlags & btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD)
+			? btMin(Body0->getCollisionShape()->getContactBreakingThreshold(ContactBreakingThreshold), Body1->getCollisionShape()->getContactBreakingThreshold(ContactBreakingThreshold))
+			: ContactBreakingThreshold;
+		Manifold->setContactBreakingThreshold(Threshold);
+		return Manifold;
+	}
+};
+
+using FBulletCollisionDispatcher = TBulletCollisionDispatcher<btCollisionDispatcher>;
+
+/**
+ * btCollisionDispatcherMt sizes its per thread manifold batches with the scheduler's thread count, but indexes them with bullet's thread index.
+ * Task graph workers are handed out indices in whatever order they first touch bullet, so size the batches for every index bullet can give out instead.
+ */
+class FBulletCollisionDispatcherMt : public TBulletCollisionDispatcher<btCollisionDispatcherMt>
+{
+public:
+	FBulletCollisionDispatcherMt(btCollisionConfiguration* Config, int GrainSize = 40)
+		: TBulletCollisionDispatcher<btCollisionDispatcherMt>(Config, GrainSize)
+	{
+		m_batchManifoldsPtr.resize(BT_MAX_THREAD_COUNT);
+		m_batchReleasePtr.resize(BT_MAX_THREAD_COUNT);
+	}
+
+	virtual void releaseManifold(btPersistentManifold* Manifold) override
+	{
+		// Manifolds made during a batch only get their index once the whole batch is merged, so one released in the same batch
+		// still has its default one and would take some other manifold out of the list with it
+		if (!m_batchUpdating && (Manifold->m_index1a >= m_manifoldsPtr.size() || m_manifoldsPtr[Manifold->m_index1a] != Manifold))
+		{
+			Manifold->m_index1a = m_manifoldsPtr.findLinearSearch(Manifold);
+		}
+		TBulletCollisionDispatcher<btCollisionDispatcherMt>::releaseManifold(Manifold);
+	}
+};
+
+
+/** How full one of the collision configuration's pools is. Once a pool runs out bullet allocates every further element on its own */
+struct FBulletPoolCounts
+{
+	int Used = 0;
+	int Capacity = 0;
+	// Live elements that didn't fit in the pool
+	int Overflow = 0;
+};
+
+
+/**
+ * Everything a bullet world is built from, put together the one way the subsystem and the standalone benchmark both use.
+ * Nothing in here needs the engine, so the benchmark builds it against bullet alone.
+ */
+struct FBulletWorldParts
+{
+	btCollisionConfiguration* CollisionConfig = nullptr;
+	btBroadphaseInterface* Broadphase = nullptr;
+	btCollisionDispatcher* Dispatcher = nullptr;
+	// Only used by the multithreaded pipeline, the world's solver for islands small enough to be solved one per thread
+	btConstraintSolverPoolMt* SolverPool = nullptr;
+	btSequentialImpulseConstraintSolver* Solver = nullptr;
+	btDiscreteDynamicsWorld* World = nullptr;
+	bool bMultithreaded = false;
+
+	/**
+	 * Builds an FBulletDynamicsWorld, or an FBulletDynamicsWorldMt solving on NumThreads threads. Bullet's task scheduler has to be set before a multithreaded world is built.
+	 * ConstructionInfo sizes the persistent manifold and collision algorithm pools.
+	 */
+	static FBulletWorldParts Create(bool bMultithreaded, int NumThreads, const btDefaultCollisionConstructionInfo& ConstructionInfo = btDefaultCollisionConstructionInfo())
+	{
+		FBulletWorldParts Parts;
+		Parts.bMultithreaded = bMultithreaded;
+		Parts.CollisionConfig = new btDefaultCollisionConfiguration(ConstructionInfo);
+		Parts.Broadphase = new btDbvtBroadphase();
+
+		if (bMultithreaded)
+		{
+			Parts.Dispatcher = new FBulletCollisionDispatcherMt(Parts.CollisionConfig);
+
+			// Each thread grabs its own solver from the pool for the small islands, big ones go to the Mt solver
+			Parts.SolverPool = new btConstraintSolverPoolMt(NumThreads);
+			Parts.Solver = new btSequentialImpulseConstraintSolverMt;
+			Parts.Solver->setRandSeed(1234);
+			Parts.World = new FBulletDynamicsWorldMt(Parts.Dispatcher, Parts.Broadphase, Parts.SolverPool, Parts.Solver, Parts.CollisionConfig);
+		}
+		else
+		{
+			Parts.Dispatcher = new FBulletCollisionDispatcher(Parts.CollisionConfig);
+
+			Parts.Solver = new btSequentialImpulseConstraintSolver;
+			Parts.Solver->setRandSeed(1234);
+			Parts.World = new FBulletDynamicsWorld(Parts.Dispatcher, Parts.Broadphase, Parts.Solver, Parts.CollisionConfig);
+		}
+		return Parts;
+	}
+
+	/** Hands the world and its dispatcher their tunables. World and Dispatcher must have come from Create */
+	static void SetTunables(btDiscreteDynamicsWorld* World, btCollisionDispatcher* Dispatcher, bool bMultithreaded, const FBulletWorldTunables& Tunables)
+	{
+		if (bMultithreaded)
+		{
+			static_cast<FBulletDynamicsWorldMt*>(World)->Tunables = Tunables;
+			static_cast<FBulletCollisionDispatcherMt*>(Dispatcher)->ContactBreakingThreshold = Tunables.ContactBreakingThreshold;
+		}
+		else
+		{
+			static_cast<FBulletDynamicsWorld*>(World)->Tunables = Tunables;
+			static_cast<FBulletCollisionDispatcher*>(Dispatcher)->ContactBreakingThreshold = Tunables.ContactBreakingThreshold;
+		}
+	}
+
+	void SetTunables(const FBulletWorldTunables& Tunables) const
+	{
+		SetTunables(World, Dispatcher, bMultithreaded, Tunables);
+	}
+
+	/** Calls Func with World as the TBulletDynamicsWorld Create built it as, for what only our worlds have */
+	template <typename FuncType>
+	static decltype(auto) VisitWorld(btDiscreteDynamicsWorld* World, bool bMultithreaded, FuncType&& Func)
+	{
+		if (bMultithreaded)
+		{
+			return Func(*static_cast<FBulletDynamicsWorldMt*>(World));
+		}
+		return Func(*static_cast<FBulletDynamicsWorld*>(World));
+	}
+
+	/** Persistent manifold pool of a world built by Create. Overflow is only looked for once the pool is full */
+	static FBulletPoolCounts GetManifoldPoolCounts(btDiscreteDynamicsWorld* World)
+	{
+		btDispatcher* Dispatcher = World->getDispatcher();
+		btPoolAllocator* Pool = static_cast<btCollisionDispatcher*>(Dispatcher)->getCollisionConfiguration()->getPersistentManifoldPool();
+
+		FBulletPoolCounts Counts;
+		Counts.Used = Pool->getUsedCount();
+		Counts.Capacity = Pool->getMaxCount();
+		if (Pool->getFreeCount() == 0)
+		{
+			for (int i = 0; i < Dispatcher->getNumManifolds(); i++)
+			{
+				Counts.Overflow += Pool->validPtr(Dispatcher->getManifoldByIndexInternal(i)) ? 0 : 1;
+			}
+		}
+		return Counts;
+	}
+
+	/** Collision algorithm pool of a world built by Create, compound pairs' child algorithms included */
+	static FBulletPoolCounts GetAlgorithmPoolCounts(btDiscreteDynamicsWorld* World, bool bMultithreaded)
+	{
+		btCollisionDispatcher* Dispatcher = static_cast<btCollisionDispatcher*>(World->getDispatcher());
+		btPoolAllocator* Pool = Dispatcher->getCollisionConfiguration()->getCollisionAlgorithmPool();
+
+		FBulletPoolCounts Counts;
+		Counts.Used = Pool->getUsedCount();
+		Counts.Capacity = Pool->getMaxCount();
+		Counts.Overflow = bMultithreaded
+			? static_cast<FBulletCollisionDispatcherMt*>(Dispatcher)->NumOverflowAlgorithms.load(std::memory_order_relaxed)
+			: static_cast<FBulletCollisionDispatcher*>(Dispatcher)->NumOverflowAlgorithms.load(std::memory_order_relaxed);
+		return Counts;
+	}
+
+	/** Deletes everything in reverse order of creation, the world refers to everything else. Bodies and shapes still in the world are left to the caller */
+	void Destroy()
+	{
+		delete World;
+		delete Solver;
+		delete SolverPool;
+		delete Broadphase;
+		delete Dispatcher;
+		delete CollisionConfig;
+		*this = FBulletWorldParts();
+	}
+};
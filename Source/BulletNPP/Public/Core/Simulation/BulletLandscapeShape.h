@@ -0,0 +1,47 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletMain.h"
+#include "Chaos/HeightField.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+class ULandscapeHeightfieldCollisionComponent;
+
+/**
+ * Bullet heightfield reading straight out of a landscape component's Chaos heightfield, nothing is copied.
+ * Chaos keeps its heights as uint16 steps above a minimum, which bullet has no data type for, so the raw height lookup is overridden to decode them.
+ * Holds a reference on the Chaos heightfield so the heights outlive a collision rebuild on the component.
+ * Holes are not carried over, bullet's heightfield has no way to leave cells out.
+ */
+class BULLETNPP_API FBulletLandscapeHeightfieldShape : public btHeightfieldTerrainShape
+{
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	/**
+	 * Builds the shape for a landscape collision component, scaled to the component and with its acceleration grid built.
+	 * Bullet centres heightfields on their bounds, so OutTransform is where the shape has to sit in UE space, which is not the component's origin.
+	 * Returns null when the component has no collision heightfield yet.
+	 */
+	static FBulletLandscapeHeightfieldShape* Create(const ULandscapeHeightfieldCollisionComponent* Component, FTransform& OutTransform);
+
+protected:
+	FBulletLandscapeHeightfieldShape(const Chaos::FHeightFieldPtr& InHeightfield, btScalar MinHeight, btScalar MaxHeight);
+
+	virtual btScalar getRawHeightFieldValue(int x, int y) const override
+	{
+		return HeightOffset + btScalar(Heights[y * m_heightStickWidth + x]) * HeightPerUnit;
+	}
+
+	Chaos::FHeightFieldPtr Heightfield;
+	const uint16* Heights = nullptr;
+	btScalar HeightOffset = 0;
+	btScalar HeightPerUnit = 1;
+};
@@ -7,6 +7,8 @@
 #include "NetworkPredictionStateTypes.h"
 #include "NetworkPredictionTickState.h"
 #include "Core/DataTypes/BulletSimulationTypes.h"
+#include "Core/DataTypes/BulletBodyHandle.h"
+#include "Core/DataTypes/BulletActivationPolicy.h"
 #include "Core/Interfaces/BulletBackendLiaisonInterface.h"
 #include "BulletLiaisonComponent.generated.h"
 
@@ -66,6 +68,20 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 	
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	
+	// Reads back our body's state once the Bullet world has been stepped for a frame, and publishes it to the frame's output
+	void OnBulletWorldStepped(int32 SimFrame, float DeltaSeconds);
+	
+	// Writes the state our body ended the frame on, and the world hash, into the frame's output sync state
+	void PublishSteppedState(int32 SimFrame, FBulletSyncState& OutSync) const;
+	
+	// Tracks whether our body is asleep, so we don't bother reading it back while it can't have moved
+	void OnBulletActivationEvents(TConstArrayView<FBulletActivationEvent> Events);
+	
+	// Records which of our frames the sync state starts, and puts the world hash in it on the frames the authority replicates one
+	void WriteWorldStateHash(int32 SimFrame, FBulletSyncState& OutSyncState) const;
+	
 	
 #pragma region SETTINGS
 	
@@ -75,6 +91,10 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Settings)
 	uint8 bDoSimProxiesForwardPredictThisSimulation : 1 = 1;
 	
+	// When our rigid body is allowed to sleep
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Settings)
+	FBulletActivationPolicy ActivationPolicy;
+	
 #pragma endregion SETTINGS
 	
 
@@ -87,6 +107,24 @@ protected:
 	float ElapsedTime = 0.f;
 	bool bIsFirstTick = true;
 	
+	// The rigid body registered for our owner in the Bullet world
+	FBulletBodyHandle RigidBody;
+	
+	FDelegateHandle WorldSteppedHandle;
+	FDelegateHandle ActivationEventsHandle;
+	
+	bool bBodySleeping = false;
+	
+	// Body state read back after the most recent world step
+	int32 LastSteppedFrame = INDEX_NONE;
+	FTransform LastSteppedTransform;
+	FVector LastSteppedVelocity = FVector::ZeroVector;
+	FVector LastSteppedAngularVelocity = FVector::ZeroVector;
+	
+	// The output of the frame we ticked last, filled in once the world has been stepped for it
+	FBulletSyncState* PendingOutputSync = nullptr;
+	int32 PendingOutputFrame = INDEX_NONE;
+	
 	
 	
 };
@@ -0,0 +1,32 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// Everything bullet allocates, shown under its own tag in LLM (stat LLMFULL, LLM csv captures)
+LLM_DECLARE_TAG_API(Bullet, BULLETNPP_API);
+
+/**
+ * Sends every bullet allocation (btAlignedAlloc, so bullet's new/delete and all of its arrays and pools) through FMemory instead of the system malloc,
+ * under the Bullet LLM tag, and keeps count of what's live so physics memory can be budgeted.
+ * Does nothing unless the module was built with WITH_BULLET_UE_ALLOCATOR.
+ */
+class BULLETNPP_API FBulletMemory
+{
+public:
+	// Hooks bullet's allocator. Process wide, so the module does it once before anything of bullet's is created
+	static void Install();
+
+	// Gives bullet back its own allocator, unless something allocated through the hooks is still alive and would be freed by the wrong one
+	static void Uninstall();
+
+	// Bytes bullet asked for and hasn't freed yet, leaving out what FMemory adds on top
+	static int64 GetLiveBytes();
+
+	// Most bytes bullet has had live at once since Install
+	static int64 GetPeakBytes();
+
+	static int64 GetLiveAllocations();
+};
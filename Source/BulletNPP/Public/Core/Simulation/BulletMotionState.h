@@ -5,16 +5,34 @@
 #include "CoreMinimal.h"
 #include "BulletMain.h"
 #include "Core/Libraries/BulletMathLibrary.h"
+#include "Core/Simulation/BulletTransformWriteBuffer.h"
 
 
-class BULLETNPP_API FBulletMotionState : public btMotionState
+/** What both motion states share with the subsystem: where the bullet world sits in UE space, and where to defer their writes to */
+class BULLETNPP_API FBulletMotionStateBase : public btMotionState
 {
-	
 protected:
-		TWeakObjectPtr<USceneComponent> UpdatedComponent;
 		// Bullet is made local so that all sims are close to origin
 		// This world origin must be in *UE dimensions*
-		FVector WorldOrigin;
+		FVector WorldOrigin = FVector::ZeroVector;
+		// When set, transforms go into this buffer at WriteSlot instead of straight onto the component
+		FBulletTransformWriteBuffer* WriteBuffer = nullptr;
+		int32 WriteSlot = INDEX_NONE;
+
+	public:
+		// Called when the subsystem rebases its world, bodies keep their bullet transforms so only the mapping to UE changes
+		void SetWorldOrigin(const FVector& NewOrigin)
+		{
+			WorldOrigin = NewOrigin;
+		}
+};
+
+
+class BULLETNPP_API FBulletMotionState : public FBulletMotionStateBase
+{
+	
+protected:
+		TWeakObjectPtr<USceneComponent> UpdatedComponent;
 		btTransform CenterOfMassTransform;
 
 
@@ -48,19 +66,34 @@ protected:
 			if (UpdatedComponent.IsValid(false))
 			{
 				btTransform GraphicTrans = CenterOfMassWorldTrans * CenterOfMassTransform;
-				UpdatedComponent->SetWorldTransform(BulletHelpers::ToUE(GraphicTrans, WorldOrigin));
+				if (WriteBuffer)
+				{
+					WriteBuffer->Write(WriteSlot, BulletHelpers::ToUE(GraphicTrans, WorldOrigin));
+				}
+				else
+				{
+					UpdatedComponent->SetWorldTransform(BulletHelpers::ToUE(GraphicTrans, WorldOrigin));
+				}
+			}
+		}
+
+		// Defers writes to the component until the buffer is applied
+		void SetWriteBuffer(FBulletTransformWriteBuffer* Buffer, int32 Slot)
+		{
+			WriteBuffer = Buffer;
+			WriteSlot = Slot;
+			if (WriteBuffer)
+			{
+				WriteBuffer->SetComponent(WriteSlot, UpdatedComponent.Get());
 			}
 		}
 };
 
 
-class BULLETNPP_API FBulletUEMotionState: public btMotionState
+class BULLETNPP_API FBulletUEMotionState: public FBulletMotionStateBase
 {
 	protected:
 		TWeakObjectPtr<USkeletalMeshComponent> Parent;
-		// Bullet is made local so that all sims are close to origin
-		// This world origin must be in *UE dimensions*
-		FVector WorldOrigin;
 		FTransform LocalTransform;
 		btTransform CenterOfMassTransform;
 
@@ -77,9 +110,11 @@ class BULLETNPP_API FBulletUEMotionState: public btMotionState
 				const btTransform& CenterOfMassOffset = btTransform::getIdentity()
 				):
 			Parent(ParentActor),
-			WorldOrigin(WorldCentre),LocalTransform(localTransform),
+			LocalTransform(localTransform),
 			CenterOfMassTransform(CenterOfMassOffset)
-		{}
+		{
+			WorldOrigin = WorldCentre;
+		}
 
 		///synchronizes world transform from UE to physics (typically only called at start)
 		void getWorldTransform(btTransform& OutCenterOfMassWorldTrans) const override
@@ -96,7 +131,25 @@ class BULLETNPP_API FBulletUEMotionState: public btMotionState
 			if (Parent.IsValid(false))
 			{
 				btTransform GraphicTrans = CenterOfMassWorldTrans * CenterOfMassTransform;
-				Parent->SetWorldTransform(LocalTransform.Inverse()* BulletHelpers::ToUE(GraphicTrans, WorldOrigin));
+				if (WriteBuffer)
+				{
+					WriteBuffer->Write(WriteSlot, LocalTransform.Inverse()* BulletHelpers::ToUE(GraphicTrans, WorldOrigin));
+				}
+				else
+				{
+					Parent->SetWorldTransform(LocalTransform.Inverse()* BulletHelpers::ToUE(GraphicTrans, WorldOrigin));
+				}
+			}
+		}
+
+		// Defers writes to the component until the buffer is applied
+		void SetWriteBuffer(FBulletTransformWriteBuffer* Buffer, int32 Slot)
+		{
+			WriteBuffer = Buffer;
+			WriteSlot = Slot;
+			if (WriteBuffer)
+			{
+				WriteBuffer->SetComponent(WriteSlot, Parent.Get());
 			}
 		}
 };
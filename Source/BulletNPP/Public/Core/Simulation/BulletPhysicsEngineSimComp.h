@@ -4,9 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Core/DataTypes/BulletCharacterMovementTypes.h"
 #include "Core/DataTypes/BulletPhysicsTypes.h"
 #include "Core/DataTypes/BulletSimulationTypes.h"
 #include "Core/Interfaces/BulletBackendLiaisonInterface.h"
+#include "Core/Simulation/BulletBlackboard.h"
 #include "UObject/WeakInterfacePtr.h"
 #include "BulletPhysicsEngineSimComp.generated.h"
 
@@ -155,9 +157,28 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Bullet)
 	BULLETNPP_API USceneComponent* GetUpdatedComponent() const;
 	
+	// Whether the built-in walking and falling modes move this actor, rather than a dynamic rigid body
+	bool IsKinematicCharacter() const { return bKinematicCharacter; }
+	
+	UBulletBlackboard* GetSimBlackboard() const { return SimBlackboard; }
+	
 	
 protected:
 	
+	// Moves the owner as a kinematic capsule with the built-in walking and falling modes, swept against the Bullet world, instead of simulating it as a dynamic rigid body
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Character")
+	bool bKinematicCharacter = false;
+	
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Character", meta = (EditCondition = "bKinematicCharacter"))
+	FBulletCharacterMovementSettings CharacterSettings;
+	
+	// Scratch space for the simulation, such as the last floor found. Everything in it is dropped on rollback
+	UPROPERTY(Transient)
+	TObjectPtr<UBulletBlackboard> SimBlackboard;
+	
+	// Capsule the character is swept as, from the updated component when it's a capsule
+	void GetCapsuleSize(float& OutRadius, float& OutHalfHeight) const;
+	
 	
 	
 	
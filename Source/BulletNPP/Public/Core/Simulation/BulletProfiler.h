@@ -0,0 +1,29 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class btDiscreteDynamicsWorld;
+struct FBulletCollisionPoolStats;
+
+/**
+ * Shows bullet in Unreal Insights. Bullet's BT_PROFILE zones become cpu scopes on whichever thread entered them,
+ * task graph workers running bullet's parallel loops included, and each step publishes bullet's numbers as trace counters.
+ * Does nothing unless the module was built with WITH_BULLET_INSIGHTS.
+ */
+class BULLETNPP_API FBulletProfiler
+{
+public:
+	// Hooks bullet's profile zone callbacks. They're process wide, so the module does this once for every world
+	static void Install();
+
+	// Puts back whatever callbacks bullet had before Install
+	static void Uninstall();
+
+	// Sets the pair, manifold, contact, island, active body and solver iteration counters from a world that just stepped, and the bullet heap counter
+	static void ReportWorldCounters(btDiscreteDynamicsWorld* World);
+
+	// Publishes the manifold and algorithm pool usage as stats (stat Bullet) and, with WITH_BULLET_INSIGHTS, trace counters
+	static void ReportPoolStats(const FBulletCollisionPoolStats& Manifolds, const FBulletCollisionPoolStats& Algorithms);
+};
@@ -0,0 +1,48 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletMain.h"
+#include "Core/DataTypes/BulletSceneQueryTypes.h"
+#include "Engine/EngineTypes.h"
+
+class AActor;
+struct btDbvtNode;
+
+/**
+ * Batched ray, sphere sweep and sphere overlap queries against a bullet world whose broadphase is a btDbvtBroadphase.
+ * Rays and sweeps walk the broadphase trees nearest child first and clip to the closest hit found so far, so anything behind it is never visited.
+ * Each query's IgnoreActors and ObjectChannelMask are checked at the leaves, before any narrowphase work.
+ * The traversal stacks are kept between calls, so a batch doesn't allocate once warmed up. Not safe to run two batches on the same instance at once.
+ */
+class BULLETNPP_API FBulletSceneQuery
+{
+public:
+	// Below this many queries per worker, fanning out costs more than it saves
+	static constexpr int32 MinQueriesPerChunk = 32;
+
+	/** Closest hit of every ray, OutHits must be the same size as Rays. Only fills in HitObject, not the actor or body */
+	void Raycast(btCollisionWorld* World, const FVector& WorldOrigin, TConstArrayView<FBulletRaycast> Rays, TArrayView<FBulletQueryHit> OutHits, bool bParallel);
+
+	/** Closest hit of every sweep, OutHits must be the same size as Sweeps. Location is the contact point, not the sphere centre */
+	void SphereSweep(btCollisionWorld* World, const FVector& WorldOrigin, TConstArrayView<FBulletSphereSweep> Sweeps, TArrayView<FBulletQueryHit> OutHits, bool bParallel);
+
+	/** Appends everything each sphere touches to OutOverlaps. Always runs on the calling thread, the narrowphase goes through the world's dispatcher */
+	void SphereOverlap(btCollisionWorld* World, const FVector& WorldOrigin, TConstArrayView<FBulletSphereOverlap> Spheres, TArray<FBulletOverlapResult>& OutOverlaps);
+
+	/**
+	 * Tags Object with the channel ObjectChannelMask tests it against: the object type of Owner's root primitive component, or DefaultChannel without one.
+	 * Kept above the low byte of the third user index, which holds the contact report flags, see FBulletContactStream::SetReportFlags.
+	 */
+	static void SetObjectChannel(btCollisionObject* Object, const AActor* Owner, ECollisionChannel DefaultChannel);
+
+	static ECollisionChannel GetObjectChannel(const btCollisionObject* Object);
+
+private:
+	// Runs Function(QueryIndex, Stack) for every query, in chunks that each own one of the traversal stacks
+	template <typename FunctionType>
+	void ForEachQuery(int32 NumQueries, bool bParallel, const FunctionType& Function);
+
+	TArray<TArray<const btDbvtNode*>> ChunkStacks;
+};
@@ -0,0 +1,64 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BulletMain.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include "LinearMath/btThreads.h"
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+
+/**
+ * Runs bullet's parallel loops (btParallelFor / btParallelSum) on UE's task graph workers.
+ * Bullet only supports a single active scheduler, so this one is shared by every multithreaded world.
+ * Each world picks its thread count for the duration of its step with FScopedNumThreads, which only applies to the stepping thread, so worlds can step side by side.
+ * Loops started from inside one of our loops run inline on that thread. This replaces bullet's process wide btPushThreadsAreRunning counter,
+ * which would make a world see another world's loops as its own and stop batching its solver, so btThreadsAreRunning() stays false.
+ */
+class BULLETNPP_API FBulletTaskScheduler : public btITaskScheduler
+{
+public:
+	FBulletTaskScheduler();
+
+	// The shared instance, created on first use
+	static FBulletTaskScheduler& Get();
+
+	// Makes the shared instance bullet's active scheduler. Must be called from the game thread, which bullet then treats as its main thread
+	static void Activate();
+
+	// Detaches the shared instance from bullet, if it was ever activated
+	static void Shutdown();
+
+	// Thread count to use when a world asks for 0, the task graph workers plus the calling thread
+	static int32 GetDefaultNumThreads();
+
+	// Overrides the thread count for loops started from the calling thread, until it goes out of scope
+	struct FScopedNumThreads
+	{
+		explicit FScopedNumThreads(int32 InNumThreads);
+		~FScopedNumThreads();
+
+	private:
+		int32 PreviousNumThreads;
+	};
+
+	virtual int getMaxNumThreads() const override;
+	virtual int getNumThreads() const override;
+	virtual void setNumThreads(int InNumThreads) override;
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+	virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+private:
+	// How many chunks a loop gets split into at most, unless the calling thread has an override
+	int32 NumThreads;
+
+	// NumThreads, or the calling thread's FScopedNumThreads override
+	int32 GetActiveNumThreads() const;
+
+	static bool bActivated;
+};
+
@@ -0,0 +1,54 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+class USceneComponent;
+
+/**
+ * Collects the transforms bullet hands its motion states during a step so they can be pushed to the scene components in one pass afterwards.
+ * Stored as parallel arrays indexed by the body's pool slot. Only the last write per slot survives, so sub steps don't each move the component.
+ */
+class BULLETNPP_API FBulletTransformWriteBuffer
+{
+public:
+	// Sets the component a body slot writes to
+	void SetComponent(int32 Slot, USceneComponent* Component);
+
+	// Forgets a freed slot, along with anything it wrote that hasn't been applied yet
+	void RemoveSlot(int32 Slot);
+
+	// Called by the motion states from inside the step, doesn't touch the component
+	void Write(int32 Slot, const FTransform& Transform)
+	{
+		Locations[Slot] = Transform.GetLocation();
+		Rotations[Slot] = Transform.GetRotation();
+		if (!Dirty[Slot])
+		{
+			Dirty[Slot] = true;
+			DirtySlots.Add(Slot);
+		}
+	}
+
+	/**
+	 * Moves every component written to since the last apply.
+	 * @param TeleportType	How physics owned by the component should treat the move
+	 * @param bSweep	Sweep the component to its new location instead of teleporting it there
+	 * @param Tolerance	Components already within this distance (cm) of their new location, and RotationTolerance of their new rotation, are left alone
+	 * @param RotationTolerance	Angle (radians) between the component's rotation and its new one
+	 */
+	void Apply(ETeleportType TeleportType, bool bSweep, float Tolerance, float RotationTolerance);
+
+	void Reset();
+
+private:
+	TArray<TWeakObjectPtr<USceneComponent>> Components;
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+	TBitArray<> Dirty;
+
+	// Slots written since the last apply, in the order they were first written
+	TArray<int32> DirtySlots;
+};
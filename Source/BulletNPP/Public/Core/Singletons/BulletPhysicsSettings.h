@@ -0,0 +1,78 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "Core/DataTypes/BulletNetQuantization.h"
+#include "BulletPhysicsSettings.generated.h"
+
+/** How a bullet world is built and stepped */
+USTRUCT(BlueprintType)
+struct FBulletWorldProfile
+{
+	GENERATED_BODY()
+
+	// Build the multithreaded pipeline (btDiscreteDynamicsWorldMt & friends) with its parallel work run on the task graph
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Threading")
+	bool bMultithreaded = false;
+
+	// How many threads the world's step is spread over. 0 uses every task graph worker plus the game thread
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Threading", meta = (ClampMin = 0, EditCondition = "bMultithreaded"))
+	int32 NumWorkerThreads = 0;
+
+	// Contacts that drift further apart than this (cm) are dropped. Bullet's gContactBreakingThreshold, but for this world only
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Tunables", meta = (ClampMin = 0))
+	float ContactBreakingThreshold = 2.f;
+
+	// Seconds a body without its own activation policy has to rest before it sleeps. Bullet's gDeactivationTime, but for this world only
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Tunables", meta = (ClampMin = 0))
+	float DeactivationTime = 2.f;
+
+	// Never let anything in this world sleep. Bullet's gDisableDeactivation, but for this world only
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Tunables")
+	bool bDisableDeactivation = false;
+
+	// Contact manifolds allocated up front, one per touching pair. Past this bullet allocates each one on its own mid step,
+	// so size it from the subsystem's manifold pool peak in the busiest match on the map
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Memory", meta = (ClampMin = 1))
+	int32 MaxPersistentManifolds = 4096;
+
+	// Collision algorithms allocated up front, one per overlapping pair. Same fallback as the manifolds when it runs out
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Memory", meta = (ClampMin = 1))
+	int32 MaxCollisionAlgorithms = 4096;
+
+	// Resimulating from a snapshot gives back the exact same frames. Pairs and contacts are kept in body order, every bounds change is
+	// pushed to the broadphase and the solver isn't shuffled, which costs a bit more per step in busy scenes
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Determinism")
+	bool bDeterministic = false;
+};
+
+/**
+ * Project wide bullet physics settings, found under Project Settings > Plugins > Bullet Physics.
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Bullet Physics"))
+class BULLETNPP_API UBulletPhysicsSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UBulletPhysicsSettings();
+
+	static const UBulletPhysicsSettings* Get() { return GetDefault<UBulletPhysicsSettings>(); }
+
+	// The profile for a world, the map's override if it has one otherwise the default
+	const FBulletWorldProfile& GetWorldProfile(const UWorld* World) const;
+
+	// Used by every world without an override below
+	UPROPERTY(Config, EditAnywhere, Category = "World")
+	FBulletWorldProfile DefaultWorldProfile;
+
+	// Per map overrides of the default profile
+	UPROPERTY(Config, EditAnywhere, Category = "World")
+	TMap<TSoftObjectPtr<UWorld>, FBulletWorldProfile> MapWorldProfiles;
+
+	// Precision FBulletDefaultSyncState is replicated with, and the reconcile tolerances that go with it
+	UPROPERTY(Config, EditAnywhere, Category = "Networking")
+	FBulletSyncStateQuantization SyncStateQuantization;
+};
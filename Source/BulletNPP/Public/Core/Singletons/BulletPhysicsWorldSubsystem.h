@@ -8,14 +8,64 @@
 #include "PhysicsEngine/BodySetup.h"
 #include "Core/Libraries/BulletMathLibrary.h"
 #include "Core/Simulation/BulletMotionState.h"
+#include "Core/Simulation/BulletSceneQuery.h"
+#include "Core/Simulation/BulletContactStream.h"
+#include "Core/DataTypes/BulletWorldSnapshot.h"
+#include "Core/DataTypes/BulletCookedTriMesh.h"
+#include "Core/DataTypes/BulletCookedConvexHulls.h"
+#include "Core/DataTypes/BulletBodyHandle.h"
+#include "Core/DataTypes/BulletActivationPolicy.h"
+#include "Core/DataTypes/BulletContactEvents.h"
 #include "BulletMain.h"
 #include "Components/ShapeComponent.h"
 #include <functional>
 #include "GameFramework/Actor.h"
 #include "Subsystems/SubsystemCollection.h"
+#include "UObject/ObjectKey.h"
 #include "Templates/Function.h"
 #include "BulletPhysicsWorldSubsystem.generated.h"
 
+class ULandscapeHeightfieldCollisionComponent;
+
+class btConstraintSolverPoolMt;
+struct FBulletWorldTunables;
+
+
+// Lookup counters for the re-usable collision shape caches
+USTRUCT(BlueprintType)
+struct FBulletShapeCacheStats
+{
+	GENERATED_BODY()
+	
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Objects")
+	int32 Hits = 0;
+	
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Objects")
+	int32 Misses = 0;
+};
+
+// Usage of one of the world's collision pools, sampled after every step
+USTRUCT(BlueprintType)
+struct FBulletCollisionPoolStats
+{
+	GENERATED_BODY()
+	
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	int32 Used = 0;
+	
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	int32 Peak = 0;
+	
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	int32 Capacity = 0;
+	
+	// Live elements that didn't fit and were allocated one by one. Anything but 0 means the profile's pool size is too small
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	int32 Overflow = 0;
+	
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	int32 PeakOverflow = 0;
+};
 
 USTRUCT()
 struct FCollisionObjectArray
@@ -27,15 +77,20 @@ struct FCollisionObjectArray
 		
 	}
 	
-	FCollisionObjectArray(const int32& InObjectId)
+	FCollisionObjectArray(const FBulletBodyHandle& InBody)
 	{
-		ObjectIds.AddUnique(InObjectId);
+		Bodies.AddUnique(InBody);
 	}
 	
 	UPROPERTY()
-	TArray<int32> ObjectIds;
+	TArray<FBulletBodyHandle> Bodies;
 };
 
+DECLARE_MULTICAST_DELEGATE_OneParam(FBulletOnActivationEvents, TConstArrayView<FBulletActivationEvent> /*Events*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FBulletOnContactEvents, TConstArrayView<FBulletContactEvent> /*Events*/);
+// Broadcast once per Network Prediction frame, right after the shared Bullet world has been stepped for that frame
+DECLARE_MULTICAST_DELEGATE_TwoParams(FBulletOnWorldStepped, int32 /*SimFrame*/, float /*DeltaSeconds*/);
+
 /**
  * 
  */
@@ -48,6 +103,8 @@ class BULLETNPP_API UBulletPhysicsWorldSubsystem : public UWorldSubsystem
 	
 	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
 	
+	virtual void Deinitialize() override;
+	
 protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Objects")
 	bool DebugEnabled=true;
@@ -67,6 +124,64 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Objects")
 	int SubSteps=1;
 	
+	// Applied to bodies created outside of the registration functions, and the starting point for registrations
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Objects")
+	FBulletActivationPolicy DefaultActivationPolicy;
+	
+	// Shape dimensions (in UE units) closer than this share the same cached collision shape
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Objects", meta=(ClampMin=0.0001))
+	float ShapeCacheTolerance = 0.01f;
+	
+	// How many NP frames of world state we keep around to rewind to on a correction. Should cover the largest rollback NP will ask for
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Rollback", meta=(ClampMin=1))
+	int32 SnapshotHistorySize = 64;
+	
+	// If true the contact caches (and so the solver warm starting) are captured and restored too, otherwise a resim starts with whatever contacts the world has now
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Rollback")
+	bool bSnapshotContacts = true;
+	
+	// Hashes every body's transform and velocities into the snapshot of each frame, so a client can tell bullet drift apart from the rest of a correction.
+	// The server and client only agree when they simulate the same set of bodies
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Desync")
+	bool bHashWorldState = true;
+	
+	// Grid (bullet units, so m, m/s, rad/s and quaternion components) the state is snapped to before hashing, so worlds with a different origin still agree
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Desync", meta=(ClampMin=0.000001, EditCondition="bHashWorldState"))
+	float StateHashPrecision = 0.0001f;
+	
+	// Every how many NP frames the authority puts the world hash in every sim's sync state for clients to check theirs against, 0 never does.
+	// Clients check it as soon as they reconcile any of those sims
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Desync", meta=(ClampMin=0, EditCondition="bHashWorldState"))
+	int32 StateHashReplicationInterval = 0;
+	
+	// If true, bodies only record their new transform during the step and the components are moved once afterwards, instead of on every sub step
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Transforms")
+	bool bDeferTransformWrites = true;
+	
+	// How physics owned by the moved components treats the deferred move
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Transforms", meta=(EditCondition="bDeferTransformWrites"))
+	ETeleportType TransformWriteTeleportType = ETeleportType::TeleportPhysics;
+	
+	// Sweep components to their new transform, only worth it if something relies on the UE side overlaps/hits
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Transforms", meta=(EditCondition="bDeferTransformWrites"))
+	bool bSweepTransformWrites = false;
+	
+	// Components already this close (cm) to where bullet put them, and within TransformWriteRotationTolerance of its rotation, aren't moved at all
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Transforms", meta=(ClampMin=0.0, EditCondition="bDeferTransformWrites"))
+	float TransformWriteTolerance = 0.001f;
+	
+	// Angle (radians) a component's rotation can be off from bullet's without it being moved, see TransformWriteTolerance
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Transforms", meta=(ClampMin=0.0, EditCondition="bDeferTransformWrites"))
+	float TransformWriteRotationTolerance = 0.0001f;
+	
+	// Where (in UE space) the bullet world's origin sits. Everything in bullet is stored relative to this, so keeping it near the action keeps bullet coordinates small
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Origin")
+	FVector WorldOrigin = FVector::ZeroVector;
+	
+	// If true the bullet world is rebased along with UE whenever the world origin is shifted (UWorld::SetNewWorldOrigin)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|Origin")
+	bool bFollowWorldOriginShifts = true;
+	
 public:
 	/**
 	 * Creates a bullet physics compatible rigid body shape
@@ -75,10 +190,11 @@ public:
 	 * @param Restitution	Manually override the bounciness of the collision shape
 	 * @param Mass	Manually override the weight (in kg) of the collision shape
 	 * @param bUsePhysicsMaterial	If true the friction and restitution params will be ignored and instead pulled from the physics material
-	 * @param Id	Returns the id to use in collision lookups
+	 * @param ActivationPolicy	When the body is allowed to sleep, and what wakes it back up
+	 * @param Handle	Returns the handle to use in body lookups, unset if no body was created
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Registration", DisplayName="Register Dynamic Rigid Body")
-	void RegisterDynamicRigidBody(AActor* Target, float Friction, float Restitution, float Mass, bool bUsePhysicsMaterial, UPARAM(DisplayName="RigidBodyId") int32&Id );
+	void RegisterDynamicRigidBody(AActor* Target, float Friction, float Restitution, float Mass, bool bUsePhysicsMaterial, const FBulletActivationPolicy& ActivationPolicy, UPARAM(DisplayName="RigidBody") FBulletBodyHandle& Handle);
 	
 	/**
 	 * Creates a bullet physics compatible rigid body shape
@@ -87,20 +203,177 @@ public:
 	 * @param Restitution	Manually override the bounciness of the collision shape
 	 * @param Mass	Manually override the weight (in kg) of the collision shape
 	 * @param bUsePhysicsMaterial	If true the friction and restitution params will be ignored and instead pulled from the physics material
-	 * @param Id	Returns the id to use in collision lookups
+	 * @param Id	Returns the index of the last static collision object created for the actor
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Registration", DisplayName="Register Static Rigid Body")
 	void RegisterStaticRigidBody(AActor* Target, float Friction, float Restitution, bool bUsePhysicsMaterial, UPARAM(DisplayName="RigidBodyId") int32&Id );
 	
+	/**
+	 * Removes a dynamic rigid body from the world and returns its slot to the pool. The body's cached shape is released once no other body uses it.
+	 * Stale handles (already unregistered, or from before the slot was recycled) are ignored.
+	 * @param Handle	The handle returned by RegisterDynamicRigidBody
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Registration", DisplayName="Unregister Rigid Body")
+	void UnregisterRigidBody(FBulletBodyHandle Handle);
+	
+	/** @return the body the handle refers to, or null if it has been unregistered */
+	btRigidBody* GetRigidBody(const FBulletBodyHandle& Handle) const;
+	
+	/**
+	 * Gives a body an id that is the same on every machine, such as its owner's NP proxy id. The world hash is ordered by it and bodies of different
+	 * worlds are paired up by it, so it has to be set for every body whose owner was spawned at runtime. Bodies of actors loaded with the level fall
+	 * back to their owner's name, which is what the net driver matches those by as well.
+	 */
+	void SetRigidBodyNetworkId(FBulletBodyHandle Handle, int32 NetworkId);
+	
+	/** Changes when a registered body is allowed to sleep */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
+	void SetActivationPolicy(FBulletBodyHandle Handle, const FBulletActivationPolicy& ActivationPolicy);
+	
+	/** Wakes a sleeping body up so it is simulated again from the next step. Forces, impulses and state changes do this for you */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
+	void WakeRigidBody(FBulletBodyHandle Handle);
+	
+	/** @return true if the body is asleep, which means it isn't integrated, synced or worth replicating until it wakes up */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
+	bool IsRigidBodySleeping(FBulletBodyHandle Handle) const;
+	
 	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
-	void SetPhysicsState(int ID, FTransform transforms, FVector Velocity, FVector AngularVelocity,FVector& Force);
+	void SetPhysicsState(FBulletBodyHandle Handle, FTransform transforms, FVector Velocity, FVector AngularVelocity,FVector& Force);
 	
 	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
-	void GetPhysicsState(int ID, FTransform& transforms, FVector& Velocity, FVector& AngularVelocity, FVector& Force);
+	void GetPhysicsState(FBulletBodyHandle Handle, FTransform& transforms, FVector& Velocity, FVector& AngularVelocity, FVector& Force);
 	
 	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
 	void StepPhysics(float deltaSeconds, int maxSubSteps = 1, float fixedTimeStep = 0.016666667f);
 	
+	/**
+	 * Requests the shared world be stepped for a Network Prediction frame. Every Bullet driven sim calls this from its SimulationTick before queueing
+	 * its forces, but the world is only advanced once per frame. The step is flushed once every stepping sim has called FinishSimTick for the frame,
+	 * and failing that as soon as NP moves on to another frame (including a rollback to an earlier one), or at the end of the world's actor tick.
+	 * @param SimFrame	The NP frame being simulated
+	 * @param DeltaSeconds	The fixed step of that frame
+	 */
+	void RequestWorldStep(int32 SimFrame, float DeltaSeconds);
+	
+	/**
+	 * Called by a stepping sim at the end of its SimulationTick. The last one to finish the frame steps the world, so every sim of the frame
+	 * can publish the state it ends on before NP finalizes it.
+	 */
+	void FinishSimTick(int32 SimFrame);
+	
+	/** Sims that tick the world every frame add themselves here, so we know when the last of them has finished a frame */
+	void AddSteppingSim() { ++NumSteppingSims; }
+	void RemoveSteppingSim() { NumSteppingSims = FMath::Max(NumSteppingSims - 1, 0); }
+	
+	/** Steps the world for the pending frame, if any, then broadcasts OnWorldStepped so registered sims can read back their results */
+	void FlushWorldStep();
+	
+	/** Registered sims bind to this to read back their body state once the world has been stepped for a frame */
+	FBulletOnWorldStepped OnWorldStepped;
+	
+	/** Bodies that woke up or fell asleep since the previous step, broadcast right before OnWorldStepped when there are any */
+	FBulletOnActivationEvents OnActivationEvents;
+	
+	/** Every reported contact of the step in one array, broadcast after OnActivationEvents and before OnWorldStepped when there are any */
+	FBulletOnContactEvents OnContactEvents;
+	
+	/**
+	 * Chooses which contact events a body reports. Nothing is reported by default, and nothing is gathered at all while no body asks for anything.
+	 * @param Flags	EBulletContactReportFlags, a pair is reported when either of its bodies asks for the event
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Contacts")
+	void SetContactReportFlags(FBulletBodyHandle Handle, UPARAM(meta = (Bitmask, BitmaskEnum = "/Script/BulletNPP.EBulletContactReportFlags")) int32 Flags);
+	
+	/** Contact events of the last world step, valid until the next one. The same array OnContactEvents was broadcast with */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Contacts")
+	const TArray<FBulletContactEvent>& GetContactEvents() const { return ContactStream.GetEvents(); }
+	
+	/** Hit / miss counts of the box, sphere, capsule and convex hull shape caches since the world was created */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
+	FBulletShapeCacheStats GetShapeCacheStats() const { return ShapeCacheStats; }
+	
+	/** Persistent manifold pool usage, peaks since the world was created. Sized by MaxPersistentManifolds in the world's profile */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Memory")
+	FBulletCollisionPoolStats GetManifoldPoolStats() const { return ManifoldPoolStats; }
+	
+	/** Collision algorithm pool usage, peaks since the world was created. Sized by MaxCollisionAlgorithms in the world's profile */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Memory")
+	FBulletCollisionPoolStats GetAlgorithmPoolStats() const { return AlgorithmPoolStats; }
+	
+	/**
+	 * Captures the state of every rigid body (and optionally contact caches) as the starting state of a NP frame.
+	 * Called automatically after each world step, slots are reused so this doesn't allocate once the body count is stable.
+	 */
+	void RecordWorldSnapshot(int32 Frame);
+	
+	/**
+	 * Rewinds the world to the start of a NP frame prior to resimulating it. Only copies state back into the existing bodies, nothing is re-registered.
+	 * Safe to call from every sim in the rollback, the world is only restored once until it is stepped again.
+	 * @return false if the frame has already fallen out of the snapshot history
+	 */
+	bool RestoreWorldSnapshot(int32 Frame);
+	
+	/** @return false if the frame has fallen out of the snapshot history or the world isn't hashed. A frame's hash is that of its starting state */
+	bool GetWorldStateHash(int32 Frame, uint32& OutHash) const;
+	
+	/**
+	 * The hash every sim publishes in its sync state for a frame, so it reaches clients whichever sims they reconcile.
+	 * @return false on clients and on frames that don't carry one
+	 */
+	bool GetReplicatedWorldStateHash(int32 Frame, uint32& OutHash) const;
+	
+	/**
+	 * Checks the hash the authority replicated against our own. NP frame numbers differ between the server and each client, so the frame
+	 * our snapshot is looked up by is the local one the predicted state was produced for.
+	 * @param LocalFrame	Our frame the authority's state was matched up with
+	 * @param AuthorityFrame	The authority's number for the same frame, used to find its side of a desync
+	 */
+	void CheckAuthorityWorldStateHash(int32 LocalFrame, int32 AuthorityFrame, uint32 AuthorityHash);
+	
+	/**
+	 * Called when the authority's hash of a frame didn't match ours. The first mismatch captures every body of that frame for bullet.DumpDesync,
+	 * along with the authority's side when its world is in the same process.
+	 */
+	void ReportWorldStateMismatch(int32 LocalFrame, int32 AuthorityFrame, uint32 LocalHash, uint32 AuthorityHash);
+	
+	/** Fills OutBodies with every body's state at the start of a frame. @return false if the frame has fallen out of the snapshot history */
+	bool CaptureBodyStates(int32 Frame, TArray<FBulletBodyStateRecord>& OutBodies) const;
+	
+	/** Logs the bodies that differed on the first desync, or every body of Frame when one is given */
+	void DumpDesync(int32 Frame = INDEX_NONE) const;
+	
+	/** Forgets the first desync so the next mismatch is captured */
+	void ResetDesync();
+	
+	const FBulletDesyncCapture& GetFirstDesync() const { return FirstDesync; }
+	
+	/**
+	 * Moves the bullet world's origin to a new UE location. Every body, static object, contact and snapshot is shifted in one go, UE side transforms don't change.
+	 * Call between world steps, e.g. when the area being simulated has moved a long way from the current origin.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Origin")
+	void RebaseWorldOrigin(FVector NewOrigin);
+	
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Origin")
+	FVector GetWorldOrigin() const { return WorldOrigin; }
+	
+	/**
+	 * Casts every ray against the bullet world in one go. OutHits is resized to match Rays and holds the closest hit of each, in the same order.
+	 * Pass the same OutHits every frame to avoid reallocating it.
+	 * @param bParallel	Spread the rays over the task graph workers. Small batches run on the calling thread regardless
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Queries")
+	void RaycastBatch(const TArray<FBulletRaycast>& Rays, TArray<FBulletQueryHit>& OutHits, bool bParallel = true);
+	
+	/** Same as RaycastBatch for swept spheres. Hit locations are the contact points, not where the sphere centre stopped */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Queries")
+	void SphereSweepBatch(const TArray<FBulletSphereSweep>& Sweeps, TArray<FBulletQueryHit>& OutHits, bool bParallel = true);
+	
+	/** Finds everything each sphere touches. OutOverlaps is reset and filled with one entry per touching object, tagged with the index of its sphere */
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Queries")
+	void SphereOverlapBatch(const TArray<FBulletSphereOverlap>& Spheres, TArray<FBulletOverlapResult>& OutOverlaps);
+	
 	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Objects")
 	void AddImpulse(AActor* Target, FVector Impulse, FVector Location);
 
@@ -127,35 +400,218 @@ private:
 	// Static colliders
 	TArray<btCollisionObject*> BtStaticObjects;
 	btCollisionObject* procbody;
-	// Re-usable collision shapes
-	TArray<btBoxShape*> BtBoxCollisionShapes;
-	TArray<btSphereShape*> BtSphereCollisionShapes;
-	TArray<btCapsuleShape*> BtCapsuleCollisionShapes;
+	// Re-usable collision shapes, keyed on their dimensions snapped to the ShapeCacheTolerance grid
+	TMap<FIntVector, btBoxShape*> BtBoxCollisionShapes;
+	TMap<int32, btSphereShape*> BtSphereCollisionShapes;
+	TMap<FIntPoint, btCapsuleShape*> BtCapsuleCollisionShapes;
 	btSequentialImpulseConstraintSolver* mt;
-	// Structure to hold re-usable ConvexHull shapes based on origin BodySetup / subindex / scale
-	struct ConvexHullShapeHolder
+	// Only used by the multithreaded pipeline, the world's solver for islands small enough to be solved one per thread
+	btConstraintSolverPoolMt* BtSolverPool = nullptr;
+	// Set from the world's profile in UBulletPhysicsSettings
+	bool bMultithreadedWorld = false;
+	bool bDeterministicWorld = false;
+	int32 WorldNumThreads = 1;
+	// Key for re-usable ConvexHull shapes based on origin (BodySetup or cooked hulls) / subindex / scale
+	struct FConvexHullShapeKey
 	{
-		UBodySetup* BodySetup;
-		int HullIndex;
-		FVector Scale;
-		btConvexHullShape* Shape;
+		const UObject* Source;
+		int32 HullIndex;
+		FIntVector Scale;
+		
+		bool operator==(const FConvexHullShapeKey& Other) const
+		{
+			return Source == Other.Source && HullIndex == Other.HullIndex && Scale == Other.Scale;
+		}
+		
+		friend uint32 GetTypeHash(const FConvexHullShapeKey& Key)
+		{
+			return HashCombineFast(HashCombineFast(GetTypeHash(Key.Source), GetTypeHash(Key.HullIndex)), GetTypeHash(Key.Scale));
+		}
 	};
-	TArray<ConvexHullShapeHolder> BtConvexHullCollisionShapes;
+	static FConvexHullShapeKey MakeConvexHullShapeKey(const UObject* Source, int32 HullIndex, const FVector& Scale);
+	TMap<FConvexHullShapeKey, btConvexHullShape*> BtConvexHullCollisionShapes;
+	
+	FBulletShapeCacheStats ShapeCacheStats;
+	FBulletCollisionPoolStats ManifoldPoolStats;
+	FBulletCollisionPoolStats AlgorithmPoolStats;
+	
+	// Snaps a length (in UE units) onto the shape cache grid
+	int32 QuantizeShapeDimension(double Value) const;
 	// These shapes are for *potentially* compound rigid body shapes
 	struct CachedDynamicShapeData
 	{
-		FName ClassName; // class name for cache
+		TObjectKey<UClass> Class; // class for cache
+		uint32 GeometryHash; // the owner's collision components, see HashDynamicShapeGeometry
 		btCollisionShape* Shape;
 		bool bIsCompound; // if true, this is a compound shape and so must be deleted
 		btScalar Mass;
 		btVector3 Inertia; // because we like to precalc this
+		int32 RefCount = 0; // number of live bodies using this shape, released when it drops to zero
+	};
+	// Dynamic shapes are shared by (leaf) class, geometry and mass, since the inertia baked into them depends on all of them.
+	// Keyed on the class itself, leaf class names aren't unique across packages. The class alone doesn't pin down the geometry,
+	// instances of the same class can have different meshes or component transforms (every AStaticMeshActor for one)
+	struct FCachedDynamicShapeKey
+	{
+		TObjectKey<UClass> Class;
+		uint32 GeometryHash;
+		int32 MassGrams;
+		
+		bool operator==(const FCachedDynamicShapeKey& Other) const
+		{
+			return Class == Other.Class && GeometryHash == Other.GeometryHash && MassGrams == Other.MassGrams;
+		}
+		
+		friend uint32 GetTypeHash(const FCachedDynamicShapeKey& Key)
+		{
+			return HashCombineFast(HashCombineFast(GetTypeHash(Key.Class), Key.GeometryHash), GetTypeHash(Key.MassGrams));
+		}
 	};
-	TArray<CachedDynamicShapeData> CachedDynamicShapes;
+	TMap<FCachedDynamicShapeKey, CachedDynamicShapeData> CachedDynamicShapes;
+	// The cached shape each dynamic body holds a reference on
+	TMap<const btRigidBody*, FCachedDynamicShapeKey> DynamicBodyShapeKeys;
+	
+	static FCachedDynamicShapeKey MakeDynamicShapeKey(TObjectKey<UClass> Class, uint32 GeometryHash, float Mass);
+	
+	// Hashes what ExtractPhysicsGeometry builds an actor's shape from: each collision component's mesh or shape, and where it sits relative to the actor
+	uint32 HashDynamicShapeGeometry(AActor* Actor) const;
+	
+	void ReleaseCachedDynamicShapeData(const FCachedDynamicShapeKey& Key);
 
+	// Shapes that aren't shared through one of the caches above, owned by the subsystem until it goes away
+	TArray<btCollisionShape*> UncachedShapes;
+	TArray<btStridingMeshInterface*> TriangleMeshes;
+	// Unscaled shapes of cooked complex collision, one per asset
+	TMap<const UBulletCookedTriMesh*, FBulletCookedTriMeshShape> CookedTriMeshShapes;
+	// The cooked shapes read their vertices straight out of these, so they have to stay loaded
+	UPROPERTY()
+	TArray<TObjectPtr<UBulletCookedTriMesh>> CookedTriMeshAssets;
+
+	// Live bodies by pool slot, null for free slots
 	TArray<btRigidBody*> BtRigidBodies;
+	// Bumped every time a slot is freed so handles to the previous body stop resolving
+	TArray<int32> BtRigidBodyGenerations;
+	// Network stable id of each body, the order bodies go into the world hash in and what bodies of different worlds are matched up by.
+	// 0 for bodies that have none
+	TArray<uint32> BtRigidBodyHashKeys;
+	// Slots freed by UnregisterRigidBody, re-used by the next registration
+	TArray<int32> FreeRigidBodyIds;
+	
+	// What we last told the NP layer about each slot's activation
+	struct FRigidBodyActivation
+	{
+		bool bWakeOnContact = true;
+		bool bSleeping = false;
+		// Set while a body that shouldn't be woken by contacts sleeps flagged as a static object
+		bool bPinned = false;
+	};
+	TArray<FRigidBodyActivation> BtRigidBodyActivation;
+	
+	// Pending activation events, sent out with the next step
+	TArray<FBulletActivationEvent> ActivationEvents;
+	
+	void ApplyActivationPolicy(int32 Index, const FBulletActivationPolicy& ActivationPolicy);
+	void SetSleepPinned(int32 Index, bool bPinned);
+	
+	void WakeRigidBodySlot(int32 Index);
+	
+	// Compares every body against what we last reported, queueing events and putting back bodies that were woken by contact when they shouldn't be
+	void UpdateActivationEvents();
+	
+	// Transforms written by the motion states during the step, when bDeferTransformWrites is set
+	FBulletTransformWriteBuffer TransformWriteBuffer;
+	
+	// Owns the traversal scratch of the batched queries
+	FBulletSceneQuery SceneQuery;
+	
+	// Gathers reported contacts after every sub step, turned into events once the whole frame has been stepped
+	FBulletContactStream ContactStream;
+	
+	// Fills in the actor and body handle of a query result from the bullet object it hit
+	void ResolveQueryObject(const btCollisionObject* Object, TObjectPtr<AActor>& OutActor, FBulletBodyHandle& OutBody) const;
+	
+	void ApplyTransformWrites();
+	
+	// Samples the manifold and algorithm pools after a step, warning the first time either runs out
+	void UpdatePoolStats();
+	
+	// Hands the world and its dispatcher the settings bullet would otherwise take from its globals
+	void SetWorldTunables(const FBulletWorldTunables& Tunables);
+	
+	// In place storage for a rigid body and its motion state
+	struct FRigidBodySlot
+	{
+		alignas(16) uint8 BodyStorage[sizeof(btRigidBody)];
+		alignas(16) uint8 MotionStateStorage[sizeof(FBulletMotionState) > sizeof(FBulletUEMotionState) ? sizeof(FBulletMotionState) : sizeof(FBulletUEMotionState)];
+	};
+	static constexpr int32 RigidBodySlotsPerChunk = 64;
+	// Slots are allocated a chunk at a time and chunks are never moved or freed until the world goes away, so bodies keep a stable address
+	TArray<TUniquePtr<FRigidBodySlot[]>> RigidBodySlotChunks;
+	
+	// Finds a free slot, growing the pool by a chunk if there isn't one
+	int32 AllocateRigidBodySlot();
+	
+	FRigidBodySlot& GetRigidBodySlot(int32 Index) const { return RigidBodySlotChunks[Index / RigidBodySlotsPerChunk][Index % RigidBodySlotsPerChunk]; }
+	
+	// Adds a body constructed in its pool slot to the world and publishes it in BtRigidBodies
+	btRigidBody* FinishAddRigidBody(int32 Index, btRigidBody* Body);
+	
+	// Removes a body from the world, destroys it in place and returns its slot to the pool
+	void FreeRigidBody(int32 Index);
 
 	float Accumulator = 0.0f;
 	
+	// The NP frame waiting on a world step, INDEX_NONE if the world is up to date
+	int32 PendingStepFrame = INDEX_NONE;
+	float PendingStepSeconds = 0.0f;
+	
+	// Sims that tick every frame, and how many of them have finished the pending one
+	int32 NumSteppingSims = 0;
+	int32 NumFinishedSims = 0;
+	
+	FDelegateHandle PostActorTickHandle;
+	
+	// Ring buffer of world state indexed by NP frame
+	TArray<FBulletWorldSnapshot> WorldSnapshots;
+	
+	// The frame the world was last rewound to, so the other sims in the same rollback don't restore it again
+	int32 LastRestoredFrame = INDEX_NONE;
+	
+	// Resims check the same frames again, so a mismatch is only counted once per frame
+	int32 LastMismatchFrame = INDEX_NONE;
+	int32 NumMismatches = 0;
+	FBulletDesyncCapture FirstDesync;
+	
+	// Every live body's key and state hash, sorted before being hashed together
+	struct FBodyHashEntry
+	{
+		uint32 Key;
+		uint32 StateHash;
+	};
+	TArray<FBodyHashEntry> StateHashScratch;
+	
+	// Scratch lookups used to match live contact caches with captured ones, kept around so their memory is reused.
+	// A compound pair has a cache per touching child, told apart by the child ids its contacts carry
+	TMap<TTuple<FBulletBodyHandle, FBulletBodyHandle, int32, int32>, int32> ManifoldRestoreLookup;
+	TMultiMap<TTuple<FBulletBodyHandle, FBulletBodyHandle>, int32> ManifoldRestorePairLookup;
+	TArray<bool> ManifoldRestoreUsed;
+	TArray<btPersistentManifold*> ManifoldRestoreLeftovers;
+	// The snapshot's pair objects resolved to what's in the world now, null for those that have since been removed
+	TArray<btCollisionObject*> PairRestoreObjects;
+	
+	// How snapshots name collision objects, see FBulletWorldSnapshot::PairObjects. Unset for objects the subsystem doesn't own
+	FBulletBodyHandle GetSnapshotObjectId(const btCollisionObject* Object) const;
+	btCollisionObject* ResolveSnapshotObjectId(const FBulletBodyHandle& Id) const;
+	
+	// OriginOffset moves the captured contact points from the snapshot's origin to the current one
+	void RestoreManifolds(const FBulletWorldSnapshot& Snapshot, const btVector3& OriginOffset);
+	
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick InLevelTick, float InDeltaSeconds);
+	
+	FDelegateHandle WorldOriginOffsetHandle;
+	
+	void OnWorldOriginOffset(UWorld* InWorld, FIntVector SrcOrigin, FIntVector DstOrigin);
+	
 	// Holds an array of collision object id's for a specific actor.
 	UPROPERTY()
 	TMap<AActor*, FCollisionObjectArray> ParentObjectCollisionMap; 
@@ -173,10 +629,16 @@ public:
 
 	btCollisionShape* GetCapsuleCollisionShape(float Radius, float Height);
 
-	btCollisionShape* GetTriangleMeshShape(TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d);
+	btCollisionShape* GetTriangleMeshShape(const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d);
+
+	// Scaled instance of a cooked mesh's shape. The unscaled shape and its bvh are loaded once per asset and shared
+	btCollisionShape* GetCookedTriMeshShape(UBulletCookedTriMesh* Cooked, const FVector& Scale);
 
 	btCollisionShape* GetConvexHullCollisionShape(UBodySetup* BodySetup, int ConvexIndex, const FVector& Scale);
 
+	// Shares the convex hull cache, keyed on the cooked asset rather than a body setup
+	btCollisionShape* GetCookedConvexHullShape(UBulletCookedConvexHulls* Cooked, int32 HullIndex, const FVector& Scale);
+
 	btRigidBody* AddRigidBody(AActor* Actor, const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& ShapeData, float Friction, float Restitution);
 
 	btRigidBody* AddRigidBody(AActor* Actor, btCollisionShape* CollisionShape, btVector3 Inertia, float Mass, float Friction, float Restitution);
@@ -191,14 +653,18 @@ private:
 
 	void SetupStaticGeometryPhysics(TArray<AActor*> Actors, float Friction, float Restitution);
 
-	void ExtractPhysicsGeometry(AActor* Actor, PhysicsGeometryCallback CB);
+	// bComplexCollision lets static meshes hand out their cooked triangle mesh, only static bodies can use one
+	void ExtractPhysicsGeometry(AActor* Actor, PhysicsGeometryCallback CB, bool bComplexCollision = false);
 
 	btCollisionObject* AddStaticCollision(btCollisionShape* Shape, const FTransform& Transform, float Friction, float Restitution, AActor* Actor);
 
-	void ExtractPhysicsGeometry(UStaticMeshComponent* SMC, const FTransform& InvActorXform, PhysicsGeometryCallback CB);
+	void ExtractPhysicsGeometry(UStaticMeshComponent* SMC, const FTransform& InvActorXform, PhysicsGeometryCallback CB, bool bComplexCollision);
 
 	void ExtractPhysicsGeometry(UShapeComponent* Sc, const FTransform& InvActorXform, PhysicsGeometryCallback CB);
 
+	// One heightfield per landscape collision component, sharing the landscape's own height data
+	void ExtractPhysicsGeometry(ULandscapeHeightfieldCollisionComponent* Lc, const FTransform& InvActorXform, PhysicsGeometryCallback CB);
+
 	void ExtractPhysicsGeometry(const FTransform& XformSoFar, UBodySetup* BodySetup, PhysicsGeometryCallback CB);
 
 	const UBulletPhysicsWorldSubsystem::CachedDynamicShapeData& GetCachedDynamicShapeData(AActor* Actor, float Mass);
@@ -0,0 +1,1134 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// The stress scenes of bullet3/examples/Benchmarks/BenchmarkDemo.cpp without the example browser.
+// Worlds come from FBulletWorldParts, the same construction UBulletPhysicsWorldSubsystem::Initialize uses, and every run prints
+// one JSON object per scene: step times, the inclusive time of each bullet profile zone on the stepping thread, and pair, manifold and contact counts.
+//
+//   BulletHeadlessBenchmark [--scene 1..8|all] [--steps N] [--warmup N] [--threads N] [--manifold-pool N] [--algorithm-pool N] [--deterministic] [--verify-determinism] [--csv File]
+//
+// --threads 0 (the default) builds the single threaded world, anything else the Mt world on bullet's default task scheduler.
+// --manifold-pool and --algorithm-pool size the collision configuration's pools like the world profile's MaxPersistentManifolds
+// and MaxCollisionAlgorithms, the pools' peaks and overflow show whether a size holds a scene.
+// --deterministic steps the world in the world profile's deterministic mode, to see what it costs.
+// --verify-determinism (implies --deterministic) snapshots the world after the warmup the way the subsystem does for a rollback, puts it back
+// once the timed steps are done and steps them again, comparing the world hash after every step. Exits with 2 when any scene diverged.
+// --csv writes one row per step and scene, for plotting or diffing two runs.
+
+#include "Core/Simulation/BulletDynamicsWorld.h"
+
+#include "LinearMath/btThreads.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "TaruData.h"
+#include "HaltonData.h"
+#include "landscapeData.h"
+
+namespace
+{
+	using FClock = std::chrono::steady_clock;
+
+	double MillisecondsSince(FClock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Profile zones
+	// ---------------------------------------------------------------------------------------------
+
+	// Only zones entered on the thread that steps the world are timed, parallel-for bodies on the workers would count the same wall time again
+	thread_local bool bIsSteppingThread = false;
+
+	constexpr int MaxZoneDepth = 64;
+	thread_local int ZoneDepth = 0;
+	thread_local FClock::time_point ZoneStarts[MaxZoneDepth];
+	thread_local const char* ZoneNames[MaxZoneDepth];
+
+	// Keyed on the literal bullet passes in, merged by name when reporting
+	std::map<const char*, double> StepZoneMs;
+
+	void EnterZone(const char* Name)
+	{
+		if (!bIsSteppingThread) return;
+		if (ZoneDepth < MaxZoneDepth)
+		{
+			ZoneNames[ZoneDepth] = Name;
+			ZoneStarts[ZoneDepth] = FClock::now();
+		}
+		++ZoneDepth;
+	}
+
+	void LeaveZone()
+	{
+		if (!bIsSteppingThread || ZoneDepth == 0) return;
+		--ZoneDepth;
+		if (ZoneDepth < MaxZoneDepth)
+		{
+			StepZoneMs[ZoneNames[ZoneDepth]] += MillisecondsSince(ZoneStarts[ZoneDepth]);
+		}
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Scenes
+	// ---------------------------------------------------------------------------------------------
+
+	constexpr int NumRays = 500;
+
+	/** What a scene put in the world, so it can be taken out again */
+	struct FBenchmarkScene
+	{
+		btDiscreteDynamicsWorld* World = nullptr;
+		std::vector<btCollisionShape*> Shapes;
+		std::vector<btStridingMeshInterface*> Meshes;
+
+		// Scene 7 sweeps a fan of rays across the landscape every step
+		bool bCastRays = false;
+		btVector3 RaySource[NumRays];
+		btVector3 RayDest[NumRays];
+		btScalar RayDirection = 1;
+
+		template <typename ShapeType>
+		ShapeType* AddShape(ShapeType* Shape)
+		{
+			Shapes.push_back(Shape);
+			return Shape;
+		}
+
+		btRigidBody* CreateRigidBody(btScalar Mass, const btTransform& Transform, btCollisionShape* Shape)
+		{
+			btVector3 LocalInertia(0, 0, 0);
+			if (Mass != 0)
+			{
+				Shape->calculateLocalInertia(Mass, LocalInertia);
+			}
+
+			btRigidBody* Body = new btRigidBody(btRigidBody::btRigidBodyConstructionInfo(Mass, new btDefaultMotionState(Transform), Shape, LocalInertia));
+			World->addRigidBody(Body);
+			return Body;
+		}
+
+		void Clear()
+		{
+			for (int i = World->getNumConstraints() - 1; i >= 0; i--)
+			{
+				btTypedConstraint* Constraint = World->getConstraint(i);
+				World->removeConstraint(Constraint);
+				delete Constraint;
+			}
+			for (int i = World->getNumCollisionObjects() - 1; i >= 0; i--)
+			{
+				btCollisionObject* Obj = World->getCollisionObjectArray()[i];
+				if (btRigidBody* Body = btRigidBody::upcast(Obj))
+				{
+					delete Body->getMotionState();
+				}
+				World->removeCollisionObject(Obj);
+				delete Obj;
+			}
+			for (btCollisionShape* Shape : Shapes) { delete Shape; }
+			for (btStridingMeshInterface* Mesh : Meshes) { delete Mesh; }
+			Shapes.clear();
+			Meshes.clear();
+		}
+	};
+
+	btBoxShape* CreateBlockShape(FBenchmarkScene& Scene, const btVector3& BoxSize)
+	{
+		return Scene.AddShape(new btBoxShape(BoxSize));
+	}
+
+	// 47 layers of 8x8 cubes, 3008 in all
+	void CreateTest1(FBenchmarkScene& Scene)
+	{
+		const int Size = 8;
+		const btScalar CubeSize = 1;
+		const btScalar Spacing = CubeSize;
+		btVector3 Pos(0, CubeSize * 2, 0);
+		btScalar Offset = -Size * (CubeSize * 2 + Spacing) * btScalar(0.5);
+
+		btBoxShape* BlockShape = CreateBlockShape(Scene, btVector3(CubeSize, CubeSize, CubeSize));
+		btTransform Trans = btTransform::getIdentity();
+
+		for (int k = 0; k < 47; k++)
+		{
+			for (int j = 0; j < Size; j++)
+			{
+				Pos[2] = Offset + j * (CubeSize * 2 + Spacing);
+				for (int i = 0; i < Size; i++)
+				{
+					Pos[0] = Offset + i * (CubeSize * 2 + Spacing);
+					Trans.setOrigin(Pos);
+					Scene.CreateRigidBody(2, Trans, BlockShape);
+				}
+			}
+			Offset -= btScalar(0.05) * Spacing * (Size - 1);
+			Pos[1] += CubeSize * 2 + Spacing;
+		}
+	}
+
+	void CreateWall(FBenchmarkScene& Scene, const btVector3& OffsetPosition, int StackSize, const btVector3& BoxSize)
+	{
+		btBoxShape* BlockShape = CreateBlockShape(Scene, BoxSize);
+
+		const btScalar DiffY = BoxSize[1];
+		const btScalar DiffZ = BoxSize[2];
+		btScalar Offset = -StackSize * (DiffZ * 2) * btScalar(0.5);
+		btVector3 Pos(0, DiffY, 0);
+		btTransform Trans = btTransform::getIdentity();
+
+		while (StackSize)
+		{
+			for (int i = 0; i < StackSize; i++)
+			{
+				Pos[2] = Offset + i * (DiffZ * 2);
+				Trans.setOrigin(OffsetPosition + Pos);
+				Scene.CreateRigidBody(1, Trans, BlockShape);
+			}
+			Offset += DiffZ;
+			Pos[1] += DiffY * 2;
+			StackSize--;
+		}
+	}
+
+	void CreatePyramid(FBenchmarkScene& Scene, const btVector3& OffsetPosition, int StackSize, const btVector3& BoxSize)
+	{
+		const btScalar Space = btScalar(0.0001);
+		btVector3 Pos(0, BoxSize[1], 0);
+		btBoxShape* BlockShape = CreateBlockShape(Scene, BoxSize);
+		btTransform Trans = btTransform::getIdentity();
+
+		const btScalar DiffX = BoxSize[0] * btScalar(1.02);
+		const btScalar DiffY = BoxSize[1] * btScalar(1.02);
+		const btScalar DiffZ = BoxSize[2] * btScalar(1.02);
+		btScalar OffsetX = -StackSize * (DiffX * 2 + Space) * btScalar(0.5);
+		btScalar OffsetZ = -StackSize * (DiffZ * 2 + Space) * btScalar(0.5);
+
+		while (StackSize)
+		{
+			for (int j = 0; j < StackSize; j++)
+			{
+				Pos[2] = OffsetZ + j * (DiffZ * 2 + Space);
+				for (int i = 0; i < StackSize; i++)
+				{
+					Pos[0] = OffsetX + i * (DiffX * 2 + Space);
+					Trans.setOrigin(OffsetPosition + Pos);
+					Scene.CreateRigidBody(1, Trans, BlockShape);
+				}
+			}
+			OffsetX += DiffX;
+			OffsetZ += DiffZ;
+			Pos[1] += DiffY * 2 + Space;
+			StackSize--;
+		}
+	}
+
+	void CreateTowerCircle(FBenchmarkScene& Scene, const btVector3& OffsetPosition, int StackSize, int RotSize, const btVector3& BoxSize)
+	{
+		btBoxShape* BlockShape = CreateBlockShape(Scene, BoxSize);
+		btTransform Trans = btTransform::getIdentity();
+
+		const btScalar Radius = btScalar(1.3) * RotSize * BoxSize[0] / SIMD_PI;
+		btQuaternion RotY(0, 1, 0, 0);
+		btScalar PosY = BoxSize[1];
+
+		for (int i = 0; i < StackSize; i++)
+		{
+			for (int j = 0; j < RotSize; j++)
+			{
+				Trans.setOrigin(OffsetPosition + quatRotate(RotY, btVector3(0, PosY, Radius)));
+				Trans.setRotation(RotY);
+				Scene.CreateRigidBody(1, Trans, BlockShape);
+
+				RotY *= btQuaternion(btVector3(0, 1, 0), SIMD_PI / (RotSize * btScalar(0.5)));
+			}
+			PosY += BoxSize[1] * 2;
+			RotY *= btQuaternion(btVector3(0, 1, 0), SIMD_PI / RotSize);
+		}
+	}
+
+	// A pyramid, three walls and a circular tower
+	void CreateTest2(FBenchmarkScene& Scene)
+	{
+		const btVector3 CubeSize(1, 1, 1);
+		CreatePyramid(Scene, btVector3(-20, 0, 0), 12, CubeSize);
+		CreateWall(Scene, btVector3(-2, 0, 0), 12, CubeSize);
+		CreateWall(Scene, btVector3(4, 0, 0), 12, CubeSize);
+		CreateWall(Scene, btVector3(10, 0, 0), 12, CubeSize);
+		CreateTowerCircle(Scene, btVector3(25, 0, 0), 8, 24, CubeSize);
+	}
+
+	// Same ragdoll as the demo's, its body parts and joints as tables
+	struct FRagdollPart
+	{
+		btScalar Radius, Height;
+		btScalar X, Y;
+		btScalar RollZ;
+	};
+
+	const FRagdollPart RagdollParts[] = {
+		{btScalar(0.15), btScalar(0.20), btScalar(0.), btScalar(1.), 0},           // Pelvis
+		{btScalar(0.15), btScalar(0.28), btScalar(0.), btScalar(1.2), 0},          // Spine
+		{btScalar(0.10), btScalar(0.05), btScalar(0.), btScalar(1.6), 0},          // Head
+		{btScalar(0.07), btScalar(0.45), btScalar(-0.18), btScalar(0.65), 0},      // Left upper leg
+		{btScalar(0.05), btScalar(0.37), btScalar(-0.18), btScalar(0.2), 0},       // Left lower leg
+		{btScalar(0.07), btScalar(0.45), btScalar(0.18), btScalar(0.65), 0},       // Right upper leg
+		{btScalar(0.05), btScalar(0.37), btScalar(0.18), btScalar(0.2), 0},        // Right lower leg
+		{btScalar(0.05), btScalar(0.33), btScalar(-0.35), btScalar(1.45), SIMD_HALF_PI},   // Left upper arm
+		{btScalar(0.04), btScalar(0.25), btScalar(-0.7), btScalar(1.45), SIMD_HALF_PI},    // Left lower arm
+		{btScalar(0.05), btScalar(0.33), btScalar(0.35), btScalar(1.45), -SIMD_HALF_PI},   // Right upper arm
+		{btScalar(0.04), btScalar(0.25), btScalar(0.7), btScalar(1.45), -SIMD_HALF_PI},    // Right lower arm
+	};
+
+	struct FRagdollJoint
+	{
+		bool bHinge;
+		int PartA, PartB;
+		btScalar EulerA[3];
+		btScalar OriginA[2];
+		btScalar EulerB[3];
+		btScalar OriginB[2];
+		btScalar Limits[3];
+	};
+
+	const btScalar QuarterPi = SIMD_PI * btScalar(0.25);
+
+	const FRagdollJoint RagdollJoints[] = {
+		{true, 0, 1, {0, SIMD_HALF_PI, 0}, {0, btScalar(0.15)}, {0, SIMD_HALF_PI, 0}, {0, btScalar(-0.15)}, {-QuarterPi, SIMD_HALF_PI, 0}},
+		{false, 1, 2, {0, 0, SIMD_HALF_PI}, {0, btScalar(0.30)}, {0, 0, SIMD_HALF_PI}, {0, btScalar(-0.14)}, {QuarterPi, QuarterPi, SIMD_HALF_PI}},
+		{false, 0, 3, {0, 0, -QuarterPi * 5}, {btScalar(-0.18), btScalar(-0.10)}, {0, 0, -QuarterPi * 5}, {0, btScalar(0.225)}, {QuarterPi, QuarterPi, 0}},
+		{true, 3, 4, {0, SIMD_HALF_PI, 0}, {0, btScalar(-0.225)}, {0, SIMD_HALF_PI, 0}, {0, btScalar(0.185)}, {0, SIMD_HALF_PI, 0}},
+		{false, 0, 5, {0, 0, QuarterPi}, {btScalar(0.18), btScalar(-0.10)}, {0, 0, QuarterPi}, {0, btScalar(0.225)}, {QuarterPi, QuarterPi, 0}},
+		{true, 5, 6, {0, SIMD_HALF_PI, 0}, {0, btScalar(-0.225)}, {0, SIMD_HALF_PI, 0}, {0, btScalar(0.185)}, {0, SIMD_HALF_PI, 0}},
+		{false, 1, 7, {0, 0, SIMD_PI}, {btScalar(-0.2), btScalar(0.15)}, {0, 0, SIMD_HALF_PI}, {0, btScalar(-0.18)}, {SIMD_HALF_PI, SIMD_HALF_PI, 0}},
+		{true, 7, 8, {0, SIMD_HALF_PI, 0}, {0, btScalar(0.18)}, {0, SIMD_HALF_PI, 0}, {0, btScalar(-0.14)}, {-SIMD_HALF_PI, 0, 0}},
+		{false, 1, 9, {0, 0, 0}, {btScalar(0.2), btScalar(0.15)}, {0, 0, SIMD_HALF_PI}, {0, btScalar(-0.18)}, {SIMD_HALF_PI, SIMD_HALF_PI, 0}},
+		{true, 9, 10, {0, SIMD_HALF_PI, 0}, {0, btScalar(0.18)}, {0, SIMD_HALF_PI, 0}, {0, btScalar(-0.14)}, {-SIMD_HALF_PI, 0, 0}},
+	};
+
+	constexpr int NumRagdollParts = sizeof(RagdollParts) / sizeof(RagdollParts[0]);
+
+	void CreateRagdoll(FBenchmarkScene& Scene, const btVector3& PositionOffset, btScalar Scale)
+	{
+		btRigidBody* Bodies[NumRagdollParts];
+		for (int i = 0; i < NumRagdollParts; i++)
+		{
+			const FRagdollPart& Part = RagdollParts[i];
+			btCapsuleShape* Shape = Scene.AddShape(new btCapsuleShape(Part.Radius * Scale, Part.Height * Scale));
+
+			btTransform Transform = btTransform::getIdentity();
+			Transform.setOrigin(PositionOffset + Scale * btVector3(Part.X, Part.Y, 0));
+			Transform.getBasis().setEulerZYX(0, 0, Part.RollZ);
+			Bodies[i] = Scene.CreateRigidBody(1, Transform, Shape);
+			Bodies[i]->setDamping(btScalar(0.05), btScalar(0.85));
+			Bodies[i]->setDeactivationTime(btScalar(0.8));
+			Bodies[i]->setSleepingThresholds(btScalar(1.6), btScalar(2.5));
+		}
+
+		for (const FRagdollJoint& Joint : RagdollJoints)
+		{
+			btTransform LocalA = btTransform::getIdentity();
+			btTransform LocalB = btTransform::getIdentity();
+			LocalA.getBasis().setEulerZYX(Joint.EulerA[0], Joint.EulerA[1], Joint.EulerA[2]);
+			LocalA.setOrigin(Scale * btVector3(Joint.OriginA[0], Joint.OriginA[1], 0));
+			LocalB.getBasis().setEulerZYX(Joint.EulerB[0], Joint.EulerB[1], Joint.EulerB[2]);
+			LocalB.setOrigin(Scale * btVector3(Joint.OriginB[0], Joint.OriginB[1], 0));
+
+			btTypedConstraint* Constraint;
+			if (Joint.bHinge)
+			{
+				btHingeConstraint* Hinge = new btHingeConstraint(*Bodies[Joint.PartA], *Bodies[Joint.PartB], LocalA, LocalB);
+				Hinge->setLimit(Joint.Limits[0], Joint.Limits[1]);
+				Constraint = Hinge;
+			}
+			else
+			{
+				btConeTwistConstraint* Cone = new btConeTwistConstraint(*Bodies[Joint.PartA], *Bodies[Joint.PartB], LocalA, LocalB);
+				Cone->setLimit(Joint.Limits[0], Joint.Limits[1], Joint.Limits[2]);
+				Constraint = Cone;
+			}
+			Scene.World->addConstraint(Constraint, true);
+		}
+	}
+
+	// A pyramid of 136 ragdolls
+	void CreateTest3(FBenchmarkScene& Scene)
+	{
+		int Size = 16;
+		const btScalar SizeX = 1;
+		const btScalar SizeY = 1;
+		btVector3 Pos(0, SizeY, 0);
+
+		while (Size)
+		{
+			const btScalar Offset = -Size * (SizeX * 6) * btScalar(0.5);
+			for (int i = 0; i < Size; i++)
+			{
+				Pos[0] = Offset + i * (SizeX * 6);
+				CreateRagdoll(Scene, Pos, btScalar(3.5));
+			}
+			Pos[1] += SizeY * 7;
+			Pos[2] -= SizeX * 2;
+			Size--;
+		}
+	}
+
+	btConvexHullShape* CreateTaruShape(FBenchmarkScene& Scene)
+	{
+		btConvexHullShape* Shape = Scene.AddShape(new btConvexHullShape());
+		for (int i = 0; i < TaruVtxCount; i++)
+		{
+			Shape->addPoint(btVector3(TaruVtx[i * 3], TaruVtx[i * 3 + 1], TaruVtx[i * 3 + 2]));
+		}
+		return Shape;
+	}
+
+	// 15 layers of 8x8 convex hulls with polyhedral contact clipping
+	void CreateTest4(FBenchmarkScene& Scene)
+	{
+		const int Size = 8;
+		const btScalar CubeSize = btScalar(1.5);
+		btScalar Spacing = CubeSize;
+		btVector3 Pos(0, CubeSize * 2, 0);
+		btScalar Offset = -Size * (CubeSize * 2 + Spacing) * btScalar(0.5);
+
+		btConvexHullShape* HullShape = CreateTaruShape(Scene);
+		HullShape->initializePolyhedralFeatures();
+		btTransform Trans = btTransform::getIdentity();
+
+		for (int k = 0; k < 15; k++)
+		{
+			for (int j = 0; j < Size; j++)
+			{
+				Pos[2] = Offset + j * (CubeSize * 2 + Spacing);
+				for (int i = 0; i < Size; i++)
+				{
+					Pos[0] = Offset + i * (CubeSize * 2 + Spacing);
+					Trans.setOrigin(Pos);
+					Scene.CreateRigidBody(1, Trans, HullShape);
+				}
+			}
+			Offset -= btScalar(0.05) * Spacing * (Size - 1);
+			Spacing *= btScalar(1.01);
+			Pos[1] += CubeSize * 2 + Spacing;
+		}
+	}
+
+	// The eight landscape tiles as static triangle meshes
+	void CreateLargeMeshBody(FBenchmarkScene& Scene)
+	{
+		const int VtxCounts[] = {Landscape01VtxCount, Landscape02VtxCount, Landscape03VtxCount, Landscape04VtxCount, Landscape05VtxCount, Landscape06VtxCount, Landscape07VtxCount, Landscape08VtxCount};
+		const int IdxCounts[] = {Landscape01IdxCount, Landscape02IdxCount, Landscape03IdxCount, Landscape04IdxCount, Landscape05IdxCount, Landscape06IdxCount, Landscape07IdxCount, Landscape08IdxCount};
+		btScalar* const Vtx[] = {Landscape01Vtx, Landscape02Vtx, Landscape03Vtx, Landscape04Vtx, Landscape05Vtx, Landscape06Vtx, Landscape07Vtx, Landscape08Vtx};
+		unsigned short* const Idx[] = {Landscape01Idx, Landscape02Idx, Landscape03Idx, Landscape04Idx, Landscape05Idx, Landscape06Idx, Landscape07Idx, Landscape08Idx};
+
+		btTransform Trans = btTransform::getIdentity();
+		Trans.setOrigin(btVector3(0, -25, 0));
+
+		for (int i = 0; i < 8; i++)
+		{
+			btIndexedMesh Part;
+			Part.m_vertexBase = reinterpret_cast<const unsigned char*>(Vtx[i]);
+			Part.m_vertexStride = sizeof(btScalar) * 3;
+			Part.m_numVertices = VtxCounts[i];
+			Part.m_triangleIndexBase = reinterpret_cast<const unsigned char*>(Idx[i]);
+			Part.m_triangleIndexStride = sizeof(short) * 3;
+			Part.m_numTriangles = IdxCounts[i] / 3;
+			Part.m_indexType = PHY_SHORT;
+
+			btTriangleIndexVertexArray* MeshInterface = new btTriangleIndexVertexArray();
+			MeshInterface->addIndexedMesh(Part, PHY_SHORT);
+			Scene.Meshes.push_back(MeshInterface);
+
+			btRigidBody* Body = Scene.CreateRigidBody(0, Trans, Scene.AddShape(new btBvhTriangleMeshShape(MeshInterface, true)));
+			Body->setFriction(btScalar(0.9));
+		}
+	}
+
+	// Fills a 10x10x10 grid over the landscape with whatever NewShape hands out
+	template <typename ShapeFactory>
+	void CreateLandscapeDrop(FBenchmarkScene& Scene, ShapeFactory&& NewShape)
+	{
+		const int Size = 10;
+		const int Height = 10;
+		const btScalar CubeSize = btScalar(1.5);
+		btScalar Spacing = 2;
+		btVector3 Pos(0, 20, 0);
+		btScalar Offset = -Size * (CubeSize * 2 + Spacing) * btScalar(0.5);
+		btTransform Trans = btTransform::getIdentity();
+
+		for (int k = 0; k < Height; k++)
+		{
+			for (int j = 0; j < Size; j++)
+			{
+				Pos[2] = Offset + j * (CubeSize * 2 + Spacing);
+				for (int i = 0; i < Size; i++)
+				{
+					Pos[0] = Offset + i * (CubeSize * 2 + Spacing);
+					Trans.setOrigin(btVector3(0, 25, 0) + btVector3(5, 1, 5) * Pos);
+					btScalar Mass = 1;
+					btCollisionShape* Shape = NewShape(Mass);
+					Scene.CreateRigidBody(Mass, Trans, Shape);
+				}
+			}
+			Offset -= btScalar(0.05) * Spacing * (Size - 1);
+			Spacing *= btScalar(1.1);
+			Pos[1] += CubeSize * 2 + Spacing;
+		}
+
+		CreateLargeMeshBody(Scene);
+	}
+
+	// A thousand boxes, spheres and capsules of three sizes over the landscape
+	void CreateTest5(FBenchmarkScene& Scene)
+	{
+		// The demo relied on rand's default seed, runs of every scene should see the same mix
+		srand(1);
+		CreateLandscapeDrop(Scene, [&Scene](btScalar& Mass) -> btCollisionShape*
+		{
+			const int Index = rand() % 9;
+			const btScalar R = btScalar(0.5) * (Index % 3 + 1);
+			Mass = R;
+			if (Index < 3) return Scene.AddShape(new btBoxShape(btVector3(1.5, 1.5, 1.5) * R));
+			if (Index < 6) return Scene.AddShape(new btSphereShape(btScalar(1.5) * R));
+			return Scene.AddShape(new btCapsuleShape(R, 2 * R));
+		});
+	}
+
+	// A thousand convex hulls over the landscape
+	void CreateTest6(FBenchmarkScene& Scene)
+	{
+		btConvexHullShape* HullShape = CreateTaruShape(Scene);
+		CreateLandscapeDrop(Scene, [HullShape](btScalar&) -> btCollisionShape* { return HullShape; });
+	}
+
+	// Test 6 with 500 rays swept across it every step
+	void CreateTest7(FBenchmarkScene& Scene)
+	{
+		CreateTest6(Scene);
+
+		Scene.bCastRays = true;
+		const btScalar RayLength = 2500;
+		const btScalar MaxY = 50;
+		for (int i = 0; i < NumRays; i++)
+		{
+			const btQuaternion Q(btVector3(0, 1, 0), 2 * SIMD_2_PI / NumRays * i);
+			Scene.RaySource[i] = btVector3(0, MaxY, 0);
+			Scene.RayDest[i] = Scene.RaySource[i] + quatRotate(Q, btVector3(1, 0, 0)) * RayLength;
+			Scene.RayDest[i][1] = -1000;
+		}
+	}
+
+	// The demo's ray bar, moved and cast through btParallelFor so the Mt world spreads it over the workers
+	struct FCastRaysLoop : public btIParallelForBody
+	{
+		FBenchmarkScene* Scene;
+
+		virtual void forLoop(int Begin, int End) const override
+		{
+			for (int i = Begin; i < End; i++)
+			{
+				btCollisionWorld::ClosestRayResultCallback Callback(Scene->RaySource[i], Scene->RayDest[i]);
+				Scene->World->rayTest(Scene->RaySource[i], Scene->RayDest[i], Callback);
+			}
+		}
+	};
+
+	void CastRays(FBenchmarkScene& Scene, btScalar TimeStep)
+	{
+		BT_PROFILE("castRays");
+
+		const btScalar Dx = 10;
+		for (int i = 0; i < NumRays; i++)
+		{
+			Scene.RaySource[i][0] += Dx * TimeStep * Scene.RayDirection;
+			Scene.RayDest[i][0] += Dx * TimeStep * Scene.RayDirection;
+		}
+		if (Scene.RaySource[0][0] < 0) Scene.RayDirection = 1;
+		else if (Scene.RaySource[0][0] > 0) Scene.RayDirection = -1;
+
+		FCastRaysLoop Loop;
+		Loop.Scene = &Scene;
+		btParallelFor(0, NumRays, 20, Loop);
+	}
+
+	// Voronoi fracture pieces dropped onto a plane, with the demo's stiffer solver settings
+	void CreateTest8(FBenchmarkScene& Scene)
+	{
+		const btScalar FallHeight = btScalar(3.5);
+		for (int i = 0; i < halton_numc; i++)
+		{
+			btConvexHullShape* Shape = Scene.AddShape(new btConvexHullShape());
+			const float* Verts = halton_verts[i];
+			for (int v = 0; v < halton_numv[i]; v++, Verts += 3)
+			{
+				Shape->addPoint(btVector3(Verts[0], Verts[1], Verts[2]));
+			}
+			Shape->initializePolyhedralFeatures();
+			Shape->setMargin(btScalar(0.04));
+
+			const float* Origin = halton_pos[i];
+			btTransform Transform = btTransform::getIdentity();
+			Transform.setOrigin(btVector3(Origin[0], Origin[1] + FallHeight, Origin[2]));
+			Scene.CreateRigidBody(halton_volu[i], Transform, Shape)->setFriction(btScalar(0.6));
+		}
+
+		btContactSolverInfo& SolverInfo = Scene.World->getSolverInfo();
+		SolverInfo.m_numIterations = 20;
+		SolverInfo.m_erp = btScalar(0.8);
+		SolverInfo.m_erp2 = SolverInfo.m_erp / 2;
+		SolverInfo.m_globalCfm = btScalar(0.015);
+
+		btStaticPlaneShape* GroundPlane = Scene.AddShape(new btStaticPlaneShape(btVector3(0, 1, 0), 0));
+		GroundPlane->setMargin(btScalar(0.04));
+		Scene.CreateRigidBody(0, btTransform::getIdentity(), GroundPlane);
+	}
+
+	struct FSceneInfo
+	{
+		const char* Name;
+		void (*Create)(FBenchmarkScene&);
+		// Scenes 5 and up bring their own ground
+		bool bGroundBox;
+	};
+
+	const FSceneInfo Scenes[] = {
+		{"3000 boxes", CreateTest1, true},
+		{"1000 stacked boxes", CreateTest2, true},
+		{"136 ragdolls", CreateTest3, true},
+		{"1000 convex", CreateTest4, true},
+		{"prim vs mesh", CreateTest5, false},
+		{"convex vs mesh", CreateTest6, false},
+		{"raytests", CreateTest7, false},
+		{"voronoi fracture", CreateTest8, false},
+	};
+
+	constexpr int NumScenes = sizeof(Scenes) / sizeof(Scenes[0]);
+
+	// ---------------------------------------------------------------------------------------------
+	// Running
+	// ---------------------------------------------------------------------------------------------
+
+	struct FBenchmarkOptions
+	{
+		int Scene = 0;
+		int Steps = 600;
+		int WarmupSteps = 0;
+		int NumThreads = 0;
+		int ManifoldPoolSize = 4096;
+		int AlgorithmPoolSize = 4096;
+		bool bDeterministic = false;
+		bool bVerifyDeterminism = false;
+		const char* CsvPath = nullptr;
+	};
+
+	struct FStepSample
+	{
+		double Ms;
+		int Pairs;
+		int Manifolds;
+		int Contacts;
+		int ActiveBodies;
+		FBulletPoolCounts ManifoldPool;
+		FBulletPoolCounts AlgorithmPool;
+	};
+
+	FStepSample SampleWorld(btDiscreteDynamicsWorld* World, bool bMultithreaded)
+	{
+		FStepSample Sample = {};
+		Sample.Pairs = World->getBroadphase()->getOverlappingPairCache()->getNumOverlappingPairs();
+		btDispatcher* Dispatcher = World->getDispatcher();
+		Sample.Manifolds = Dispatcher->getNumManifolds();
+		for (int i = 0; i < Sample.Manifolds; i++)
+		{
+			Sample.Contacts += Dispatcher->getManifoldByIndexInternal(i)->getNumContacts();
+		}
+		const btCollisionObjectArray& Objects = World->getCollisionObjectArray();
+		for (int i = 0; i < Objects.size(); i++)
+		{
+			Sample.ActiveBodies += Objects[i]->isActive() && !Objects[i]->isStaticOrKinematicObject() ? 1 : 0;
+		}
+		Sample.ManifoldPool = FBulletWorldParts::GetManifoldPoolCounts(World);
+		Sample.AlgorithmPool = FBulletWorldParts::GetAlgorithmPoolCounts(World, bMultithreaded);
+		return Sample;
+	}
+
+	// ---------------------------------------------------------------------------------------------
+	// Determinism check
+	// ---------------------------------------------------------------------------------------------
+
+	// What UBulletPhysicsWorldSubsystem::RecordWorldSnapshot keeps of a deterministic world. Objects are never added or removed while a scene
+	// runs, so their index in the world's object array names them
+	struct FWorldSnapshot
+	{
+		struct FBody
+		{
+			btTransform WorldTransform;
+			btVector3 LinearVelocity;
+			btVector3 AngularVelocity;
+			btVector3 TotalForce;
+			btVector3 TotalTorque;
+			btScalar DeactivationTime;
+			int ActivationState;
+		};
+
+		struct FManifold
+		{
+			int Body0;
+			int Body1;
+			int FirstPoint;
+			int NumContacts;
+		};
+
+		btScalar LocalTime = 0;
+		std::vector<FBody> Bodies;
+		std::vector<FManifold> Manifolds;
+		std::vector<btManifoldPoint> ManifoldPoints;
+		std::vector<int> PairObjects;
+	};
+
+	int GetObjectIndex(const btCollisionObject* Obj)
+	{
+		return Obj->getWorldArrayIndex();
+	}
+
+	void RecordWorldSnapshot(btDiscreteDynamicsWorld* World, bool bMultithreaded, FWorldSnapshot& Snapshot)
+	{
+		Snapshot.LocalTime = FBulletWorldParts::VisitWorld(World, bMultithreaded, [](auto& W) { return W.GetLocalTime(); });
+
+		const btCollisionObjectArray& Objects = World->getCollisionObjectArray();
+		Snapshot.Bodies.resize(Objects.size());
+		for (int i = 0; i < Objects.size(); i++)
+		{
+			const btRigidBody* Body = btRigidBody::upcast(Objects[i]);
+			if (!Body) continue;
+
+			FWorldSnapshot::FBody& BodySnapshot = Snapshot.Bodies[i];
+			BodySnapshot.WorldTransform = Body->getWorldTransform();
+			BodySnapshot.LinearVelocity = Body->getLinearVelocity();
+			BodySnapshot.AngularVelocity = Body->getAngularVelocity();
+			BodySnapshot.TotalForce = Body->getTotalForce();
+			BodySnapshot.TotalTorque = Body->getTotalTorque();
+			BodySnapshot.DeactivationTime = Body->getDeactivationTime();
+			BodySnapshot.ActivationState = Body->getActivationState();
+		}
+
+		btDispatcher* Dispatcher = World->getDispatcher();
+		Snapshot.Manifolds.clear();
+		Snapshot.ManifoldPoints.clear();
+		for (int i = 0; i < Dispatcher->getNumManifolds(); i++)
+		{
+			const btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+			Snapshot.Manifolds.push_back({GetObjectIndex(Manifold->getBody0()), GetObjectIndex(Manifold->getBody1()), (int)Snapshot.ManifoldPoints.size(), Manifold->getNumContacts()});
+			for (int p = 0; p < Manifold->getNumContacts(); p++)
+			{
+				Snapshot.ManifoldPoints.push_back(Manifold->getContactPoint(p));
+			}
+		}
+
+		const btBroadphasePairArray& Pairs = World->getPairCache()->getOverlappingPairArray();
+		Snapshot.PairObjects.resize(Pairs.size() * 2);
+		for (int i = 0; i < Pairs.size(); i++)
+		{
+			Snapshot.PairObjects[i * 2] = GetObjectIndex(static_cast<const btCollisionObject*>(Pairs[i].m_pProxy0->m_clientObject));
+			Snapshot.PairObjects[i * 2 + 1] = GetObjectIndex(static_cast<const btCollisionObject*>(Pairs[i].m_pProxy1->m_clientObject));
+		}
+	}
+
+	// Same order of operations as UBulletPhysicsWorldSubsystem::RestoreWorldSnapshot: bodies, step time, pairs, then contacts
+	void RestoreWorldSnapshot(btDiscreteDynamicsWorld* World, bool bMultithreaded, const FWorldSnapshot& Snapshot)
+	{
+		btCollisionObjectArray& Objects = World->getCollisionObjectArray();
+		for (int i = 0; i < Objects.size(); i++)
+		{
+			btRigidBody* Body = btRigidBody::upcast(Objects[i]);
+			if (!Body) continue;
+
+			const FWorldSnapshot::FBody& BodySnapshot = Snapshot.Bodies[i];
+			Body->setWorldTransform(BodySnapshot.WorldTransform);
+			Body->setInterpolationWorldTransform(BodySnapshot.WorldTransform);
+			Body->setLinearVelocity(BodySnapshot.LinearVelocity);
+			Body->setAngularVelocity(BodySnapshot.AngularVelocity);
+			Body->setInterpolationLinearVelocity(BodySnapshot.LinearVelocity);
+			Body->setInterpolationAngularVelocity(BodySnapshot.AngularVelocity);
+			Body->updateInertiaTensor();
+			Body->clearForces();
+			Body->applyCentralForce(BodySnapshot.TotalForce);
+			Body->applyTorque(BodySnapshot.TotalTorque);
+			Body->forceActivationState(BodySnapshot.ActivationState);
+			Body->setDeactivationTime(BodySnapshot.DeactivationTime);
+			if (Body->getMotionState())
+			{
+				Body->getMotionState()->setWorldTransform(BodySnapshot.WorldTransform);
+			}
+			FBulletWorldParts::VisitWorld(World, bMultithreaded, [Body](auto& W) { W.UpdateSingleAabb(Body); });
+		}
+
+		std::vector<btCollisionObject*> PairObjects(Snapshot.PairObjects.size());
+		for (size_t i = 0; i < PairObjects.size(); i++)
+		{
+			PairObjects[i] = Objects[Snapshot.PairObjects[i]];
+		}
+		FBulletWorldParts::VisitWorld(World, bMultithreaded, [&Snapshot, &PairObjects](auto& W)
+		{
+			W.SetLocalTime(Snapshot.LocalTime);
+			W.RestoreCollisionPairs(PairObjects.data(), (int)PairObjects.size() / 2);
+		});
+
+		// Every pair has fresh contact caches now, each takes the next one the snapshot has for its pair
+		std::vector<bool> Used(Snapshot.Manifolds.size(), false);
+		btDispatcher* Dispatcher = World->getDispatcher();
+		for (int i = 0; i < Dispatcher->getNumManifolds(); i++)
+		{
+			btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+			const int Body0 = GetObjectIndex(Manifold->getBody0());
+			const int Body1 = GetObjectIndex(Manifold->getBody1());
+			bool bRestored = false;
+			for (size_t m = 0; m < Snapshot.Manifolds.size() && !bRestored; m++)
+			{
+				const FWorldSnapshot::FManifold& ManifoldSnapshot = Snapshot.Manifolds[m];
+				if (Used[m] || ManifoldSnapshot.Body0 != Body0 || ManifoldSnapshot.Body1 != Body1) continue;
+
+				Used[m] = true;
+				bRestored = true;
+				for (int p = 0; p < ManifoldSnapshot.NumContacts; p++)
+				{
+					Manifold->getContactPoint(p) = Snapshot.ManifoldPoints[ManifoldSnapshot.FirstPoint + p];
+				}
+				Manifold->setNumContacts(ManifoldSnapshot.NumContacts);
+			}
+			if (!bRestored)
+			{
+				Manifold->clearManifold();
+			}
+		}
+	}
+
+	// FNV-1a over the exact bits of every body's state, a resim has to reproduce them, not just come close
+	uint64_t HashWorld(btDiscreteDynamicsWorld* World)
+	{
+		uint64_t Hash = 14695981039346656037ull;
+		auto Mix = [&Hash](const void* Data, size_t Size)
+		{
+			const unsigned char* Bytes = static_cast<const unsigned char*>(Data);
+			for (size_t i = 0; i < Size; i++)
+			{
+				Hash = (Hash ^ Bytes[i]) * 1099511628211ull;
+			}
+		};
+
+		const btCollisionObjectArray& Objects = World->getCollisionObjectArray();
+		for (int i = 0; i < Objects.size(); i++)
+		{
+			const btRigidBody* Body = btRigidBody::upcast(Objects[i]);
+			if (!Body || Body->isStaticOrKinematicObject()) continue;
+
+			const btTransform& Transform = Body->getWorldTransform();
+			for (int Row = 0; Row < 3; Row++)
+			{
+				Mix(&Transform.getBasis()[Row][0], sizeof(btScalar) * 3);
+			}
+			Mix(&Transform.getOrigin()[0], sizeof(btScalar) * 3);
+			Mix(&Body->getLinearVelocity()[0], sizeof(btScalar) * 3);
+			Mix(&Body->getAngularVelocity()[0], sizeof(btScalar) * 3);
+			const int ActivationState = Body->getActivationState();
+			Mix(&ActivationState, sizeof(ActivationState));
+		}
+		return Hash;
+	}
+
+	double Percentile(std::vector<double> Values, double Fraction)
+	{
+		if (Values.empty()) return 0;
+		const size_t Index = std::min(Values.size() - 1, (size_t)(Fraction * (Values.size() - 1) + 0.5));
+		std::nth_element(Values.begin(), Values.begin() + Index, Values.end());
+		return Values[Index];
+	}
+
+	template <typename Getter>
+	void PrintIntStats(const char* Name, const std::vector<FStepSample>& Samples, Getter Get)
+	{
+		long long Sum = 0;
+		int Max = 0;
+		for (const FStepSample& Sample : Samples)
+		{
+			Sum += Get(Sample);
+			Max = std::max(Max, Get(Sample));
+		}
+		printf(", \"%s\": {\"mean\": %.1f, \"max\": %d, \"last\": %d}", Name, Samples.empty() ? 0.0 : (double)Sum / Samples.size(), Max, Samples.empty() ? 0 : Get(Samples.back()));
+	}
+
+	// Peak is what the pool would have needed to hold everything, the same as the subsystem's pool stats
+	template <typename Getter>
+	void PrintPoolStats(const char* Name, int Capacity, const std::vector<FStepSample>& Samples, Getter Get)
+	{
+		int Peak = 0;
+		int PeakOverflow = 0;
+		for (const FStepSample& Sample : Samples)
+		{
+			Peak = std::max(Peak, Get(Sample).Used + Get(Sample).Overflow);
+			PeakOverflow = std::max(PeakOverflow, Get(Sample).Overflow);
+		}
+		printf(", \"%s\": {\"capacity\": %d, \"peak\": %d, \"peak_overflow\": %d}", Name, Capacity, Peak, PeakOverflow);
+	}
+
+	// @return false when --verify-determinism found the resim diverging
+	bool RunScene(int SceneIndex, const FBenchmarkOptions& Options, FILE* Csv)
+	{
+		const FSceneInfo& Info = Scenes[SceneIndex];
+		const btScalar TimeStep = btScalar(1.) / btScalar(60.);
+
+		// Same construction and tunables as the subsystem, gravity and solver settings are the demo's
+		btDefaultCollisionConstructionInfo ConstructionInfo;
+		ConstructionInfo.m_defaultMaxPersistentManifoldPoolSize = Options.ManifoldPoolSize;
+		ConstructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = Options.AlgorithmPoolSize;
+		FBulletWorldParts Parts = FBulletWorldParts::Create(Options.NumThreads > 0, Options.NumThreads, ConstructionInfo);
+		FBulletWorldTunables Tunables;
+		Tunables.bDeterministic = Options.bDeterministic;
+		Parts.SetTunables(Tunables);
+
+		FBenchmarkScene Scene;
+		Scene.World = Parts.World;
+		Scene.World->getSolverInfo().m_solverMode |= SOLVER_ENABLE_FRICTION_DIRECTION_CACHING;
+		Scene.World->getSolverInfo().m_numIterations = 5;
+		Scene.World->setGravity(btVector3(0, -10, 0));
+
+		const FClock::time_point SetupStart = FClock::now();
+		if (Info.bGroundBox)
+		{
+			btTransform GroundTransform = btTransform::getIdentity();
+			GroundTransform.setOrigin(btVector3(0, -50, 0));
+			Scene.CreateRigidBody(0, GroundTransform, Scene.AddShape(new btBoxShape(btVector3(250, 50, 250))));
+		}
+		Info.Create(Scene);
+		const double SetupMs = MillisecondsSince(SetupStart);
+
+		std::vector<FStepSample> Samples;
+		Samples.reserve(Options.Steps);
+		std::map<std::string, double> ZoneTotalMs;
+
+		FWorldSnapshot Snapshot;
+		std::vector<uint64_t> StepHashes;
+
+		for (int Step = 0; Step < Options.WarmupSteps + Options.Steps; Step++)
+		{
+			if (Options.bVerifyDeterminism && Step == Options.WarmupSteps)
+			{
+				RecordWorldSnapshot(Scene.World, Parts.bMultithreaded, Snapshot);
+			}
+
+			StepZoneMs.clear();
+
+			const FClock::time_point StepStart = FClock::now();
+			Scene.World->stepSimulation(TimeStep, 1, TimeStep);
+			if (Scene.bCastRays)
+			{
+				CastRays(Scene, TimeStep);
+			}
+			const double StepMs = MillisecondsSince(StepStart);
+
+			if (Step < Options.WarmupSteps) continue;
+
+			FStepSample Sample = SampleWorld(Scene.World, Parts.bMultithreaded);
+			Sample.Ms = StepMs;
+			Samples.push_back(Sample);
+			if (Options.bVerifyDeterminism)
+			{
+				StepHashes.push_back(HashWorld(Scene.World));
+			}
+			for (const auto& Zone : StepZoneMs)
+			{
+				ZoneTotalMs[Zone.first] += Zone.second;
+			}
+
+			if (Csv)
+			{
+				fprintf(Csv, "%d,%d,%d,%.4f,%d,%d,%d,%d\n", SceneIndex + 1, Options.NumThreads, Step - Options.WarmupSteps, StepMs, Sample.Pairs, Sample.Manifolds, Sample.Contacts, Sample.ActiveBodies);
+			}
+		}
+
+		std::vector<double> StepTimes;
+		StepTimes.reserve(Samples.size());
+		double TotalMs = 0;
+		for (const FStepSample& Sample : Samples)
+		{
+			StepTimes.push_back(Sample.Ms);
+			TotalMs += Sample.Ms;
+		}
+		const double NumSamples = Samples.empty() ? 1 : (double)Samples.size();
+
+		// Rewound like a rollback and stepped again, outside the timings. Rays only read the world so they're left out
+		int FirstMismatch = -1;
+		if (Options.bVerifyDeterminism)
+		{
+			RestoreWorldSnapshot(Scene.World, Parts.bMultithreaded, Snapshot);
+			for (int Step = 0; Step < Options.Steps && FirstMismatch < 0; Step++)
+			{
+				Scene.World->stepSimulation(TimeStep, 1, TimeStep);
+				if (HashWorld(Scene.World) != StepHashes[Step])
+				{
+					FirstMismatch = Step;
+				}
+			}
+		}
+
+		printf("{\"scene\": %d, \"name\": \"%s\", \"precision\": \"%s\", \"threads\": %d, \"deterministic\": %s, \"bodies\": %d, \"constraints\": %d, \"steps\": %d, \"setup_ms\": %.3f",
+			SceneIndex + 1, Info.Name, sizeof(btScalar) == sizeof(double) ? "double" : "float", Options.NumThreads, Options.bDeterministic ? "true" : "false",
+			Scene.World->getNumCollisionObjects(), Scene.World->getNumConstraints(), (int)Samples.size(), SetupMs);
+		printf(", \"step_ms\": {\"total\": %.3f, \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+			TotalMs, TotalMs / NumSamples, Percentile(StepTimes, 0), Percentile(StepTimes, 0.5), Percentile(StepTimes, 0.95), Percentile(StepTimes, 0.99), Percentile(StepTimes, 1));
+
+		// Inclusive, so nested zones are also counted in the ones around them
+		printf(", \"phase_ms_per_step\": {");
+		const char* Separator = "";
+		for (const auto& Zone : ZoneTotalMs)
+		{
+			printf("%s\"%s\": %.4f", Separator, Zone.first.c_str(), Zone.second / NumSamples);
+			Separator = ", ";
+		}
+		printf("}");
+
+		PrintIntStats("pairs", Samples, [](const FStepSample& Sample) { return Sample.Pairs; });
+		PrintIntStats("manifolds", Samples, [](const FStepSample& Sample) { return Sample.Manifolds; });
+		PrintIntStats("contacts", Samples, [](const FStepSample& Sample) { return Sample.Contacts; });
+		PrintIntStats("active_bodies", Samples, [](const FStepSample& Sample) { return Sample.ActiveBodies; });
+		PrintPoolStats("manifold_pool", Options.ManifoldPoolSize, Samples, [](const FStepSample& Sample) { return Sample.ManifoldPool; });
+		PrintPoolStats("algorithm_pool", Options.AlgorithmPoolSize, Samples, [](const FStepSample& Sample) { return Sample.AlgorithmPool; });
+		if (Options.bVerifyDeterminism)
+		{
+			printf(", \"determinism\": {\"resim_steps\": %d, \"first_mismatch\": %d, \"final_hash\": \"%016llx\"}",
+				Options.Steps, FirstMismatch, StepHashes.empty() ? 0ull : (unsigned long long)StepHashes.back());
+		}
+		printf("}\n");
+		fflush(stdout);
+
+		Scene.Clear();
+		Parts.Destroy();
+		return FirstMismatch < 0;
+	}
+
+	bool ParseOptions(int Argc, char** Argv, FBenchmarkOptions& Options)
+	{
+		for (int i = 1; i < Argc; i++)
+		{
+			const bool bHasValue = i + 1 < Argc;
+			if (!strcmp(Argv[i], "--scene") && bHasValue)
+			{
+				++i;
+				Options.Scene = !strcmp(Argv[i], "all") ? 0 : atoi(Argv[i]);
+				if (Options.Scene < 0 || Options.Scene > NumScenes) return false;
+			}
+			else if (!strcmp(Argv[i], "--steps") && bHasValue)
+			{
+				Options.Steps = std::max(atoi(Argv[++i]), 1);
+			}
+			else if (!strcmp(Argv[i], "--warmup") && bHasValue)
+			{
+				Options.WarmupSteps = std::max(atoi(Argv[++i]), 0);
+			}
+			else if (!strcmp(Argv[i], "--threads") && bHasValue)
+			{
+				Options.NumThreads = std::min(std::max(atoi(Argv[++i]), 0), (int)BT_MAX_THREAD_COUNT);
+			}
+			else if (!strcmp(Argv[i], "--manifold-pool") && bHasValue)
+			{
+				Options.ManifoldPoolSize = std::max(atoi(Argv[++i]), 1);
+			}
+			else if (!strcmp(Argv[i], "--algorithm-pool") && bHasValue)
+			{
+				Options.AlgorithmPoolSize = std::max(atoi(Argv[++i]), 1);
+			}
+			else if (!strcmp(Argv[i], "--deterministic"))
+			{
+				Options.bDeterministic = true;
+			}
+			else if (!strcmp(Argv[i], "--verify-determinism"))
+			{
+				// Only deterministic worlds promise to replay a frame the same way
+				Options.bDeterministic = true;
+				Options.bVerifyDeterminism = true;
+			}
+			else if (!strcmp(Argv[i], "--csv") && bHasValue)
+			{
+				Options.CsvPath = Argv[++i];
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	FBenchmarkOptions Options;
+	if (!ParseOptions(Argc, Argv, Options))
+	{
+		fprintf(stderr, "Usage: %s [--scene 1..%d|all] [--steps N] [--warmup N] [--threads N] [--manifold-pool N] [--algorithm-pool N] [--deterministic] [--verify-determinism] [--csv File]\n", Argv[0], NumScenes);
+		return 1;
+	}
+
+	FILE* Csv = nullptr;
+	if (Options.CsvPath)
+	{
+		Csv = fopen(Options.CsvPath, "w");
+		if (!Csv)
+		{
+			fprintf(stderr, "Can't write %s\n", Options.CsvPath);
+			return 1;
+		}
+		fprintf(Csv, "scene,threads,step,step_ms,pairs,manifolds,contacts,active_bodies\n");
+	}
+
+	// The Mt world needs the scheduler in place before it's built, as the subsystem does with FBulletTaskScheduler.
+	// Single threaded runs still get the sequential one, btParallelFor has nothing to run on otherwise
+	btSetTaskScheduler(btGetSequentialTaskScheduler());
+	btITaskScheduler* Scheduler = nullptr;
+	if (Options.NumThreads > 0)
+	{
+		Scheduler = btCreateDefaultTaskScheduler();
+		if (!Scheduler)
+		{
+			fprintf(stderr, "This bullet build has no default task scheduler\n");
+			return 1;
+		}
+		// The default scheduler won't go past the machine's core count, so report what the world really got
+		Options.NumThreads = std::min(Options.NumThreads, Scheduler->getMaxNumThreads());
+		Scheduler->setNumThreads(Options.NumThreads);
+		btSetTaskScheduler(Scheduler);
+	}
+
+	bIsSteppingThread = true;
+	btSetCustomEnterProfileZoneFunc(EnterZone);
+	btSetCustomLeaveProfileZoneFunc(LeaveZone);
+
+	bool bDeterministicRuns = true;
+	for (int SceneIndex = 0; SceneIndex < NumScenes; SceneIndex++)
+	{
+		if (Options.Scene == 0 || Options.Scene == SceneIndex + 1)
+		{
+			bDeterministicRuns &= RunScene(SceneIndex, Options, Csv);
+		}
+	}
+
+	if (Csv)
+	{
+		fclose(Csv);
+	}
+	if (Scheduler)
+	{
+		btSetTaskScheduler(btGetSequentialTaskScheduler());
+		delete Scheduler;
+	}
+	return bDeterministicRuns ? 0 : 2;
+}
@@ -0,0 +1,16 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Stands in for the engine's CoreMinimal.h when the plugin's pure bullet headers are built on their own, as in the headless benchmark.
+// Only the macros those headers wrap bullet's includes in are needed.
+
+#ifndef THIRD_PARTY_INCLUDES_START
+#define THIRD_PARTY_INCLUDES_START
+#define THIRD_PARTY_INCLUDES_END
+#endif
+
+#ifndef PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#define PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#define PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+#endif
@@ -11,23 +11,47 @@ using UnrealBuildTool;
 
 public class BulletPhysicsEngineLibrary : ModuleRules
 {
+	// Builds and links bullet with doubles for btScalar. Set to false (or set BULLET_DOUBLE_PRECISION=0 in the environment)
+	// for the float build, which gets the SSE/NEON btVector3 paths and roughly halves the size of the hot bullet structures.
+	// Float and double libraries are built into separate directories, so switching back and forth doesn't rebuild everything.
+	private static bool bDefaultDoublePrecision = true;
 
-	private bool BuildBullet(string BuildType)
+	private bool UseDoublePrecision()
+	{
+		string Override = System.Environment.GetEnvironmentVariable("BULLET_DOUBLE_PRECISION");
+		if (!String.IsNullOrEmpty(Override))
+		{
+			return Override != "0";
+		}
+		return bDefaultDoublePrecision;
+	}
+
+	// VHACD only backs the editor's convex decomposition cooker, so game builds don't build or link it
+	private string[] GetLibraryNames()
+	{
+		if (Target.bBuildEditor)
+		{
+			return new string[] { "BulletCollision", "BulletDynamics", "LinearMath", "VHACD" };
+		}
+		return new string[] { "BulletCollision", "BulletDynamics", "LinearMath" };
+	}
+
+	private bool BuildBullet(string BuildType, bool bDoublePrecision)
 	{
 
 		string ThirdPartyBulletPath = Path.Combine(ModuleDirectory, "bullet3");
 		string ModulePath = Path.Combine( ModuleDirectory, "bullet3");
-		string BulletBuildDir = BuildUtils.GetBulletBuildDir(ModuleDirectory, Target.Platform);
+		string BulletBuildDir = BuildUtils.GetBulletBuildDir(ModuleDirectory, Target.Platform, bDoublePrecision);
 		string LibOutputPath = Path.Combine(BulletBuildDir, BuildUtils.GetBuildType(BuildType));
 
 
 		System.Console.WriteLine("Bullet thirdparty directory: " + ThirdPartyBulletPath);
 
 		var cmakeOptions = "";
-		cmakeOptions += " -DUSE_DOUBLE_PRECISION=1 "; 
-		//Don't forget to take out the definition
-		// #define BT_USE_DOUBLE_PRECISION in BulletMain.h if you disable DOUBLE_PRECISION
-		// TODO: Too lazy to add it as a definition here.
+		// Must match the BT_USE_DOUBLE_PRECISION definition below
+		cmakeOptions += " -DUSE_DOUBLE_PRECISION=" + (bDoublePrecision ? "1" : "0") + " "; 
+		// Thread safe build, needed for the Mt world classes to actually run in parallel. Must match BT_THREADSAFE below
+		cmakeOptions += " -DBULLET2_MULTITHREADING=1 "; 
 		cmakeOptions += " -DINSTALL_LIBS=0 "; 
 		cmakeOptions += " -DINSTALL_EXTRA_LIBS=0 "; 
 		cmakeOptions += " -DLIBRARY_OUTPUT_PATH=\""+LibOutputPath + "\""; 
@@ -72,8 +96,7 @@ public class BulletPhysicsEngineLibrary : ModuleRules
 		buildCommand += BuildUtils.GetCMakeExe() + " ";
 		buildCommand += " --build \"" + BulletBuildDir + "\" ";
 		buildCommand += " --target ";
-		string[] libraryNames = { "BulletCollision", "BulletDynamics", "LinearMath" };
-		foreach (string libraryName in libraryNames)
+		foreach (string libraryName in GetLibraryNames())
 		{
 			buildCommand += "" + libraryName + " ";
 		}
@@ -100,6 +123,7 @@ public class BulletPhysicsEngineLibrary : ModuleRules
 
 		bool bDebug = Target.Configuration == UnrealTargetConfiguration.Debug || Target.Configuration == UnrealTargetConfiguration.DebugGame;
 		bool bDevelopment = Target.Configuration == UnrealTargetConfiguration.Development;
+		bool bDoublePrecision = UseDoublePrecision();
 
 		string BuildFolder="";
 		string BuildSuffix="";
@@ -108,13 +132,13 @@ public class BulletPhysicsEngineLibrary : ModuleRules
 		{
 			BuildFolder = "Debug";
 			BuildSuffix = "_Debug";
-			BuildBullet("Debug");
+			BuildBullet("Debug", bDoublePrecision);
 		}
 		else if (bDevelopment)
 		{
 			BuildSuffix = "_RelWithDebInfo";
 			BuildFolder = "RelWithDebInfo";
-			BuildBullet("Development");
+			BuildBullet("Development", bDoublePrecision);
 			if (Target.Platform == UnrealTargetPlatform.Win64)
 			{
 				//FIXME: I don't know, maybe...
@@ -126,27 +150,23 @@ public class BulletPhysicsEngineLibrary : ModuleRules
 		{
 			BuildFolder = "Release";
 			BuildSuffix = "";
-			BuildBullet("Release");
+			BuildBullet("Release", bDoublePrecision);
 		}
 
-		string BuildPlatForm = "Win64";
 		string LibExtension = ".lib";
 		string BuildPrefix = "";
 
 		if (Target.Platform == UnrealTargetPlatform.Linux)
 		{
-			BuildPlatForm = "Linux";
 			LibExtension = ".a";
 			BuildPrefix = "lib";
 			BuildSuffix = "";
 		}
 
 		// Library path
-		string LibrariesPath = Path.Combine(ModuleDirectory, "lib", BuildPlatForm, BuildFolder);
+		string LibrariesPath = Path.Combine(BuildUtils.GetBulletBuildDir(ModuleDirectory, Target.Platform, bDoublePrecision), BuildFolder);
 
-		string[] libraryNames = { "BulletCollision", "BulletDynamics", "LinearMath" };
-
-		foreach (string libraryName in libraryNames)
+		foreach (string libraryName in GetLibraryNames())
 		{
 			PublicAdditionalLibraries.Add(Path.Combine(LibrariesPath, BuildPrefix + libraryName + BuildSuffix + LibExtension));
 		}
@@ -154,6 +174,18 @@ public class BulletPhysicsEngineLibrary : ModuleRules
 		// Include path (I'm just using the source here since Bullet has mixed src & headers)
 		PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "bullet3/src"));
 		PublicDefinitions.Add("WITH_BULLET_BINDING=1");
+		if (Target.bBuildEditor)
+		{
+			PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "bullet3/Extras/VHACD/public"));
+		}
+		PublicDefinitions.Add("WITH_BULLET_VHACD=" + (Target.bBuildEditor ? "1" : "0"));
+		// Bullet's headers change behaviour (mutexes, btParallelFor) with this, so everything including them has to agree with the libraries
+		PublicDefinitions.Add("BT_THREADSAFE=1");
+		// Bullet's value types change size with this, so it has to reach everything that includes bullet headers, not just the libraries
+		if (bDoublePrecision)
+		{
+			PublicDefinitions.Add("BT_USE_DOUBLE_PRECISION=1");
+		}
 
 	}
 }
@@ -240,20 +272,22 @@ public class BuildUtils
 		return program;
 	}
 
-	public static string GetBulletBuildDir(string ModuleDirectory, UnrealBuildTool.UnrealTargetPlatform Platform)
+	public static string GetBulletBuildDir(string ModuleDirectory, UnrealBuildTool.UnrealTargetPlatform Platform, bool bDoublePrecision)
 	{
+		// The double build keeps the original location so existing builds are picked up
+		string PrecisionSuffix = bDoublePrecision ? "" : "_Float";
 
 		if (Platform == UnrealTargetPlatform.Win64)
 		{
-			return Path.Combine(ModuleDirectory, "lib", "Win64");
+			return Path.Combine(ModuleDirectory, "lib", "Win64" + PrecisionSuffix);
 		}
 		else if (Platform == UnrealTargetPlatform.Mac)
 		{
-			return Path.Combine(ModuleDirectory, "lib", "Mac");
+			return Path.Combine(ModuleDirectory, "lib", "Mac" + PrecisionSuffix);
 		}
 		else if (Platform == UnrealTargetPlatform.Linux)
 		{
-			return Path.Combine(ModuleDirectory, "lib", "Linux");
+			return Path.Combine(ModuleDirectory, "lib", "Linux" + PrecisionSuffix);
 		}
 		return "invalid platform";
 	}